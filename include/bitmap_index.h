@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "roaring_bitmap.h"
+#include "snapshot_io.h"
+
+// value -> rows index over one low-cardinality column: one roaring bitmap of
+// row numbers per distinct value, so an equality or IN clause is a lookup
+// and an OR instead of a scan.
+class BitmapIndex {
+
+public:
+    BitmapIndex() = default;
+
+    // Rows are visited in order, so every bitmap is built by appending.
+    template <typename Range, typename Proj>
+    static BitmapIndex Build(const Range& rows, Proj valueOf)
+    {
+        std::map<std::int32_t, RoaringBitmap> bitmaps;
+        std::uint32_t row = 0;
+        for (const auto& item : rows) bitmaps[static_cast<std::int32_t>(valueOf(item))].Add(row++);
+
+        BitmapIndex index;
+        for (auto& [value, bitmap] : bitmaps)
+        {
+            index.m_values.push_back(value);
+            index.m_bitmaps.push_back(std::move(bitmap));
+        }
+        return index;
+    }
+
+    // Rows whose value is `value`; empty when no row has it.
+    const RoaringBitmap& Equal(std::int32_t value) const
+    {
+        auto it = std::ranges::lower_bound(m_values, value);
+        if (it == m_values.end() || *it != value) return EMPTY;
+
+        return m_bitmaps[static_cast<std::size_t>(it - m_values.begin())];
+    }
+
+    // Rows whose value is any of `values`.
+    RoaringBitmap In(std::span<const std::int32_t> values) const
+    {
+        std::vector<const RoaringBitmap*> parts;
+        for (auto value : values) parts.push_back(&Equal(value));
+        return RoaringBitmap::unite(parts);
+    }
+
+    // Distinct values, ascending.
+    std::span<const std::int32_t> Values() const { return m_values; }
+
+    std::size_t ByteSize() const
+    {
+        std::size_t bytes = m_values.size() * sizeof(std::int32_t);
+        for (const auto& bitmap : m_bitmaps) bytes += bitmap.ByteSize();
+        return bytes;
+    }
+
+    void Save(SnapshotWriter& out) const
+    {
+        out.Write(m_values);
+        for (const auto& bitmap : m_bitmaps) bitmap.Save(out);
+    }
+
+    static BitmapIndex Load(SnapshotReader& in)
+    {
+        BitmapIndex index;
+        index.m_values = in.ReadVector<std::int32_t>();
+        if (!std::ranges::is_sorted(index.m_values)) throw std::runtime_error("Snapshot bitmap index is corrupt.");
+
+        index.m_bitmaps.reserve(index.m_values.size());
+        for (std::size_t i = 0; i < index.m_values.size(); ++i) index.m_bitmaps.push_back(RoaringBitmap::Load(in));
+        return index;
+    }
+
+private:
+    inline static const RoaringBitmap EMPTY{};
+
+    std::vector<std::int32_t> m_values;
+    std::vector<RoaringBitmap> m_bitmaps;
+
+};
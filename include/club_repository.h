@@ -5,19 +5,27 @@
 #include <filesystem> 
 
 #include "club.h"
+#include "id_index.h"
+#include "lru_cache.h"
+#include "trigram_index.h"
 
 class ClubRepository {
 
 public: 
-    explicit ClubRepository(const std::filesystem::path& tableName);
+    explicit ClubRepository(const std::filesystem::path& tableName, std::size_t searchCacheBytes = DEFAULT_SEARCH_CACHE_BYTES);
 
     std::optional<Club> GetById(int id) const; 
     std::optional<Club> GetByName(const std::string& name) const; 
 
     std::optional<std::vector<Club>> SearchByName(const std::string& name) const;
 
+    CacheStats SearchCacheStats() const { return m_searchCache.Stats(); }
+
 private: 
     std::filesystem::path m_tablePath; 
     std::vector<Club> m_clubs;
+    IdIndex m_ids;
+    TrigramIndex m_nameIndex;
+    mutable ShardedLruCache<std::string, std::vector<std::uint32_t>> m_searchCache;
 
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "snapshot_io.h"
+
+// Compressed sparse row adjacency: key k owns
+// Targets()[offsets[k] .. offsets[k + 1]). Built with one counting pass, so
+// targets of a key keep the order in which their edges were added.
+template <typename Target>
+class CsrIndex {
+
+public: 
+    CsrIndex() = default;
+
+    // Edges with a key outside [0, keyCount) are ignored.
+    CsrIndex(std::size_t keyCount, std::span<const std::pair<std::int64_t, Target>> edges)
+        : m_offsets(keyCount + 1, 0)
+    {
+        for (const auto& [key, target] : edges)
+            if (InRange(key)) ++m_offsets[static_cast<std::size_t>(key) + 1];
+
+        for (std::size_t k = 0; k < keyCount; ++k) m_offsets[k + 1] += m_offsets[k];
+
+        m_targets.resize(m_offsets[keyCount]);
+        std::vector<std::uint32_t> cursor(m_offsets.begin(), m_offsets.end() - 1);
+        for (const auto& [key, target] : edges)
+            if (InRange(key)) m_targets[cursor[static_cast<std::size_t>(key)]++] = target;
+    }
+
+    std::span<const Target> Get(std::int64_t key) const 
+    {
+        if (!InRange(key)) return {};
+
+        const auto k = static_cast<std::size_t>(key);
+        return std::span<const Target>(m_targets).subspan(m_offsets[k], m_offsets[k + 1] - m_offsets[k]);
+    }
+
+    std::size_t KeyCount() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+    std::size_t EdgeCount() const { return m_targets.size(); }
+
+    std::span<const std::uint32_t> Offsets() const { return m_offsets; }
+    std::span<const Target> Targets() const { return m_targets; }
+
+    void Save(SnapshotWriter& out) const 
+    {
+        out.Write(m_offsets);
+        out.Write(m_targets);
+    }
+
+    static CsrIndex Load(SnapshotReader& in)
+    {
+        CsrIndex index;
+        index.m_offsets = in.ReadVector<std::uint32_t>();
+        index.m_targets = in.ReadVector<Target>();
+        if (!index.m_offsets.empty() && index.m_offsets.back() != index.m_targets.size())
+            throw std::runtime_error("Snapshot CSR index is corrupt.");
+        return index;
+    }
+
+private: 
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<Target> m_targets;
+
+    bool InRange(std::int64_t key) const 
+    {
+        return key >= 0 && static_cast<std::size_t>(key) + 1 < m_offsets.size();
+    }
+
+};
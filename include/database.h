@@ -0,0 +1,190 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "club.h"
+#include "first_name.h"
+#include "fuzzy_index.h"
+#include "index.h"
+#include "lru_cache.h"
+#include "mapped_file.h"
+#include "name_cache.h"
+#include "non_player.h"
+#include "player.h"
+#include "reference_index.h"
+#include "repository.h"
+#include "second_name.h"
+#include "secondary_indexes.h"
+#include "staff.h"
+#include "staff_dates.h"
+#include "staff_join.h"
+#include "staff_names.h"
+
+struct DatabaseOptions {
+    LoadMode mode = LoadMode::Mapped;
+    std::size_t threads = 0;                 // 0 = hardware concurrency
+    std::string indexFile = "index.dat";
+    std::size_t searchCacheBytes = DEFAULT_SEARCH_CACHE_BYTES;  // per name index, see SearchStaffNames
+};
+
+// One staff member with both halves of the staff.dat join resolved; player,
+// nonPlayer and playerRow are null when the staff member has no such record.
+struct StaffView {
+    const Staff* staff;
+    const Player* player;
+    const NonPlayer* nonPlayer;
+    const PlayerRow* playerRow;
+};
+
+// Every table of a CM data directory, loaded once and immutable afterwards, so
+// one handle can be shared freely between threads.
+class Database {
+
+public: 
+    // Reads index.dat, then loads club.dat, the staff.dat blocks and the name
+    // tables in parallel.
+    static std::shared_ptr<const Database> Load(const std::filesystem::path& dataDir,
+                                                const DatabaseOptions& options = {});
+
+    // Serializes the tables and every derived index into one file that
+    // LoadSnapshot maps and uses directly.
+    void SaveSnapshot(const std::filesystem::path& file) const;
+
+    // nullptr when the snapshot is missing, corrupt, or was built from .dat
+    // files whose size or modification time has changed since.
+    static std::shared_ptr<const Database> LoadSnapshot(const std::filesystem::path& file,
+                                                        const std::filesystem::path& dataDir,
+                                                        const DatabaseOptions& options = {});
+
+    // Warm start from `snapshot` while it is valid, otherwise Load and try to
+    // rewrite it; a snapshot that cannot be written is only warned about.
+    static std::shared_ptr<const Database> Open(const std::filesystem::path& dataDir,
+                                                const std::filesystem::path& snapshot,
+                                                const DatabaseOptions& options = {});
+
+    const std::filesystem::path& DataDir() const { return m_dataDir; }
+
+    const Repository<Index>& Indexes() const { return m_indexes; }
+    const Repository<Club>& Clubs() const { return m_clubs; }
+    const Repository<Staff>& Staffs() const { return m_staffs; }
+    const Repository<NonPlayer>& NonPlayers() const { return m_nonPlayers; }
+    const Repository<Player>& Players() const { return m_players; }
+    const Repository<FirstName>& FirstNames() const { return m_firstNames; }
+    const Repository<SecondName>& SecondNames() const { return m_secondNames; }
+    const Repository<CommonName>* CommonNames() const { return m_commonNames ? &*m_commonNames : nullptr; }
+
+    // The staff preferences block (type 22) has no record layout yet, so it is kept as raw bytes.
+    std::span<const std::byte> StaffPreferences() const { return m_staffPreferences; }
+
+    // First index.dat entry for `fileName`, optionally of one block type.
+    std::optional<Index> FindIndex(std::string_view fileName, std::optional<std::uint32_t> type = std::nullopt) const;
+
+    // Interned name tables and the precomputed display name of every staff member.
+    const NameTable& FirstNameTable() const { return m_firstNameTable; }
+    const NameTable& SecondNameTable() const { return m_secondNameTable; }
+    const NameTable& CommonNameTable() const { return m_commonNameTable; }
+    const StaffNameCache& StaffNames() const { return m_staffNames; }
+
+    std::string_view StaffName(const Staff& staff) const { return m_staffNames.GetById(staff.id); }
+
+    // Staff rows joined to their Player / NonPlayer rows, plus compact player rows for search.
+    const StaffJoin& Joined() const { return m_staffJoin; }
+
+    std::optional<StaffView> FindStaffView(std::int32_t staffId) const 
+    {
+        auto row = m_staffs.RowOf(staffId);
+        if (!row.has_value()) return std::nullopt;
+
+        return StaffViewOfRow(*row);
+    }
+
+    StaffView StaffViewOfRow(std::size_t staffRow) const;
+
+    // Every staff date as a day-number column, for age and contract filters.
+    const StaffDateColumns& StaffDates() const { return m_staffDates; }
+
+    // Accent- and typo-tolerant word indexes. Staff documents are staff rows
+    // (first, second and common name); club documents are club rows (short and long name).
+    const FuzzyIndex& StaffNameIndex() const { return m_staffNameIndex; }
+    const FuzzyIndex& ClubNameIndex() const { return m_clubNameIndex; }
+
+    // Search on the name indexes through a result cache keyed by the query's
+    // folded words and the limit, so "Müller" and "muller" share an entry.
+    // Safe to call from many threads.
+    std::shared_ptr<const std::vector<FuzzyMatch>> SearchStaffNames(std::string_view query, std::size_t limit) const;
+    std::shared_ptr<const std::vector<FuzzyMatch>> SearchClubNames(std::string_view query, std::size_t limit) const;
+
+    // Both search caches together.
+    CacheStats SearchCacheStats() const;
+
+    // staff -> club, nation -> clubs, division -> clubs, club -> staff and nation -> staff adjacency.
+    const ReferenceIndex& References() const { return m_references; }
+
+    // Roaring bitmaps over nation, classification, job, squad, natural position
+    // and division; sorted range indexes over value, wage, ability and reputation.
+    const SecondaryIndexes& Secondary() const { return m_secondary; }
+
+private: 
+    // Everything a Database is made of, gathered by Load or LoadSnapshot before construction.
+    struct Tables {
+        std::filesystem::path dataDir;
+        std::shared_ptr<const MappedFile> backingFile;
+        Repository<Index> indexes;
+        Repository<Club> clubs;
+        Repository<Staff> staffs;
+        Repository<NonPlayer> nonPlayers;
+        Repository<Player> players;
+        Repository<FirstName> firstNames;
+        Repository<SecondName> secondNames;
+        std::optional<Repository<CommonName>> commonNames;
+        std::span<const std::byte> staffPreferences;
+        NameTable firstNameTable;
+        NameTable secondNameTable;
+        NameTable commonNameTable;
+        StaffNameCache staffNames;
+        ReferenceIndex references;
+        StaffJoin staffJoin;
+        StaffDateColumns staffDates;
+        FuzzyIndex staffNameIndex;
+        FuzzyIndex clubNameIndex;
+        SecondaryIndexes secondary;
+        std::string sources;
+        std::size_t searchCacheBytes = DEFAULT_SEARCH_CACHE_BYTES;
+    };
+
+    explicit Database(Tables&& tables);
+
+    std::filesystem::path m_dataDir;
+    std::shared_ptr<const MappedFile> m_backingFile;    // staff.dat, or the snapshot it was restored from
+    Repository<Index> m_indexes;
+    Repository<Club> m_clubs;
+    Repository<Staff> m_staffs;
+    Repository<NonPlayer> m_nonPlayers;
+    Repository<Player> m_players;
+    Repository<FirstName> m_firstNames;
+    Repository<SecondName> m_secondNames;
+    std::optional<Repository<CommonName>> m_commonNames;
+    std::span<const std::byte> m_staffPreferences;
+    NameTable m_firstNameTable;
+    NameTable m_secondNameTable;
+    NameTable m_commonNameTable;
+    StaffNameCache m_staffNames;
+    ReferenceIndex m_references;
+    StaffJoin m_staffJoin;
+    StaffDateColumns m_staffDates;
+    FuzzyIndex m_staffNameIndex;
+    FuzzyIndex m_clubNameIndex;
+    SecondaryIndexes m_secondary;
+    std::string m_sources;                              // size/mtime fingerprint of the .dat files
+
+    using SearchCache = ShardedLruCache<std::string, std::vector<FuzzyMatch>>;
+    mutable SearchCache m_staffSearchCache;
+    mutable SearchCache m_clubSearchCache;
+
+    static std::string SourceFingerprint(const std::filesystem::path& dataDir, const DatabaseOptions& options);
+
+};
@@ -5,6 +5,7 @@
 #include <filesystem> 
 
 #include "first_name.h"
+#include "id_index.h"
 
 class FirstNameRepository {
 
@@ -16,5 +17,6 @@ public:
 private: 
     std::filesystem::path m_tablePath; 
     std::vector<FirstName> m_firstNames;
+    IdIndex m_ids;
 
 };
\ No newline at end of file
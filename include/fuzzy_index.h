@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "csr_index.h"
+
+struct FuzzyMatch {
+    std::uint32_t doc;
+    std::uint32_t distance;     // edits summed over the query's words
+};
+
+// Accent- and typo-tolerant word index: "muller", "Mueller" and "Mülller" all
+// find "Müller". Texts are folded (fold) and split into words; every distinct
+// word is kept once in a sorted term dictionary with a CSR posting list of its
+// documents. A query word is matched against the dictionary by walking it in
+// sorted order as an implicit trie: terms sharing a prefix share the rows of
+// the Levenshtein table, and a prefix whose row already exceeds the edit
+// budget skips every term below it. Cost grows with the number of distinct
+// words, not with the number of documents.
+class FuzzyIndex {
+
+public:
+    static constexpr std::size_t MAX_TERM_LENGTH = 64;
+
+    void Add(std::uint32_t doc, std::string_view text);
+
+    // Must be called once after the last Add and before searching.
+    void Finalize();
+
+    // Documents in which every word of `query` matches some word within its
+    // edit budget, best (fewest total edits, then lowest doc) first. The
+    // budget is default_max_edits of the word's length, capped by `maxEdits`.
+    std::vector<FuzzyMatch> Search(std::string_view query, std::size_t limit = 50,
+                                   std::optional<unsigned> maxEdits = std::nullopt) const;
+
+    // Dictionary terms within `maxEdits` of the folded word `term`, with their distance.
+    std::vector<std::pair<std::uint32_t, unsigned>> MatchTerms(std::string_view term, unsigned maxEdits) const;
+
+    std::string_view Term(std::size_t i) const
+    {
+        return std::string_view(m_terms).substr(m_termOffsets[i], m_termOffsets[i + 1] - m_termOffsets[i]);
+    }
+
+    std::size_t TermCount() const { return m_termOffsets.empty() ? 0 : m_termOffsets.size() - 1; }
+    std::size_t DocumentCount() const { return m_docCount; }
+
+    // Lower case ASCII with Windows-1252 / Latin-1 diacritics removed ("Ø" ->
+    // "o", "ß" -> "ss", "Œ" -> "oe"), apostrophes dropped ("O'Neill" ->
+    // "oneill"), and every other non-alphanumeric byte turned into a space.
+    static std::string fold(std::string_view text);
+
+    // Words of fold(text), in order.
+    static std::vector<std::string> words(std::string_view text);
+
+    // 0 edits up to 2 characters, 1 up to 5, then 2.
+    static unsigned default_max_edits(std::size_t length);
+
+    static unsigned edit_distance(std::string_view a, std::string_view b);
+
+    void Save(SnapshotWriter& out) const;
+    static FuzzyIndex Load(SnapshotReader& in);
+
+private:
+    std::vector<std::pair<std::string, std::uint32_t>> m_pending;   // (word, doc) until Finalize
+
+    std::string m_terms;                        // sorted distinct words back to back
+    std::vector<std::uint32_t> m_termOffsets;   // TermCount() + 1 entries
+    CsrIndex<std::uint32_t> m_postings;         // term -> sorted docs
+    std::size_t m_docCount = 0;
+
+    // Docs matching one query word, each with its best distance, sorted by doc.
+    std::vector<FuzzyMatch> MatchWord(std::string_view word, unsigned maxEdits) const;
+
+};
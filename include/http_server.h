@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct HttpRequest {
+    std::string method;
+    std::string path;                                           // percent-decoded, without the query
+    std::vector<std::pair<std::string, std::string>> query;     // percent-decoded, '+' as space
+    std::vector<std::pair<std::string, std::string>> headers;   // names lower-cased
+    std::string body;
+    bool keepAlive = true;
+
+    std::optional<std::string_view> Param(std::string_view name) const;
+    std::optional<std::string_view> Header(std::string_view name) const;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string contentType = "application/json";
+    std::string body;
+
+    static HttpResponse Json(std::string body, int status = 200) { return HttpResponse{ status, "application/json", std::move(body) }; }
+    static HttpResponse Error(int status, std::string_view message);
+};
+
+struct HttpServerOptions {
+    std::string bindAddress = "127.0.0.1";
+    std::uint16_t port = 8080;              // 0 picks a free port, see HttpServer::Port
+    std::size_t threads = 0;                // event loops; 0 uses std::thread::hardware_concurrency()
+    std::size_t maxHeaderBytes = 16 * 1024;
+    std::size_t maxBodyBytes = 64 * 1024;
+    std::size_t maxPendingOutputBytes = 1024 * 1024;    // unsent responses past this pause reading and parsing
+    int idleTimeoutSeconds = 30;
+};
+
+// HTTP/1.1 server with one epoll event loop per thread (Linux only). All
+// loops wait on the same listening socket with EPOLLEXCLUSIVE, so a new
+// connection wakes one loop, which then owns the connection for its whole
+// life: no locks or hand-offs on the request path. Connections are kept alive
+// (and pipelined requests answered in order) until the client asks to close
+// or stays idle past the timeout. A client that pipelines without reading
+// the answers is throttled: past maxPendingOutputBytes of unsent output the
+// loop stops parsing and reading until the backlog drains. The handler runs
+// on the loop thread, so it must be thread-safe and should not block.
+class HttpServer {
+
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+    // Binds and listens immediately; throws std::system_error on failure.
+    HttpServer(HttpServerOptions options, Handler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // Starts the event loops and returns.
+    void Start();
+
+    // Wakes every loop, closes all connections and joins the threads. Safe to call twice.
+    void Stop();
+
+    std::uint16_t Port() const { return m_port; }
+
+private:
+    struct Loop;
+
+    HttpServerOptions m_options;
+    Handler m_handler;
+    int m_listenFd = -1;
+    int m_stopFd = -1;          // eventfd every loop watches
+    std::uint16_t m_port = 0;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_running = false;
+
+    void Run();
+
+};
+
+// Splits "a=1&b=x+y" into decoded pairs.
+std::vector<std::pair<std::string, std::string>> parse_query_string(std::string_view query);
+
+// %XX and (when plusAsSpace) '+' decoding; malformed escapes are kept as is.
+std::string percent_decode(std::string_view text, bool plusAsSpace);
+
+std::string_view http_status_text(int status);
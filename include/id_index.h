@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// id -> row lookup built once at load time.
+// Contiguous id ranges (club.dat, staff.dat) get a direct-address table, sparse
+// ones fall back to a hash map. Duplicate ids resolve to the first row, same as
+// the linear find_if this replaces.
+class IdIndex {
+
+public: 
+    IdIndex() = default;
+    explicit IdIndex(std::span<const std::int32_t> ids);
+
+    template <typename Range, typename Proj>
+    static IdIndex Build(const Range& rows, Proj idOf)
+    {
+        std::vector<std::int32_t> ids;
+        ids.reserve(std::size(rows));
+        for (const auto& row : rows) ids.push_back(static_cast<std::int32_t>(idOf(row)));
+        return IdIndex(ids);
+    }
+
+    std::optional<std::size_t> Find(std::int32_t id) const 
+    {
+        if (m_dense)
+        {
+            const auto slot = static_cast<std::uint64_t>(static_cast<std::int64_t>(id) - m_minId);
+            if (slot >= m_slots.size() || m_slots[slot] == EMPTY)
+                return std::nullopt;
+
+            return m_slots[slot];
+        }
+
+        auto it = m_sparse.find(id);
+        if (it == m_sparse.end())
+            return std::nullopt;
+
+        return it->second;
+    }
+
+    bool IsDense() const { return m_dense; }
+    std::size_t Size() const { return m_size; }
+
+    void Save(SnapshotWriter& out) const;
+    static IdIndex Load(SnapshotReader& in);
+
+private: 
+    static constexpr std::uint32_t EMPTY = std::numeric_limits<std::uint32_t>::max();
+
+    bool m_dense = true;
+    std::size_t m_size = 0;
+    std::int64_t m_minId = 0;
+    std::vector<std::uint32_t> m_slots;
+    std::unordered_map<std::int32_t, std::uint32_t> m_sparse;
+
+};
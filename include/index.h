@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
 #include "entity.h"
 
 #pragma pack(push, 1)
@@ -13,15 +19,34 @@ struct Index : public Entity {
 };
 #pragma pack(pop)
 
-inline std::ostream& operator<<(std::ostream& os, const Index& idx)
+// staff.dat holds several tables back to back; index.dat tells its blocks
+// apart by the type stored in the last field of the entry.
+enum class StaffBlock : std::uint32_t {
+    People      = 6,
+    NonPlayers  = 9,
+    Players     = 10,
+    Preferences = 22
+};
+
+inline std::string_view index_file_name(const Index& idx)
 {
     // Safely convert fixed char array to string_view
     const auto end = std::find(idx.file_name.begin(),
                                idx.file_name.end(),
                                '\0');
 
-    std::string_view fileName(idx.file_name.data(),
-                              std::distance(idx.file_name.begin(), end));
+    return std::string_view(idx.file_name.data(),
+                            std::distance(idx.file_name.begin(), end));
+}
+
+inline std::uint32_t index_block_type(const Index& idx)
+{
+    return idx.version;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Index& idx)
+{
+    std::string_view fileName = index_file_name(idx);
 
     os << "Index {\n"
        << "  file_name  : \"" << fileName << "\"\n"
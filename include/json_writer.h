@@ -0,0 +1,134 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "text_encoding.h"
+
+// Streaming JSON builder: commas and nesting are tracked and strings are
+// escaped. Value() expects UTF-8 and replaces malformed sequences with U+FFFD,
+// so request bytes echoed back cannot break the document; text from the
+// database tables goes through Cp1252Value instead. Non-finite doubles are
+// written as null.
+//   JsonWriter json;
+//   json.BeginObject().Key("id").Value(7).Key("name").Cp1252Value(name).EndObject();
+class JsonWriter {
+
+public:
+    JsonWriter& BeginObject() { Separate(); m_out.push_back('{'); m_first.push_back(true); return *this; }
+    JsonWriter& EndObject() { m_out.push_back('}'); m_first.pop_back(); return *this; }
+    JsonWriter& BeginArray() { Separate(); m_out.push_back('['); m_first.push_back(true); return *this; }
+    JsonWriter& EndArray() { m_out.push_back(']'); m_first.pop_back(); return *this; }
+
+    JsonWriter& Key(std::string_view key)
+    {
+        Separate();
+        AppendString(key);
+        m_out.push_back(':');
+        m_afterKey = true;
+        return *this;
+    }
+
+    JsonWriter& Value(std::string_view text) { Separate(); AppendString(text); return *this; }
+    JsonWriter& Cp1252Value(std::string_view text) { Separate(); AppendString(text, true); return *this; }
+    JsonWriter& Value(const char* text) { return Value(std::string_view(text)); }
+    JsonWriter& Value(bool flag) { Separate(); m_out.append(flag ? "true" : "false"); return *this; }
+    JsonWriter& Null() { Separate(); m_out.append("null"); return *this; }
+
+    template <typename T>
+    requires(std::integral<T> && !std::same_as<T, bool>)
+    JsonWriter& Value(T number)
+    {
+        Separate();
+        char buf[24];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), static_cast<std::int64_t>(number));
+        m_out.append(buf, end);
+        return *this;
+    }
+
+    JsonWriter& Value(double number)
+    {
+        Separate();
+        if (!std::isfinite(number))
+        {
+            m_out.append("null");
+            return *this;
+        }
+        char buf[32];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), number);
+        m_out.append(buf, end);
+        return *this;
+    }
+
+    const std::string& Str() const { return m_out; }
+    std::string Take() && { return std::move(m_out); }
+
+private:
+    std::string m_out;
+    std::vector<bool> m_first;      // per open container: nothing written yet
+    bool m_afterKey = false;
+
+    void Separate()
+    {
+        if (m_afterKey)
+        {
+            m_afterKey = false;
+            return;
+        }
+        if (m_first.empty()) return;
+
+        if (!m_first.back()) m_out.push_back(',');
+        m_first.back() = false;
+    }
+
+    // `cp1252`: bytes >= 0x80 are Windows-1252 characters to convert to UTF-8;
+    // otherwise they must form valid UTF-8.
+    void AppendString(std::string_view text, bool cp1252 = false)
+    {
+        static constexpr char HEX[] = "0123456789abcdef";
+
+        m_out.push_back('"');
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            const auto ch = static_cast<unsigned char>(text[i]);
+            switch (ch)
+            {
+            case '"': m_out.append("\\\""); break;
+            case '\\': m_out.append("\\\\"); break;
+            case '\n': m_out.append("\\n"); break;
+            case '\r': m_out.append("\\r"); break;
+            case '\t': m_out.append("\\t"); break;
+            default:
+                if (ch < 0x20)
+                {
+                    m_out.append("\\u00");
+                    m_out.push_back(HEX[ch >> 4]);
+                    m_out.push_back(HEX[ch & 0xF]);
+                }
+                else if (ch < 0x80)
+                {
+                    m_out.push_back(static_cast<char>(ch));
+                }
+                else if (cp1252)
+                {
+                    m_out.append(cp1252_to_utf8(text.substr(i, 1)));
+                }
+                else if (const std::size_t length = utf8_sequence_length(text.substr(i)); length != 0)
+                {
+                    m_out.append(text.substr(i, length));
+                    i += length - 1;
+                }
+                else
+                {
+                    append_utf8(m_out, 0xFFFD);
+                }
+            }
+        }
+        m_out.push_back('"');
+    }
+
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <spanstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "entity.h"
+#include "id_index.h"
+#include "lru_cache.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "staff.h"
+#include "staff_repository.h"
+
+// Turns the on-disk bytes of one record into a T. Packed records are copied
+// as they are, which needs a little-endian host like LoadMode::Mapped does.
+template <typename T>
+struct RecordDecoder {
+    static T Decode(std::span<const std::byte> bytes)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if constexpr (std::endian::native != std::endian::little)
+            throw std::runtime_error("RecordDecoder<T> requires a little-endian host");
+
+        T rec;
+        std::memcpy(&rec, bytes.data(), sizeof(T));
+        return rec;
+    }
+};
+
+template <>
+struct RecordDecoder<Staff> {
+    static Staff Decode(std::span<const std::byte> bytes)
+    {
+        std::ispanstream in(std::span<const char>(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+        return StaffRepository::read_staff_le(in);
+    }
+};
+
+// Opens a table without decoding it: the file is mapped, only the record ids
+// are read to build the id -> row table (a record's offset is then
+// offset + row * sizeof(T)), and a record is decoded the first time it is
+// asked for. Decoded records are kept in a byte-bounded LRU cache, so a tool
+// that touches a few dozen of 250k rows pays for a few dozen decodes.
+// ClubRepository, StaffRepository, FirstNameRepository and IndexRepository
+// are the eager counterparts: they decode the whole table up front.
+template <typename T>
+requires(std::derived_from<T, Entity> && requires(T entity){ {entity.id}; })
+class LazyRepository {
+
+public:
+    static constexpr std::size_t DEFAULT_CACHE_BYTES = 1024 * 1024;
+
+    explicit LazyRepository(const std::filesystem::path& tableName, std::size_t offset = 0, std::size_t max_size = 0,
+                            std::size_t cacheBytes = DEFAULT_CACHE_BYTES)
+        : LazyRepository(std::make_shared<const MappedFile>(tableName), offset, max_size, cacheBytes)
+    {
+    }
+
+    LazyRepository(std::shared_ptr<const MappedFile> file, std::size_t offset, std::size_t max_size = 0,
+                   std::size_t cacheBytes = DEFAULT_CACHE_BYTES)
+        : m_file(std::move(file)), m_cache(cacheBytes)
+    {
+        if (offset > m_file->Size()) throw std::runtime_error("Block offset is past the end of " + m_file->Path().string());
+
+        const std::size_t count = max_size != 0 ? max_size : (m_file->Size() - offset) / sizeof(T);
+        m_block = m_file->Slice(offset, count * sizeof(T));
+
+        std::vector<std::int32_t> ids(count);
+        for (std::size_t row = 0; row < count; ++row)
+            ids[row] = load_i32_le(m_block.data() + row * sizeof(T) + offsetof(T, id));
+        m_ids = IdIndex(ids);
+    }
+
+    // Decoded on first access, then served from the cache.
+    std::shared_ptr<const T> FindById(int id) const
+    {
+        auto row = m_ids.Find(id);
+        if (!row.has_value())
+            return nullptr;
+
+        return m_cache.GetOrCompute(id, [&]{ return DecodeRow(*row); });
+    }
+
+    std::optional<T> GetById(int id) const
+    {
+        auto rec = FindById(id);
+        if (rec == nullptr)
+            return std::nullopt;
+
+        return *rec;
+    }
+
+    // Byte position of the record inside the file.
+    std::optional<std::size_t> OffsetOf(int id) const
+    {
+        auto row = m_ids.Find(id);
+        if (!row.has_value())
+            return std::nullopt;
+
+        return static_cast<std::size_t>(m_block.data() - m_file->Bytes().data()) + *row * sizeof(T);
+    }
+
+    // Decodes without touching the cache, e.g. for one pass over every row.
+    T DecodeRow(std::size_t row) const 
+    {
+        CM_COUNT("cm_lazy_decodes_total", "", 1);
+        return RecordDecoder<T>::Decode(m_block.subspan(row * sizeof(T), sizeof(T)));
+    }
+
+    std::size_t Size() const { return m_block.size() / sizeof(T); }
+    CacheStats Stats() const { return m_cache.Stats(); }
+
+private:
+    std::shared_ptr<const MappedFile> m_file;
+    std::span<const std::byte> m_block;
+    IdIndex m_ids;
+    mutable ShardedLruCache<std::int32_t, T> m_cache;
+
+    static std::int32_t load_i32_le(const std::byte* p)
+    {
+        return static_cast<std::int32_t>(std::to_integer<std::uint32_t>(p[0])
+                                         | (std::to_integer<std::uint32_t>(p[1]) << 8)
+                                         | (std::to_integer<std::uint32_t>(p[2]) << 16)
+                                         | (std::to_integer<std::uint32_t>(p[3]) << 24));
+    }
+
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct CacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+};
+
+// Approximate heap footprint of a cached key or value, used for the byte budget.
+struct CacheCharge {
+    template <typename T>
+    std::size_t operator()(const std::vector<T>& v) const { return sizeof(v) + v.capacity() * sizeof(T); }
+
+    std::size_t operator()(const std::string& s) const { return sizeof(s) + s.capacity(); }
+
+    template <typename T>
+    std::size_t operator()(const T&) const { return sizeof(T); }
+};
+
+// Byte budget of the SearchByName caches of ClubRepository and StaffRepository,
+// which hold the row lists of the most frequent queries keyed by their case
+// fold (TrigramIndex::fold), so "AJAX" and "ajax" share an entry, and of each
+// of Database's two name-search caches.
+inline constexpr std::size_t DEFAULT_SEARCH_CACHE_BYTES = 4 * 1024 * 1024;
+
+// Thread-safe LRU cache bounded by bytes rather than entries. Keys are hashed
+// onto independent shards, each with its own lock and its own slice of the
+// capacity, so concurrent readers of different keys rarely contend. Values
+// are handed out as shared_ptr<const Value>: a caller keeps its result even if
+// the entry is evicted a moment later, and nothing is copied on a hit.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Charge = CacheCharge>
+class ShardedLruCache {
+
+public:
+    static constexpr std::size_t DEFAULT_SHARDS = 16;
+
+    explicit ShardedLruCache(std::size_t capacityBytes, std::size_t shards = DEFAULT_SHARDS)
+        : m_shardCount(std::max<std::size_t>(1, shards)),
+          m_shards(std::make_unique<Shard[]>(m_shardCount)),
+          m_shardCapacity(capacityBytes / m_shardCount)
+    {
+    }
+
+    // Cached value, refreshed as most recently used, or nullptr.
+    std::shared_ptr<const Value> Find(const Key& key)
+    {
+        Shard& shard = ShardOf(key);
+        std::lock_guard lock(shard.mutex);
+
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+        {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->value;
+    }
+
+    // Stores `value` under `key`, replacing any previous entry, and evicts
+    // least recently used entries of the shard until it fits again. A value
+    // larger than a whole shard is returned but not kept.
+    std::shared_ptr<const Value> Insert(const Key& key, Value value)
+    {
+        const std::size_t charge = Charge{}(key) + Charge{}(value) + ENTRY_OVERHEAD;
+        auto shared = std::make_shared<const Value>(std::move(value));
+        if (charge > m_shardCapacity) return shared;
+
+        Shard& shard = ShardOf(key);
+        std::lock_guard lock(shard.mutex);
+
+        if (auto it = shard.map.find(key); it != shard.map.end())
+            Erase(shard, it->second);
+
+        shard.lru.push_front(Entry{ key, shared, charge });
+        shard.map.emplace(key, shard.lru.begin());
+        shard.bytes += charge;
+
+        while (shard.bytes > m_shardCapacity)
+        {
+            Erase(shard, std::prev(shard.lru.end()));
+            m_evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        return shared;
+    }
+
+    // Find, or compute and insert on a miss. `compute` runs outside the shard
+    // lock, so two threads missing the same key may both compute it.
+    template <typename Compute>
+    std::shared_ptr<const Value> GetOrCompute(const Key& key, Compute&& compute)
+    {
+        if (auto hit = Find(key)) return hit;
+
+        return Insert(key, std::invoke(std::forward<Compute>(compute)));
+    }
+
+    void Clear()
+    {
+        for (std::size_t i = 0; i < m_shardCount; ++i)
+        {
+            std::lock_guard lock(m_shards[i].mutex);
+            m_shards[i].map.clear();
+            m_shards[i].lru.clear();
+            m_shards[i].bytes = 0;
+        }
+    }
+
+    CacheStats Stats() const
+    {
+        CacheStats stats;
+        stats.hits = m_hits.load(std::memory_order_relaxed);
+        stats.misses = m_misses.load(std::memory_order_relaxed);
+        stats.evictions = m_evictions.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < m_shardCount; ++i)
+        {
+            std::lock_guard lock(m_shards[i].mutex);
+            stats.entries += m_shards[i].map.size();
+            stats.bytes += m_shards[i].bytes;
+        }
+        return stats;
+    }
+
+    std::size_t CapacityBytes() const { return m_shardCapacity * m_shardCount; }
+
+private:
+    // List node plus hash node plus control block, roughly.
+    static constexpr std::size_t ENTRY_OVERHEAD = 96;
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<const Value> value;
+        std::size_t charge;
+    };
+
+    using Lru = std::list<Entry>;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        Lru lru;                                            // most recently used first
+        std::unordered_map<Key, typename Lru::iterator, Hash> map;
+        std::size_t bytes = 0;
+    };
+
+    std::size_t m_shardCount;
+    std::unique_ptr<Shard[]> m_shards;
+    std::size_t m_shardCapacity;
+
+    std::atomic<std::uint64_t> m_hits = 0;
+    std::atomic<std::uint64_t> m_misses = 0;
+    std::atomic<std::uint64_t> m_evictions = 0;
+
+    Shard& ShardOf(const Key& key)
+    {
+        // Mix the hash so shard choice does not collide with the map's bucket choice.
+        std::uint64_t h = Hash{}(key);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        return m_shards[h % m_shardCount];
+    }
+
+    static void Erase(Shard& shard, typename Lru::iterator it)
+    {
+        shard.bytes -= it->charge;
+        shard.map.erase(it->key);
+        shard.lru.erase(it);
+    }
+
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read-only memory mapping of a whole .dat file.
+// The mapping is MAP_SHARED, so every process that maps the same file shares
+// one page-cache copy of it instead of holding its own heap buffer.
+class MappedFile {
+
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    std::span<const std::byte> Bytes() const { return { m_data, m_size }; }
+    std::size_t Size() const { return m_size; }
+    const std::filesystem::path& Path() const { return m_path; }
+
+    // Returns the bytes [offset, offset + length) or throws when the range is out of the file.
+    std::span<const std::byte> Slice(std::size_t offset, std::size_t length) const;
+
+private:
+    std::filesystem::path m_path;
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    void Unmap() noexcept;
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "id_index.h"
+#include "staff.h"
+#include "staff_names.h"
+
+// Interned copy of a TNames table (first, second or common names): every
+// trimmed name lives in one contiguous arena and is handed out as a string_view.
+class NameTable {
+
+public: 
+    NameTable() = default;
+
+    template <typename Names>
+    explicit NameTable(std::span<const Names> names)
+    {
+        m_offsets.reserve(names.size() + 1);
+        for (const auto& rec : names)
+        {
+            m_offsets.push_back(static_cast<std::uint32_t>(m_arena.size()));
+            m_arena.append(name_view(rec));
+        }
+        m_offsets.push_back(static_cast<std::uint32_t>(m_arena.size()));
+        m_ids = IdIndex::Build(names, [](const Names& rec){ return rec.id; });
+    }
+
+    std::string_view GetById(std::int32_t id) const 
+    {
+        if (id < 0) return {};
+
+        auto row = m_ids.Find(id);
+        if (!row.has_value()) return {};
+
+        return GetByRow(*row);
+    }
+
+    std::string_view GetByRow(std::size_t row) const 
+    {
+        return std::string_view(m_arena).substr(m_offsets[row], m_offsets[row + 1] - m_offsets[row]);
+    }
+
+    std::size_t Size() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+    std::size_t ArenaBytes() const { return m_arena.size(); }
+
+    void Save(SnapshotWriter& out) const;
+    static NameTable Load(SnapshotReader& in);
+
+private: 
+    std::string m_arena;
+    std::vector<std::uint32_t> m_offsets;   // Size() + 1 entries
+    IdIndex m_ids;
+
+};
+
+// Display name of every staff member, resolved once at load time and stored
+// in one arena, so listing rows costs no allocation.
+class StaffNameCache {
+
+public: 
+    StaffNameCache() = default;
+    StaffNameCache(std::span<const Staff> staffs,
+                   const NameTable& firstNames,
+                   const NameTable& secondNames,
+                   const NameTable* commonNames = nullptr);
+
+    std::string_view GetById(std::int32_t staffId) const 
+    {
+        auto row = m_ids.Find(staffId);
+        if (!row.has_value()) return {};
+
+        return GetByRow(*row);
+    }
+
+    // Rows follow the staff table the cache was built from.
+    std::string_view GetByRow(std::size_t row) const 
+    {
+        return std::string_view(m_arena).substr(m_offsets[row], m_offsets[row + 1] - m_offsets[row]);
+    }
+
+    std::size_t Size() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+    std::size_t ArenaBytes() const { return m_arena.size(); }
+
+    void Save(SnapshotWriter& out) const;
+    static StaffNameCache Load(SnapshotReader& in);
+
+private: 
+    std::string m_arena;
+    std::vector<std::uint32_t> m_offsets;
+    IdIndex m_ids;
+
+};
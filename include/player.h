@@ -1,5 +1,8 @@
+#pragma once
 #include <cstdint>
 
+#include "entity.h"
+
 #pragma pack(push, 1)
 struct Player : public Entity
 {
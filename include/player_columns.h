@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "player.h"
+#include "selection_bitmap.h"
+
+// The sbyte attributes of Player, in record order (0x0F..0x44).
+enum class PlayerAttribute : std::uint8_t {
+    Goalkeeper, Sweeper, Defender, DefensiveMidfielder, Midfielder, AttackingMidfielder,
+    Attacker, WingBack, RightSide, LeftSide, Central, FreeRole,
+    Acceleration, Aggression, Agility, Anticipation, Balance, Bravery, Consistency, Corners,
+    Crossing, Decisions, Dirtiness, Dribbling, Finishing, Flair, FreeKicks, Handling, Heading,
+    ImportantMatches, InjuryProneness, Jumping, Leadership, LeftFoot, LongShots, Marking,
+    Movement, NaturalFitness, OneOnOnes, PlayerPace, Passing, Penalties, Positioning, Reflexes,
+    RightFoot, Stamina, Strength, Tackling, Teamwork, Technique, ThrowIns, Versatility, Vision,
+    WorkRate,
+    Count
+};
+
+inline constexpr std::size_t PLAYER_ATTRIBUTE_COUNT = static_cast<std::size_t>(PlayerAttribute::Count);
+inline constexpr std::size_t PLAYER_ATTRIBUTE_OFFSET = 0x0F;
+
+static_assert(offsetof(Player, Goalkeeper) == PLAYER_ATTRIBUTE_OFFSET);
+static_assert(offsetof(Player, WorkRate) == PLAYER_ATTRIBUTE_OFFSET + PLAYER_ATTRIBUTE_COUNT - 1);
+
+// Inclusive range predicate on one attribute column.
+struct AttributeRange {
+    PlayerAttribute attribute;
+    std::int8_t min = INT8_MIN;
+    std::int8_t max = INT8_MAX;
+};
+
+// One term of a weighted score.
+struct AttributeWeight {
+    PlayerAttribute attribute;
+    double weight = 1.0;
+};
+
+inline std::int8_t attribute_value(const Player& player, PlayerAttribute attribute)
+{
+    return reinterpret_cast<const std::int8_t*>(&player)[PLAYER_ATTRIBUTE_OFFSET + static_cast<std::size_t>(attribute)];
+}
+
+// Sum of weight * attribute, e.g. a striker rating from Finishing, Pace and Movement.
+inline double weighted_score(const Player& player, std::span<const AttributeWeight> weights)
+{
+    double score = 0.0;
+    for (const auto& w : weights) score += w.weight * attribute_value(player, w.attribute);
+    return score;
+}
+
+// Structure-of-arrays copy of the player block: one contiguous int8 column per
+// attribute, so a filter only streams through the columns it names.
+class PlayerColumns {
+
+public: 
+    explicit PlayerColumns(std::span<const Player> players);
+
+    std::size_t Size() const { return m_rows; }
+
+    std::span<const std::int8_t> Column(PlayerAttribute attribute) const 
+    {
+        return { m_data.data() + static_cast<std::size_t>(attribute) * m_stride, m_rows };
+    }
+
+    std::span<const std::int32_t> Ids() const { return m_ids; }
+
+    // Rows for which every range holds. An empty predicate list selects all rows.
+    SelectionBitmap Filter(std::span<const AttributeRange> ranges) const;
+
+private: 
+    std::size_t m_rows = 0;
+    std::size_t m_stride = 0;           // column length rounded up to a 64-byte multiple
+    std::vector<std::int8_t> m_data;    // PLAYER_ATTRIBUTE_COUNT columns back to back
+    std::vector<std::int32_t> m_ids;
+
+};
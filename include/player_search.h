@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "database.h"
+#include "player.h"
+#include "staff.h"
+#include "thread_pool.h"
+#include "top_k.h"
+
+struct PlayerMatch {
+    const Staff* staff;
+    const Player* player;
+    double score;
+};
+
+// Best `k` players by `score(staff, player)`, which returns std::nullopt to
+// exclude a player, e.g.
+//
+//   top_players(db, 50, [&](const Staff& s, const Player& p) -> std::optional<double> {
+//       if (s.Nation != nation || age_on(s.DateOfBirth, today) >= 21) return std::nullopt;
+//       return p.CurrentAbility;
+//   }, &pool);
+//
+// Only staff members with a player record are visited, through the load-time
+// join; only the K winners are materialized, best first.
+template <typename Score>
+std::vector<PlayerMatch> top_players(const Database& db, std::size_t k, Score score, ThreadPool* pool = nullptr)
+{
+    const auto staffs = db.Staffs().Records();
+    const auto players = db.Players().Records();
+    const auto rows = db.Joined().PlayerRows();
+
+    auto ranked = top_k(rows.size(), k, [&](std::size_t i) -> std::optional<double> {
+        return std::invoke(score, staffs[rows[i].staffRow], players[rows[i].playerRow]);
+    }, pool);
+
+    std::vector<PlayerMatch> res;
+    res.reserve(ranked.size());
+    for (const auto& r : ranked)
+        res.push_back({ &staffs[rows[r.row].staffRow], &players[rows[r.row].playerRow], r.score });
+
+    return res;
+}
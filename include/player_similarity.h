@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "database.h"
+#include "player.h"
+#include "player_columns.h"
+#include "roaring_bitmap.h"
+#include "staff.h"
+#include "thread_pool.h"
+
+enum class SimilarityMetric : std::uint8_t {
+    WeightedL2,     // sqrt(sum w * (x - t)^2)
+    Cosine          // 1 - weighted cosine similarity of x and t
+};
+
+// Matrix row width: the attributes padded with zeros to one 64-byte cache line.
+inline constexpr std::size_t SIMILARITY_DIMENSIONS = 64;
+static_assert(PLAYER_ATTRIBUTE_COUNT <= SIMILARITY_DIMENSIONS);
+
+// The point to search around: attribute values and how much each one counts.
+// An attribute with weight 0 is ignored. Either taken from a player by
+// PlayerSimilarity::TargetOf or filled in directly, e.g.
+//
+//   SimilarityTarget t;
+//   t.values[static_cast<std::size_t>(PlayerAttribute::Finishing)] = 18;
+//   t.weights[static_cast<std::size_t>(PlayerAttribute::Finishing)] = 2.0;
+struct SimilarityTarget {
+    std::array<std::int8_t, PLAYER_ATTRIBUTE_COUNT> values{};
+    std::array<double, PLAYER_ATTRIBUTE_COUNT> weights{};
+    std::optional<std::size_t> staffRow;        // the player the target was taken from; never returned
+};
+
+struct SimilarityOptions {
+    std::size_t k = 10;
+    SimilarityMetric metric = SimilarityMetric::WeightedL2;
+    const RoaringBitmap* staffRows = nullptr;   // only these staff rows (e.g. from SecondaryIndexes::MatchStaff); nullptr = every player
+    std::size_t probes = 0;                     // inverted lists to scan; 0 = exact search over every row
+};
+
+struct SimilarPlayer {
+    const Staff* staff;
+    const Player* player;
+    double distance;
+};
+
+// Weight 1 on every technical, mental and physical attribute (Acceleration..WorkRate)
+// and 0 on the position ratings.
+std::array<double, PLAYER_ATTRIBUTE_COUNT> default_similarity_weights();
+
+// "Players like X": k-nearest-neighbour search over the attributes of every
+// player row of the load-time join. The attributes are copied into a
+// row-major int8 matrix, one cache line per player, and the weights are
+// quantized to 7-bit integers relative to the largest, so distances are
+// exact integer sums computed by AVX2/SSE2 kernels (scalar elsewhere).
+// Quantization limits the usable weight ratio to 127:1: every positive
+// weight counts as at least 1/127 of the largest, so one smaller than that
+// is over-weighted rather than dropped, and ratios between steps are rounded.
+//
+// With `lists` > 0 the constructor also builds an IVF index: k-means clusters
+// of the attribute vectors, each stored as a contiguous slice of a permuted
+// copy of the matrix. A search with `probes` > 0 then scans only the lists
+// whose centroids are nearest the target, trading recall for speed on large
+// databases. Immutable once built, so safe to share between threads.
+class PlayerSimilarity {
+
+public:
+    // `db` must outlive the index; `pool` only speeds up the k-means build.
+    explicit PlayerSimilarity(const Database& db, std::size_t lists = 0, ThreadPool* pool = nullptr);
+
+    std::size_t Rows() const { return m_rows; }
+    std::size_t Lists() const { return m_listBegin.empty() ? 0 : m_listBegin.size() - 1; }
+
+    // The player's own attributes weighted by `weights`, or by
+    // default_similarity_weights when empty; std::nullopt for an unknown id
+    // or a staff member without a player record.
+    std::optional<SimilarityTarget> TargetOf(std::int32_t staffId, std::span<const AttributeWeight> weights = {}) const;
+
+    // The k players nearest `target`, nearest first, ties to the lower staff
+    // row. Exact unless options.probes > 0 and the IVF index was built, in
+    // which case only players in the probed lists are candidates. Throws
+    // std::invalid_argument when a weight is negative or infinite, or every weight is 0.
+    std::vector<SimilarPlayer> Nearest(const SimilarityTarget& target, const SimilarityOptions& options = {}) const;
+
+private:
+    const Database& m_db;
+    std::size_t m_rows = 0;
+    std::vector<std::int8_t> m_matrix;          // m_rows rows of SIMILARITY_DIMENSIONS, in PlayerRows order
+
+    // IVF index: list l holds entries [m_listBegin[l], m_listBegin[l + 1]) of
+    // m_listMatrix, whose PlayerRows positions are m_listRows.
+    std::vector<float> m_centroids;             // Lists() rows of SIMILARITY_DIMENSIONS
+    std::vector<std::uint32_t> m_listBegin;
+    std::vector<std::int8_t> m_listMatrix;
+    std::vector<std::uint32_t> m_listRows;
+
+    void BuildLists(std::size_t lists, ThreadPool* pool);
+
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// A small textual query language over the loaded tables:
+//
+//   [EXPLAIN] <table> [WHERE <cond> {AND <cond>}] [ORDER BY <field> [ASC|DESC]] [LIMIT <n>]
+//
+//   <table>  player | staff | club
+//   <cond>   <field> (= | != | < | <= | > | >=) <value>
+//            <field> IN (<value>, ...)
+//            <field> BETWEEN <value> AND <value>
+//   <value>  integer, or a bare word such as a position name
+//
+// e.g. "player where Finishing>=15 and Nation=12 and age<23 order by PotentialAbility desc limit 50".
+// Keywords and field names are case-insensitive. Parsing only checks syntax;
+// QueryEngine binds the names against the table schemas.
+
+enum class QueryTable : std::uint8_t { Staff, Player, Club };
+
+enum class CompareOp : std::uint8_t { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, In, Between };
+
+using QueryValue = std::variant<std::int64_t, std::string>;
+
+struct Condition {
+    std::string field;
+    CompareOp op;
+    std::vector<QueryValue> values;     // one, except IN (any number) and BETWEEN (two)
+    std::size_t position;               // offset of the field name in the query text
+};
+
+struct OrderClause {
+    std::string field;
+    bool descending = false;
+    std::size_t position;
+};
+
+struct ParsedQuery {
+    bool explain = false;
+    QueryTable table;
+    std::vector<Condition> where;       // AND-ed
+    std::optional<OrderClause> orderBy;
+    std::optional<std::size_t> limit;
+};
+
+// A query that does not parse or bind; Position() is the offset in the query text it refers to.
+class QueryError : public std::runtime_error {
+
+public:
+    QueryError(const std::string& message, std::size_t position)
+        : std::runtime_error(message + " (at offset " + std::to_string(position) + ")"), m_position(position) {}
+
+    std::size_t Position() const { return m_position; }
+
+private:
+    std::size_t m_position;
+
+};
+
+// Throws QueryError on a syntax error.
+ParsedQuery parse_query(std::string_view text);
+
+std::string_view table_name(QueryTable table);
+
+// ASCII case-insensitive comparison, as keywords and field names are matched.
+bool equals_ignore_case(std::string_view a, std::string_view b);
+
+// The condition as it would be written, for EXPLAIN.
+std::string to_string(const Condition& condition);
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "database.h"
+#include "query_language.h"
+#include "schema.h"
+#include "staff.h"
+
+struct QueryOptions {
+    CMDate today{ 0, 2001, 0 };         // reference date of age and contract_days
+};
+
+// What a column name of a query resolves to. Staff and player tables see the
+// Staff fields, then the Player fields, then the virtual columns below; a club
+// query sees the Club fields only.
+enum class ColumnKind : std::uint8_t {
+    StaffField, PlayerField, ClubField,
+    Age,            // whole years on QueryOptions::today, as age_on counts them
+    ContractDays,   // days from QueryOptions::today to DateExpiresClub
+    Natural         // positions rated NATURAL_POSITION_RATING or more, e.g. natural IN (Attacker, WingBack)
+};
+
+struct BoundColumn {
+    std::string name;                           // as the schema spells it
+    ColumnKind kind;
+    const FieldDescriptor* field = nullptr;     // the *Field kinds only
+};
+
+struct ValueRange {
+    std::int64_t min;
+    std::int64_t max;
+};
+
+// A WHERE condition bound to a column: it holds when the row's value lies in
+// any of `ranges`. Age and contract_days ranges are already translated into
+// day numbers of the underlying date column, natural ranges into position indexes.
+struct BoundPredicate {
+    std::string text;
+    BoundColumn column;
+    std::vector<ValueRange> ranges;
+};
+
+enum class AccessPath : std::uint8_t {
+    TableScan,          // every row of the table, one record at a time
+    JoinRowScan,        // every pre-joined row of StaffJoin::PlayerRows; no per-row join lookup
+    DateColumnScan,     // SIMD range compare over the day-number columns, then the surviving rows
+    IndexProbe,         // intersection of bitmap and range index probes, then the surviving rows
+    OrderedIndexScan    // a range index walked in ORDER BY order until LIMIT rows matched
+};
+
+std::string_view access_path_name(AccessPath access);
+
+// A bound query and the access path the planner picked for it, with the row
+// estimates EXPLAIN prints next to the actual counts.
+struct QueryPlan {
+    QueryTable table;
+    bool explain = false;
+    std::vector<BoundPredicate> predicates;
+    std::optional<BoundColumn> orderBy;
+    bool descending = false;
+    std::optional<std::size_t> limit;
+
+    // Rows without a player record never match: set for the player table and
+    // for staff queries that name a player column.
+    bool needsPlayer = false;
+
+    AccessPath access = AccessPath::TableScan;
+    std::vector<std::size_t> probes;            // predicates answered by an index (IndexProbe, OrderedIndexScan)
+    std::vector<std::size_t> dateFilters;       // predicates answered by the day columns (DateColumnScan)
+    std::vector<std::size_t> residual;          // predicates checked row by row, most selective first
+    std::optional<std::size_t> orderBound;      // predicate on the ORDER BY column that bounds an OrderedIndexScan
+
+    // Estimates, in rows.
+    std::vector<double> predicateRows;          // rows of the table matching each predicate alone
+    double baseRows = 0;                        // rows of the table (player rows when needsPlayer)
+    double accessRows = 0;                      // rows the access path hands on
+    double matchRows = 0;                       // rows matching every predicate
+    double cost = 0;                            // in the planner's units (~ sequential record reads)
+
+    // Every access path considered, with its estimated cost, cheapest first.
+    std::vector<std::pair<std::string, double>> alternatives;
+};
+
+// One operator of an executed plan, for EXPLAIN.
+struct PlanNode {
+    std::string label;
+    double estimatedRows = 0;
+    std::size_t actualRows = 0;
+    double milliseconds = -1;                   // negative when not timed separately
+    std::vector<PlanNode> children;
+};
+
+struct QueryResult {
+    std::vector<std::uint32_t> rows;            // staff rows, or club rows for a club query
+    std::vector<BoundColumn> columns;           // the columns the query names, for printing
+    PlanNode plan;
+    double milliseconds = 0;
+};
+
+// Compiles parsed queries into plans over one Database and runs them. The
+// planner costs each access path from table statistics: exact counts from the
+// bitmap and range indexes where a predicate has one, a sorted sample of the
+// column otherwise, with predicates assumed independent. Safe to share between threads.
+class QueryEngine {
+
+public:
+    // `db` must outlive the engine.
+    explicit QueryEngine(const Database& db, QueryOptions options = {});
+
+    // Binds the names and picks the cheapest access path; throws QueryError.
+    QueryPlan Plan(const ParsedQuery& query) const;
+    QueryPlan Plan(std::string_view text) const { return Plan(parse_query(text)); }
+
+    QueryResult Execute(const QueryPlan& plan) const;
+
+    // The column's value for one result row as it is displayed (age in years,
+    // contract_days in days); std::nullopt when the row has none.
+    std::optional<std::int64_t> Value(const BoundColumn& column, QueryTable table, std::size_t row) const;
+
+    // Display name of a result row.
+    std::string_view RowName(QueryTable table, std::size_t row) const;
+
+    const QueryOptions& Options() const { return m_options; }
+
+private:
+    const Database& m_db;
+    QueryOptions m_options;
+    std::int32_t m_today;                       // day_number(m_options.today)
+
+    static constexpr std::size_t SAMPLE_ROWS = 2048;
+
+    // Sorted sample of a column's values; rows without a value count in `rows` only.
+    struct ColumnSample {
+        std::vector<std::int64_t> values;
+        std::size_t rows = 0;
+    };
+
+    // Built the first time a plan needs them, keyed by "table.column".
+    mutable std::mutex m_statisticsMutex;
+    mutable std::map<std::string, ColumnSample> m_samples;
+
+    struct RowRecords;
+
+    BoundColumn BindColumn(QueryTable table, std::string_view name, std::size_t position) const;
+    BoundPredicate BindPredicate(QueryTable table, const Condition& condition) const;
+
+    double EstimateRows(const QueryPlan& plan, const BoundPredicate& predicate) const;
+    double SampleFraction(const QueryPlan& plan, const BoundPredicate& predicate) const;
+    void ChooseAccessPath(QueryPlan& plan) const;
+
+    RowRecords Resolve(QueryTable table, std::size_t row, bool withPlayer) const;
+    std::optional<std::int64_t> Key(const BoundColumn& column, const RowRecords& records) const;
+    bool Matches(const BoundPredicate& predicate, const RowRecords& records) const;
+
+};
+
+// EXPLAIN output: the operator tree with estimated and actual rows, then the access paths considered.
+void write_explain(std::ostream& os, const QueryPlan& plan, const QueryResult& result);
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "roaring_bitmap.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// Inclusive range of column values.
+struct IntRange {
+    std::int32_t min = INT32_MIN;
+    std::int32_t max = INT32_MAX;
+};
+
+// Rows sorted by one numeric column, so a range query is two searches and a
+// slice, and the slice is already in column order ("sort by value" needs no
+// post-sort; iterate it backwards for descending). Searches walk a copy of the
+// keys in Eytzinger (BFS) order: the first levels of the implicit tree share
+// a handful of cache lines, and the next lines down are prefetched while the
+// current comparison runs.
+class RangeIndex {
+
+public:
+    RangeIndex() = default;
+
+    // (key, row) entries in any order; equal keys keep ascending row order.
+    explicit RangeIndex(std::vector<std::pair<std::int32_t, std::uint32_t>> entries);
+
+    std::size_t Size() const { return m_rows.size(); }
+
+    // Position in Keys() / Rows() of the first key >= key (or > key), Size() when none.
+    std::size_t LowerBound(std::int32_t key) const;
+    std::size_t UpperBound(std::int32_t key) const { return key == INT32_MAX ? Size() : LowerBound(key + 1); }
+
+    // Rows with range.min <= key <= range.max, ascending by key.
+    std::span<const std::uint32_t> Between(IntRange range) const;
+    std::span<const std::uint32_t> AtLeast(std::int32_t min) const { return Between({ min, INT32_MAX }); }
+    std::span<const std::uint32_t> AtMost(std::int32_t max) const { return Between({ INT32_MIN, max }); }
+
+    // The same rows as a bitmap, to combine with other clauses.
+    RoaringBitmap BitmapBetween(IntRange range) const;
+
+    // Every indexed row ascending by key, and the keys alongside.
+    std::span<const std::uint32_t> Rows() const { return m_rows; }
+    std::span<const std::int32_t> Keys() const { return m_keys; }
+
+    std::size_t ByteSize() const
+    {
+        return m_keys.size() * sizeof(std::int32_t) + m_rows.size() * sizeof(std::uint32_t)
+             + m_eytzinger.size() * sizeof(std::int32_t) + m_rank.size() * sizeof(std::uint32_t);
+    }
+
+    void Save(SnapshotWriter& out) const;
+    static RangeIndex Load(SnapshotReader& in);
+
+private:
+    std::vector<std::int32_t> m_keys;           // ascending
+    std::vector<std::uint32_t> m_rows;          // row of m_keys[i]
+    std::vector<std::int32_t> m_eytzinger;      // m_keys in BFS order, 1-based (slot 0 unused)
+    std::vector<std::uint32_t> m_rank;          // position in m_keys of m_eytzinger[k]
+
+    void BuildEytzinger();
+    std::size_t FillEytzinger(std::size_t i, std::size_t k);
+
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "scan_executor.h"
+
+struct MatchAll {
+    template <typename T>
+    constexpr bool operator()(const T&) const { return true; }
+};
+
+template <typename T, typename Pred, typename Proj, typename Comp>
+class OrderedRecordQuery;
+
+// Lazy query over a table: Where clauses are AND-ed, nothing is evaluated until
+// the result is iterated, and records are only copied by ToVector().
+template <typename T, typename Pred = MatchAll>
+class RecordQuery {
+
+public: 
+    static constexpr std::size_t NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+    explicit RecordQuery(std::span<const T> records, Pred pred = {}, std::size_t limit = NO_LIMIT)
+        : m_records(records), m_pred(std::move(pred)), m_limit(limit) {}
+
+    template <std::predicate<const T&> P>
+    auto Where(P pred) const 
+    {
+        auto combined = [first = m_pred, second = std::move(pred)](const T& item) {
+            return std::invoke(first, item) && std::invoke(second, item);
+        };
+        return RecordQuery<T, decltype(combined)>(m_records, std::move(combined), m_limit);
+    }
+
+    RecordQuery Limit(std::size_t n) const { return RecordQuery(m_records, m_pred, n); }
+
+    template <typename Proj, typename Comp = std::ranges::less>
+    OrderedRecordQuery<T, Pred, Proj, Comp> OrderBy(Proj proj, Comp comp = {}) const 
+    {
+        return { m_records, m_pred, std::move(proj), std::move(comp), m_limit };
+    }
+
+    template <typename Proj>
+    auto OrderByDescending(Proj proj) const { return OrderBy(std::move(proj), std::ranges::greater{}); }
+
+    // Range of const T& into the table, filtered while iterating. NO_LIMIT is
+    // clamped, since take() counts in ptrdiff_t.
+    auto View() const 
+    {
+        const auto limit = static_cast<std::ptrdiff_t>(std::min<std::size_t>(m_limit, PTRDIFF_MAX));
+        return m_records
+            | std::views::filter([pred = m_pred](const T& item){ return std::invoke(pred, item); })
+            | std::views::take(limit);
+    }
+
+    template <typename Proj>
+    auto Select(Proj proj) const { return View() | std::views::transform(std::move(proj)); }
+
+    const T* First() const 
+    {
+        if (m_limit == 0) return nullptr;
+
+        for (const auto& item : m_records)
+            if (std::invoke(m_pred, item)) return &item;
+
+        return nullptr;
+    }
+
+    std::size_t Count() const 
+    {
+        if (m_limit == 0) return 0;
+
+        std::size_t n = 0;
+        for (const auto& item : m_records)
+            if (std::invoke(m_pred, item) && ++n == m_limit) break;
+
+        return n;
+    }
+
+    std::vector<T> ToVector() const 
+    {
+        std::vector<T> res;
+        for (const auto& item : View()) res.push_back(item);
+        return res;
+    }
+
+    // Parallel counterparts of View() and Count(): the whole table is scanned
+    // in morsels on the executor's pool, results keep row order.
+    std::vector<const T*> Rows(const ScanExecutor& executor) const 
+    {
+        auto rows = executor.Select(m_records, m_pred, [](const T& item){ return &item; });
+        if (rows.size() > m_limit) rows.resize(m_limit);
+        return rows;
+    }
+
+    std::size_t Count(const ScanExecutor& executor) const 
+    {
+        return std::min(executor.Count(m_records, m_pred), m_limit);
+    }
+
+private: 
+    std::span<const T> m_records;
+    Pred m_pred;
+    std::size_t m_limit;
+
+};
+
+// Ordering needs the whole match set, but only as pointers: the records stay in
+// place and a limit turns the sort into a partial sort of the first n.
+template <typename T, typename Pred, typename Proj, typename Comp>
+class OrderedRecordQuery {
+
+public: 
+    OrderedRecordQuery(std::span<const T> records, Pred pred, Proj proj, Comp comp, std::size_t limit)
+        : m_records(records), m_pred(std::move(pred)), m_proj(std::move(proj)), m_comp(std::move(comp)), m_limit(limit) {}
+
+    OrderedRecordQuery Limit(std::size_t n) const 
+    {
+        return { m_records, m_pred, m_proj, m_comp, n };
+    }
+
+    std::vector<const T*> Rows() const 
+    {
+        std::vector<const T*> rows;
+        for (const auto& item : m_records)
+            if (std::invoke(m_pred, item)) rows.push_back(&item);
+
+        // Equal keys keep row order, with or without a limit.
+        auto less = [&](const T* a, const T* b) {
+            if (std::invoke(m_comp, std::invoke(m_proj, *a), std::invoke(m_proj, *b))) return true;
+            if (std::invoke(m_comp, std::invoke(m_proj, *b), std::invoke(m_proj, *a))) return false;
+            return a < b;
+        };
+
+        if (m_limit < rows.size())
+        {
+            std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(m_limit), rows.end(), less);
+            rows.resize(m_limit);
+        }
+        else 
+        {
+            std::sort(rows.begin(), rows.end(), less);
+        }
+        return rows;
+    }
+
+    auto View() const 
+    {
+        return Rows() | std::views::transform([](const T* item) -> const T& { return *item; });
+    }
+
+    std::vector<T> ToVector() const 
+    {
+        std::vector<T> res;
+        for (const T* item : Rows()) res.push_back(*item);
+        return res;
+    }
+
+private: 
+    std::span<const T> m_records;
+    Pred m_pred;
+    Proj m_proj;
+    Comp m_comp;
+    std::size_t m_limit;
+
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "club.h"
+#include "csr_index.h"
+#include "id_index.h"
+#include "staff.h"
+
+// Which slot of a Club record refers to a staff member.
+enum class ClubRole : std::uint8_t {
+    Chairman,
+    Director,
+    Manager,
+    AssistantManager,
+    Player,
+    Coach,
+    Scout,
+    Physio
+};
+
+struct ClubMembership {
+    std::uint32_t clubRow;
+    ClubRole role;
+};
+
+// Reverse adjacency built at load time so "which club is this staff member
+// at", "clubs of nation X" or "staff of nation X" are index lookups instead of
+// scans over all clubs or staff.
+// Club and staff results are row numbers into the tables the index was built from.
+class ReferenceIndex {
+
+public: 
+    ReferenceIndex() = default;
+    ReferenceIndex(std::span<const Club> clubs, std::span<const Staff> staffs);
+
+    // Every club slot (squad, coach, scout, ...) that names the staff member.
+    std::span<const ClubMembership> ClubsOfStaff(std::int32_t staffId) const 
+    {
+        auto row = m_staffIds.Find(staffId);
+        if (!row.has_value()) return {};
+
+        return m_staffToClub.Get(static_cast<std::int64_t>(*row));
+    }
+
+    std::span<const std::uint32_t> ClubsOfNation(std::int32_t nationId) const { return m_nationToClub.Get(nationId); }
+    std::span<const std::uint32_t> ClubsOfDivision(std::int32_t divisionId) const { return m_divisionToClub.Get(divisionId); }
+
+    // Staff rows whose Staff::ClubJob is the club.
+    std::span<const std::uint32_t> StaffOfClub(std::int32_t clubId) const 
+    {
+        auto row = m_clubIds.Find(clubId);
+        if (!row.has_value()) return {};
+
+        return m_clubToStaff.Get(static_cast<std::int64_t>(*row));
+    }
+
+    // Staff rows whose Nation or SecondNation is the nation, in row order.
+    std::span<const std::uint32_t> StaffOfNation(std::int32_t nationId) const { return m_nationToStaff.Get(nationId); }
+
+    // Staff rows employed by any club of the nation, grouped by club.
+    std::vector<std::uint32_t> StaffOfNationClubs(std::int32_t nationId) const;
+
+    void Save(SnapshotWriter& out) const;
+    static ReferenceIndex Load(SnapshotReader& in);
+
+private: 
+    IdIndex m_clubIds;
+    IdIndex m_staffIds;
+    CsrIndex<ClubMembership> m_staffToClub;     // keyed by staff row
+    CsrIndex<std::uint32_t> m_nationToClub;     // keyed by nation id, up to MAX_GROUP_ID
+    CsrIndex<std::uint32_t> m_divisionToClub;   // keyed by division id, up to MAX_GROUP_ID
+    CsrIndex<std::uint32_t> m_clubToStaff;      // keyed by club row
+    CsrIndex<std::uint32_t> m_nationToStaff;    // keyed by nation id, up to MAX_GROUP_ID
+
+};
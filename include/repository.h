@@ -1,3 +1,4 @@
+#pragma once
 #include <vector> 
 #include <optional>
 #include <string> 
@@ -6,23 +7,53 @@
 #include <iomanip>
 #include <iostream> 
 #include <algorithm>
+#include <bit>
 #include <concepts> 
+#include <memory>
+#include <span>
+#include <stdexcept>
 #include <type_traits> 
 
 #include "entity.h"
+#include "id_index.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "record_query.h"
 
 template <typename T> 
 concept HasId = requires(T entity){ {entity.id};};
 
+enum class LoadMode {
+    Copy,   // read every record into an owned vector
+    Mapped  // mmap the file and view the block in place, no per-record copy
+};
+
 template <typename T> 
 requires(std::derived_from<T, Entity> && HasId<T>)
 class Repository {
 
 public: 
-    explicit Repository(const std::filesystem::path& tableName, size_t offset = 0, size_t max_size = 0) 
+    explicit Repository(const std::filesystem::path& tableName, size_t offset = 0, size_t max_size = 0,
+                        LoadMode mode = LoadMode::Copy) 
     {
-        std::ifstream in(tableName, std::ios::binary);
-        if (!in) throw std::runtime_error("Failed to open: " + tableName.string());
+        if (mode == LoadMode::Mapped)
+        {
+            MapBlock(std::make_shared<const MappedFile>(tableName), offset, max_size);
+            BuildIdIndex();
+            return;
+        }
+
+        std::ifstream in;
+        std::streamoff fileSize = 0;
+        {
+            CM_TIME_SCOPE("cm_load_phase_seconds", "phase=\"open\"");
+            in.open(tableName, std::ios::binary);
+            if (!in) throw std::runtime_error("Failed to open: " + tableName.string());
+
+            in.seekg(0, std::ios::end);
+            fileSize = in.tellg();
+            in.seekg(offset, std::ios::beg); // skip header / jump to the block
+        }
 
         std::streamoff size;
         if (max_size != 0)
@@ -31,9 +62,7 @@ public:
         }
         else 
         {
-            in.seekg(0, std::ios::end);
-            size = in.tellg();
-            in.seekg(offset, std::ios::beg); // skip header by offset
+            size = fileSize - static_cast<std::streamoff>(offset);
         }
 
         if (size < 0) throw std::runtime_error("Bad file size.");
@@ -45,60 +74,126 @@ public:
         const size_t count = static_cast<size_t>(size / sizeof(T));
         m_list.resize(count);
 
-        for (size_t i = 0; i < count; ++i) {
-            T rec{};
-            in.read(reinterpret_cast<char*>(&rec), sizeof(rec));
-            if (!in) throw std::runtime_error("Read error while reading record " + std::to_string(i));
-            m_list[i] = rec;
+        {
+            // The packed struct is the file layout, so reading a record also decodes it.
+            CM_TIME_SCOPE("cm_load_phase_seconds", "phase=\"read\"");
+            for (size_t i = 0; i < count; ++i) {
+                T rec{};
+                in.read(reinterpret_cast<char*>(&rec), sizeof(rec));
+                if (!in) throw std::runtime_error("Read error while reading record " + std::to_string(i));
+                m_list[i] = rec;
+            }
         }
+
+        m_records = m_list;
+        BuildIdIndex();
+    }
+
+    // Views a block of an already mapped file, e.g. one of the staff.dat sub-blocks,
+    // so several repositories can share a single mapping.
+    Repository(std::shared_ptr<const MappedFile> file, size_t offset, size_t max_size = 0)
+    {
+        MapBlock(std::move(file), offset, max_size);
+        BuildIdIndex();
     }
 
+    // Views `block`, which must lie inside `file`, with an id index that was built
+    // earlier (e.g. restored from a snapshot) instead of rebuilding it.
+    Repository(std::shared_ptr<const MappedFile> file, std::span<const std::byte> block, IdIndex ids)
+        : m_file(std::move(file)),
+          m_records(reinterpret_cast<const T*>(block.data()), block.size() / sizeof(T)),
+          m_ids(std::move(ids))
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(alignof(T) == 1, "mapped records must be packed");
+        if (block.size() % sizeof(T) != 0) throw std::runtime_error("Block size is not a multiple of the record size.");
+    }
+
+    Repository(const Repository&) = delete;
+    Repository& operator=(const Repository&) = delete;
+    Repository(Repository&&) noexcept = default;
+    Repository& operator=(Repository&&) noexcept = default;
+
     std::optional<T> GetById(int id) const 
     {
-        auto it = std::ranges::find_if(m_list, [&](const auto& item){ return id == item.id; });
-        if (it == m_list.end())
+        const T* item = FindById(id);
+        if (item == nullptr)
             return std::nullopt;
 
-        return *it;
+        return *item;
     }
 
+    // Same lookup as GetById without copying the record; nullptr when absent.
+    const T* FindById(int id) const 
+    {
+        auto row = m_ids.Find(id);
+        if (!row.has_value())
+        {
+            CM_COUNT("cm_lookups_total", "result=\"miss\"", 1);
+            return nullptr;
+        }
+
+        CM_COUNT("cm_lookups_total", "result=\"hit\"", 1);
+        return &m_records[*row];
+    }
+
+    std::optional<size_t> RowOf(int id) const { return m_ids.Find(id); }
+
     std::optional<std::vector<T>> GetAll() const 
     {
-        if (m_list.size() > 0)
-            return m_list; 
+        if (m_records.size() > 0)
+            return std::vector<T>(m_records.begin(), m_records.end()); 
         
         return std::nullopt;
     }
 
-    // TODO: find a way to implement a find_if kind function instead of searchByName. 
-    // With this way, client has the flexibility of searching with a lambda function.
-    // std::optional<std::vector<T>> SearchByName(const std::string& name) const
-    // {
-    //     std::vector<T> res; 
+    // Read-only view of the stored records, valid as long as the repository lives.
+    std::span<const T> Records() const { return m_records; }
+    size_t Size() const { return m_records.size(); }
+    bool IsMapped() const { return m_file != nullptr; }
+    const IdIndex& Ids() const { return m_ids; }
 
-    //     for (const auto& item : m_list) 
-    //     {
-    //         auto itemName = to_lower(fixed_cstr_to_string(item.short_name.data(), item.short_name.size()));
+    // Composable, lazily evaluated search over the stored records, e.g.
+    //   repo.Query().Where(pred).OrderByDescending(&T::field).Limit(50).View()
+    RecordQuery<T> Query() const { return RecordQuery<T>(m_records); }
 
-    //         if (itemName.contains(to_lower(name)))
-    //         {
-    //             res.push_back(item);
-    //         }
-    //     }
+private:  
+    std::vector<T> m_list;
+    std::shared_ptr<const MappedFile> m_file;
+    std::span<const T> m_records;
+    IdIndex m_ids;
 
-    //     if (res.size() == 0) 
-    //         return std::nullopt;
+    void BuildIdIndex()
+    {
+        CM_TIME_SCOPE("cm_load_phase_seconds", "phase=\"index\"");
+        m_ids = IdIndex::Build(m_records, [](const T& item){ return item.id; });
+    }
 
-    //     return res;
-    // }
+    void MapBlock(std::shared_ptr<const MappedFile> file, size_t offset, size_t max_size)
+    {
+        // Records are reinterpreted in place, which is only valid for the on-disk
+        // little-endian layout of the packed structs.
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(alignof(T) == 1, "mapped records must be packed");
+        if constexpr (std::endian::native != std::endian::little)
+            throw std::runtime_error("Mapped mode requires a little-endian host.");
 
+        if (offset > file->Size()) throw std::runtime_error("Offset is out of " + file->Path().string());
 
-private:  
-    std::vector<T> m_list;
+        size_t count = max_size;
+        if (count == 0)
+        {
+            const size_t size = file->Size() - offset;
+            if (size % sizeof(T) != 0) {
+                std::cerr << "[warn] File size (" << size << ") is not divisible by size of the type. "
+                        << "Parsing will use floor(size/size of the type) records.\n";
+            }
+            count = size / sizeof(T);
+        }
 
-    // static std::string to_lower(std::string s) {
-    //     for (auto& ch : s) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-    //     return s;
-    // }
+        const auto bytes = file->Slice(offset, count * sizeof(T));
+        m_records = std::span<const T>(reinterpret_cast<const T*>(bytes.data()), count);
+        m_file = std::move(file);
+    }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "selection_bitmap.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// Compressed set of 32-bit row numbers, roaring style: values are grouped by
+// their high 16 bits into containers, each either a sorted array of the low
+// halves (up to ARRAY_MAX values) or a 2^16-bit bitmap. Sparse groups stay
+// small, dense ones cost 8 KiB, and set algebra works container by container
+// with a kernel per container pairing. Every container lives in one of three
+// flat vectors, so a bitmap is saved and loaded as three blobs.
+class RoaringBitmap {
+
+public:
+    static constexpr std::size_t ARRAY_MAX = 4096;
+    static constexpr std::size_t BITMAP_WORDS = (1u << 16) / 64;
+
+    RoaringBitmap() = default;
+
+    // Every value in [begin, end).
+    static RoaringBitmap Range(std::uint32_t begin, std::uint32_t end);
+
+    static RoaringBitmap FromSorted(std::span<const std::uint32_t> values);
+    static RoaringBitmap FromSelection(const SelectionBitmap& selection);
+
+    // Values may arrive in any order within the last container (the last run
+    // of 65536), but must never fall below it; throws std::invalid_argument.
+    // Adding rows in ascending order is therefore always valid and O(1).
+    void Add(std::uint32_t value);
+
+    bool Contains(std::uint32_t value) const;
+
+    std::size_t Cardinality() const { return m_cardinality; }
+    bool Empty() const { return m_cardinality == 0; }
+    std::size_t ContainerCount() const { return m_containers.size(); }
+
+    // Heap bytes held by the containers.
+    std::size_t ByteSize() const
+    {
+        return m_containers.size() * sizeof(Container) + m_values.size() * sizeof(std::uint16_t) + m_words.size() * sizeof(std::uint64_t);
+    }
+
+    // Calls fn(value) for every value in ascending order.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const
+    {
+        for (const auto& c : m_containers)
+        {
+            const std::uint32_t high = std::uint32_t{ c.key } << 16;
+            if (c.kind == ARRAY)
+            {
+                for (std::uint32_t i = 0; i < c.cardinality; ++i) fn(high | m_values[c.offset + i]);
+                continue;
+            }
+
+            for (std::size_t i = 0; i < BITMAP_WORDS; ++i)
+            {
+                for (auto w = m_words[c.offset + i]; w != 0; w &= w - 1)
+                    fn(high | static_cast<std::uint32_t>(i * 64 + static_cast<std::size_t>(std::countr_zero(w))));
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> ToVector() const;
+
+    // Values below `rows` as a flat bitmap.
+    SelectionBitmap ToSelection(std::size_t rows) const;
+
+    RoaringBitmap& operator&=(const RoaringBitmap& other) { return *this = *this & other; }
+    RoaringBitmap& operator|=(const RoaringBitmap& other) { return *this = *this | other; }
+    RoaringBitmap& operator-=(const RoaringBitmap& other) { return *this = *this - other; }
+
+    friend RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b);
+    friend RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b);
+    friend RoaringBitmap operator-(const RoaringBitmap& a, const RoaringBitmap& b);     // AND NOT
+
+    // Containers are always in canonical form, so equal sets compare equal.
+    bool operator==(const RoaringBitmap& other) const = default;
+
+    // AND of every bitmap, smallest first so the working set only shrinks; empty when `bitmaps` is.
+    static RoaringBitmap intersect(std::span<const RoaringBitmap* const> bitmaps);
+
+    // OR of every bitmap in one pass over the containers of each key.
+    static RoaringBitmap unite(std::span<const RoaringBitmap* const> bitmaps);
+
+    void Save(SnapshotWriter& out) const;
+    static RoaringBitmap Load(SnapshotReader& in);
+
+private:
+    static constexpr std::uint16_t ARRAY = 0;
+    static constexpr std::uint16_t BITMAP = 1;
+
+    struct Container {
+        std::uint16_t key;              // high 16 bits of every value in it
+        std::uint16_t kind;             // ARRAY or BITMAP
+        std::uint32_t cardinality;
+        std::uint32_t offset;           // into m_values (ARRAY) or m_words (BITMAP)
+
+        bool operator==(const Container&) const = default;
+    };
+
+    // One container of some bitmap, seen as either its values or its words.
+    struct ContainerView {
+        std::uint16_t key;
+        std::span<const std::uint16_t> values;
+        std::span<const std::uint64_t> words;
+
+        bool IsBitmap() const { return !words.empty(); }
+    };
+
+    std::vector<Container> m_containers;     // ascending keys
+    std::vector<std::uint16_t> m_values;
+    std::vector<std::uint64_t> m_words;
+    std::size_t m_cardinality = 0;
+
+    ContainerView View(std::size_t i) const;
+
+    // Close the container being built at the tail of m_values / m_words,
+    // converting it to the other kind when its cardinality calls for it and
+    // dropping it when empty.
+    void FinishArray(std::uint16_t key, std::size_t begin);
+    void FinishBitmap(std::uint16_t key, std::size_t begin);
+
+    void AppendCopy(const ContainerView& c);
+    void AppendAnd(const ContainerView& a, const ContainerView& b);
+    void AppendOr(const ContainerView& a, const ContainerView& b);
+    void AppendAndNot(const ContainerView& a, const ContainerView& b);
+
+};
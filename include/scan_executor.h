@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "selection_bitmap.h"
+#include "thread_pool.h"
+
+// Morsels [0, count) dealt out as one contiguous range per worker. A worker
+// takes morsels from the front of its own range and, once that is empty,
+// steals the back half of another worker's range, so a slow or late worker
+// never holds up the scan.
+class MorselQueue {
+
+public:
+    MorselQueue(std::size_t morselCount, std::size_t workers);
+
+    // Next morsel for `worker`, or std::nullopt when every range is drained.
+    std::optional<std::size_t> Next(std::size_t worker);
+
+private:
+    // begin in the high 32 bits, end in the low 32 bits, so a range moves with one CAS.
+    std::vector<std::atomic<std::uint64_t>> m_ranges;
+
+    std::optional<std::size_t> Pop(std::size_t worker);
+    std::optional<std::size_t> Steal(std::size_t thief);
+};
+
+// Runs scans over a table on a ThreadPool. Rows are split into morsels of
+// roughly `morselBytes` of records (a multiple of 64 rows, so bitmap words
+// never straddle two morsels) and the calling thread works alongside the pool.
+// Results are merged in morsel order, so they come back in row order no matter
+// which thread scanned what. Predicates and projections run concurrently and
+// must not mutate shared state.
+class ScanExecutor {
+
+public:
+    static constexpr std::size_t DEFAULT_MORSEL_BYTES = 64 * 1024;
+
+    explicit ScanExecutor(ThreadPool& pool, std::size_t morselBytes = DEFAULT_MORSEL_BYTES)
+        : m_pool(pool), m_morselBytes(morselBytes) {}
+
+    template <typename T>
+    std::size_t MorselRows() const { return std::max<std::size_t>(1, m_morselBytes / sizeof(T) / 64) * 64; }
+
+    // Calls fn(begin, end, morsel) for each morsel of [0, rows). The first
+    // exception thrown by fn is rethrown once every started morsel finished.
+    template <typename Fn>
+    void ForEachMorsel(std::size_t rows, std::size_t morselRows, Fn&& fn) const;
+
+    // Rows for which pred holds, ascending.
+    template <typename T, typename Pred>
+    std::vector<std::size_t> FilterRows(std::span<const T> records, Pred pred) const
+    {
+        return Collect<std::size_t>(records, [&](const T& item, std::size_t row) -> std::optional<std::size_t> {
+            if (!std::invoke(pred, item)) return std::nullopt;
+            return row;
+        });
+    }
+
+    // proj(item) of every item for which pred holds, in row order.
+    template <typename T, typename Pred, typename Proj>
+    auto Select(std::span<const T> records, Pred pred, Proj proj) const
+    {
+        using R = std::decay_t<std::invoke_result_t<Proj&, const T&>>;
+        return Collect<R>(records, [&](const T& item, std::size_t) -> std::optional<R> {
+            if (!std::invoke(pred, item)) return std::nullopt;
+            return std::invoke(proj, item);
+        });
+    }
+
+    // Same selection as FilterRows as a bitmap; morsels own whole words, so no bit is shared between threads.
+    template <typename T, typename Pred>
+    SelectionBitmap Filter(std::span<const T> records, Pred pred) const
+    {
+        SelectionBitmap res(records.size());
+        ForEachMorsel(records.size(), MorselRows<T>(), [&](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t row = begin; row < end; ++row)
+                if (std::invoke(pred, records[row])) res.Set(row);
+        });
+        return res;
+    }
+
+    template <typename T, typename Pred>
+    std::size_t Count(std::span<const T> records, Pred pred) const
+    {
+        std::atomic<std::size_t> total = 0;
+        ForEachMorsel(records.size(), MorselRows<T>(), [&](std::size_t begin, std::size_t end, std::size_t) {
+            std::size_t n = 0;
+            for (std::size_t row = begin; row < end; ++row)
+                if (std::invoke(pred, records[row])) ++n;
+            total.fetch_add(n, std::memory_order_relaxed);
+        });
+        return total.load();
+    }
+
+private:
+    ThreadPool& m_pool;
+    std::size_t m_morselBytes;
+
+    template <typename R, typename T, typename Emit>
+    std::vector<R> Collect(std::span<const T> records, Emit emit) const
+    {
+        const std::size_t morselRows = MorselRows<T>();
+        std::vector<std::vector<R>> parts((records.size() + morselRows - 1) / morselRows);
+
+        ForEachMorsel(records.size(), morselRows, [&](std::size_t begin, std::size_t end, std::size_t morsel) {
+            auto& out = parts[morsel];
+            for (std::size_t row = begin; row < end; ++row)
+                if (auto value = emit(records[row], row)) out.push_back(std::move(*value));
+        });
+
+        std::size_t total = 0;
+        for (const auto& part : parts) total += part.size();
+
+        std::vector<R> res;
+        res.reserve(total);
+        for (auto& part : parts) std::ranges::move(part, std::back_inserter(res));
+        return res;
+    }
+};
+
+template <typename Fn>
+void ScanExecutor::ForEachMorsel(std::size_t rows, std::size_t morselRows, Fn&& fn) const
+{
+    const std::size_t morselCount = (rows + morselRows - 1) / morselRows;
+    if (morselCount == 0) return;
+
+    const std::size_t workers = std::min(m_pool.Size() + 1, morselCount);
+
+    // Helpers share this through a shared_ptr: one may only get scheduled
+    // after the scan is over, and then it finds the queue empty and leaves
+    // without touching `fn`. The caller therefore waits for morsels, not for
+    // helpers, which also keeps nested scans from a pool thread deadlock-free.
+    struct State {
+        MorselQueue queue;
+        std::atomic<std::size_t> done = 0;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        State(std::size_t count, std::size_t workers): queue(count, workers) {}
+    };
+    auto state = std::make_shared<State>(morselCount, workers);
+
+    auto work = [state, &fn, rows, morselRows, morselCount](std::size_t worker) {
+        while (auto morsel = state->queue.Next(worker))
+        {
+            const std::size_t begin = *morsel * morselRows;
+            try
+            {
+                std::invoke(fn, begin, std::min(rows, begin + morselRows), *morsel);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(state->errorMutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+
+            if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == morselCount)
+                state->done.notify_all();
+        }
+    };
+
+    for (std::size_t w = 1; w < workers; ++w)
+        m_pool.Submit([work, w] { work(w); });
+
+    work(0);
+
+    for (std::size_t d = state->done.load(std::memory_order_acquire); d != morselCount; d = state->done.load(std::memory_order_acquire))
+        state->done.wait(d, std::memory_order_acquire);
+
+    if (state->error) std::rethrow_exception(state->error);
+}
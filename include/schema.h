@@ -0,0 +1,410 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "club.h"
+#include "non_player.h"
+#include "player.h"
+#include "staff.h"
+
+// Single source of truth for the on-disk record layouts. Every table below is
+// built from offsetof/sizeof on the packed structs, checked at compile time to
+// tile the record exactly, and drives the generic decoder, printer, column
+// extraction and field-by-name lookup further down.
+
+enum class FieldType : std::uint8_t {
+    Integer,        // 1, 2 or 4 byte little-endian integer
+    Text,           // fixed-size NUL-padded byte array
+    Date,           // CMDate: int16 day, int16 year, int32 leap flag
+    IntegerArray    // fixed-size array of integers
+};
+
+struct FieldDescriptor {
+    std::string_view name;
+    std::uint16_t offset;
+    std::uint16_t width;            // bytes of the whole field
+    std::uint8_t elementWidth;      // bytes of one integer (of the array); 0 for Text and Date
+    bool isSigned;
+    FieldType type;
+
+    std::size_t Count() const { return elementWidth == 0 ? 1 : width / elementWidth; }
+};
+
+template <typename T>
+struct is_std_array : std::false_type {};
+
+template <typename E, std::size_t N>
+struct is_std_array<std::array<E, N>> : std::true_type {};
+
+template <typename Record, typename Member>
+consteval FieldDescriptor make_field(std::string_view name, std::size_t offset)
+{
+    FieldDescriptor f{ name, static_cast<std::uint16_t>(offset), static_cast<std::uint16_t>(sizeof(Member)), 0, false, FieldType::Integer };
+
+    if constexpr (std::is_same_v<Member, CMDate>)
+    {
+        f.type = FieldType::Date;
+    }
+    else if constexpr (is_std_array<Member>::value)
+    {
+        using E = typename Member::value_type;
+        static_assert(std::is_integral_v<E>);
+        if constexpr (sizeof(E) == 1)
+        {
+            f.type = FieldType::Text;
+        }
+        else
+        {
+            f.type = FieldType::IntegerArray;
+            f.elementWidth = sizeof(E);
+            f.isSigned = std::is_signed_v<E>;
+        }
+    }
+    else
+    {
+        static_assert(std::is_integral_v<Member>);
+        f.elementWidth = sizeof(Member);
+        f.isSigned = std::is_signed_v<Member>;
+    }
+    return f;
+}
+
+#define CM_FIELD(Record, member) make_field<Record, decltype(Record::member)>(#member, offsetof(Record, member))
+
+template <typename T>
+struct RecordSchema;
+
+template <>
+struct RecordSchema<Staff> {
+    static constexpr std::string_view name = "Staff";
+    static constexpr std::array fields = {
+        CM_FIELD(Staff, id), CM_FIELD(Staff, FirstName), CM_FIELD(Staff, SecondName), CM_FIELD(Staff, CommonName),
+        CM_FIELD(Staff, DateOfBirth), CM_FIELD(Staff, YearOfBirth), CM_FIELD(Staff, Nation), CM_FIELD(Staff, SecondNation),
+        CM_FIELD(Staff, IntApps), CM_FIELD(Staff, IntGoals), CM_FIELD(Staff, NationalJob), CM_FIELD(Staff, JobForNation),
+        CM_FIELD(Staff, DateJoinedNation), CM_FIELD(Staff, DateExpiresNation), CM_FIELD(Staff, ClubJob), CM_FIELD(Staff, JobForClub),
+        CM_FIELD(Staff, DateJoinedClub), CM_FIELD(Staff, DateExpiresClub), CM_FIELD(Staff, Wage), CM_FIELD(Staff, Value),
+        CM_FIELD(Staff, Adaptability), CM_FIELD(Staff, Ambition), CM_FIELD(Staff, Determination), CM_FIELD(Staff, Loyality),
+        CM_FIELD(Staff, Pressure), CM_FIELD(Staff, Professionalism), CM_FIELD(Staff, Sportsmanship), CM_FIELD(Staff, Temperament),
+        CM_FIELD(Staff, PlayingSquad), CM_FIELD(Staff, Classification), CM_FIELD(Staff, ClubValuation), CM_FIELD(Staff, Player),
+        CM_FIELD(Staff, StaffPreferences), CM_FIELD(Staff, NonPlayer), CM_FIELD(Staff, SquadSelectedFor),
+    };
+};
+
+template <>
+struct RecordSchema<Player> {
+    static constexpr std::string_view name = "Player";
+    static constexpr std::array fields = {
+        CM_FIELD(Player, id), CM_FIELD(Player, SquadNumber), CM_FIELD(Player, CurrentAbility), CM_FIELD(Player, PotentialAbility),
+        CM_FIELD(Player, HomeReputation), CM_FIELD(Player, CurrentReputation), CM_FIELD(Player, WorldReputation),
+        CM_FIELD(Player, Goalkeeper), CM_FIELD(Player, Sweeper), CM_FIELD(Player, Defender), CM_FIELD(Player, DefensiveMidfielder),
+        CM_FIELD(Player, Midfielder), CM_FIELD(Player, AttackingMidfielder), CM_FIELD(Player, Attacker), CM_FIELD(Player, WingBack),
+        CM_FIELD(Player, RightSide), CM_FIELD(Player, LeftSide), CM_FIELD(Player, Central), CM_FIELD(Player, FreeRole),
+        CM_FIELD(Player, Acceleration), CM_FIELD(Player, Aggression), CM_FIELD(Player, Agility), CM_FIELD(Player, Anticipation),
+        CM_FIELD(Player, Balance), CM_FIELD(Player, Bravery), CM_FIELD(Player, Consistency), CM_FIELD(Player, Corners),
+        CM_FIELD(Player, Crossing), CM_FIELD(Player, Decisions), CM_FIELD(Player, Dirtiness), CM_FIELD(Player, Dribbling),
+        CM_FIELD(Player, Finishing), CM_FIELD(Player, Flair), CM_FIELD(Player, FreeKicks), CM_FIELD(Player, Handling),
+        CM_FIELD(Player, Heading), CM_FIELD(Player, ImportantMatches), CM_FIELD(Player, InjuryProneness), CM_FIELD(Player, Jumping),
+        CM_FIELD(Player, Leadership), CM_FIELD(Player, LeftFoot), CM_FIELD(Player, LongShots), CM_FIELD(Player, Marking),
+        CM_FIELD(Player, Movement), CM_FIELD(Player, NaturalFitness), CM_FIELD(Player, OneOnOnes), CM_FIELD(Player, PlayerPace),
+        CM_FIELD(Player, Passing), CM_FIELD(Player, Penalties), CM_FIELD(Player, Positioning), CM_FIELD(Player, Reflexes),
+        CM_FIELD(Player, RightFoot), CM_FIELD(Player, Stamina), CM_FIELD(Player, Strength), CM_FIELD(Player, Tackling),
+        CM_FIELD(Player, Teamwork), CM_FIELD(Player, Technique), CM_FIELD(Player, ThrowIns), CM_FIELD(Player, Versatility),
+        CM_FIELD(Player, Vision), CM_FIELD(Player, WorkRate), CM_FIELD(Player, PlayerMorale),
+    };
+};
+
+template <>
+struct RecordSchema<NonPlayer> {
+    static constexpr std::string_view name = "NonPlayer";
+    static constexpr std::array fields = {
+        CM_FIELD(NonPlayer, id), CM_FIELD(NonPlayer, CurrentAbility), CM_FIELD(NonPlayer, PotentialAbility),
+        CM_FIELD(NonPlayer, HomeReputation), CM_FIELD(NonPlayer, CurrentReputation), CM_FIELD(NonPlayer, WorldReputation),
+        CM_FIELD(NonPlayer, Attacking), CM_FIELD(NonPlayer, Business), CM_FIELD(NonPlayer, Coaching), CM_FIELD(NonPlayer, CoachingGks),
+        CM_FIELD(NonPlayer, CoachingTechnique), CM_FIELD(NonPlayer, Directness), CM_FIELD(NonPlayer, Discipline),
+        CM_FIELD(NonPlayer, FreeRoles), CM_FIELD(NonPlayer, Interference), CM_FIELD(NonPlayer, Judgement),
+        CM_FIELD(NonPlayer, JudgingPotential), CM_FIELD(NonPlayer, ManHandling), CM_FIELD(NonPlayer, Marking),
+        CM_FIELD(NonPlayer, Motivating), CM_FIELD(NonPlayer, Offside), CM_FIELD(NonPlayer, Patience),
+        CM_FIELD(NonPlayer, Physiotherapy), CM_FIELD(NonPlayer, Pressing), CM_FIELD(NonPlayer, Resources),
+        CM_FIELD(NonPlayer, Tactics), CM_FIELD(NonPlayer, Youngsters), CM_FIELD(NonPlayer, Goalkeeper),
+        CM_FIELD(NonPlayer, Sweeper), CM_FIELD(NonPlayer, Defender), CM_FIELD(NonPlayer, DefensiveMidfielder),
+        CM_FIELD(NonPlayer, Midfielder), CM_FIELD(NonPlayer, AttackingMidfielder), CM_FIELD(NonPlayer, Attacker),
+        CM_FIELD(NonPlayer, WingBack), CM_FIELD(NonPlayer, FormationPreferred),
+    };
+};
+
+template <>
+struct RecordSchema<Club> {
+    static constexpr std::string_view name = "Club";
+    static constexpr std::array fields = {
+        CM_FIELD(Club, id), CM_FIELD(Club, long_name), CM_FIELD(Club, long_name_gender), CM_FIELD(Club, short_name),
+        CM_FIELD(Club, short_name_gender), CM_FIELD(Club, nation_id), CM_FIELD(Club, division_id),
+        CM_FIELD(Club, last_division_id), CM_FIELD(Club, last_position), CM_FIELD(Club, reserve_division_id),
+        CM_FIELD(Club, professional_status), CM_FIELD(Club, bank_balance), CM_FIELD(Club, stadium_id),
+        CM_FIELD(Club, owns_stadium), CM_FIELD(Club, reserve_stadium_id), CM_FIELD(Club, match_day),
+        CM_FIELD(Club, avg_attendance), CM_FIELD(Club, min_attendance), CM_FIELD(Club, max_attendance),
+        CM_FIELD(Club, training_facilities), CM_FIELD(Club, reputation), CM_FIELD(Club, is_plc),
+        CM_FIELD(Club, home_shirt_fg), CM_FIELD(Club, home_shirt_bg), CM_FIELD(Club, away_shirt_fg),
+        CM_FIELD(Club, away_shirt_bg), CM_FIELD(Club, third_shirt_fg), CM_FIELD(Club, third_shirt_bg),
+        CM_FIELD(Club, liked_staff), CM_FIELD(Club, disliked_staff), CM_FIELD(Club, rival_clubs),
+        CM_FIELD(Club, chairman_staff_id), CM_FIELD(Club, directors), CM_FIELD(Club, manager_staff_id),
+        CM_FIELD(Club, assistant_manager_staff_id), CM_FIELD(Club, playing_squad), CM_FIELD(Club, coaches),
+        CM_FIELD(Club, scouts), CM_FIELD(Club, physios), CM_FIELD(Club, euro_flag), CM_FIELD(Club, euro_seeding),
+        CM_FIELD(Club, current_squad), CM_FIELD(Club, tactics), CM_FIELD(Club, current_tactics), CM_FIELD(Club, is_linked),
+    };
+};
+
+#undef CM_FIELD
+
+// True when the fields are in offset order, leave no gap or overlap, and end
+// exactly at sizeof(T): a field missing from the table fails the build.
+template <typename T>
+consteval bool schema_tiles_record()
+{
+    std::size_t next = 0;
+    for (const auto& f : RecordSchema<T>::fields)
+    {
+        if (f.offset != next) return false;
+        next += f.width;
+    }
+    return next == sizeof(T);
+}
+
+static_assert(schema_tiles_record<Staff>());
+static_assert(schema_tiles_record<Player>());
+static_assert(schema_tiles_record<NonPlayer>());
+static_assert(schema_tiles_record<Club>());
+
+template <typename T>
+consteval std::size_t field_index(std::string_view name)
+{
+    const auto& fields = RecordSchema<T>::fields;
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        if (fields[i].name == name) return i;
+
+    throw "no such field in RecordSchema";      // not a constant expression: the build fails
+}
+
+// Compile-time lookup, e.g. schema_field<Staff>("Player").offset == 0x61.
+template <typename T>
+consteval const FieldDescriptor& schema_field(std::string_view name)
+{
+    return RecordSchema<T>::fields[field_index<T>(name)];
+}
+
+// Offsets fixed by the file format, as documented by the reverse-engineered C# model.
+static_assert(sizeof(Staff) == 0x6E);
+static_assert(schema_field<Staff>("Player").offset == 0x61);
+static_assert(schema_field<Staff>("StaffPreferences").offset == 0x65);
+static_assert(schema_field<Staff>("NonPlayer").offset == 0x69);
+static_assert(sizeof(Player) == 0x46);
+static_assert(schema_field<Player>("Goalkeeper").offset == 0x0F);
+static_assert(sizeof(NonPlayer) == 68);
+static_assert(sizeof(Club) == 581);
+static_assert(schema_field<Club>("playing_squad").offset == 215);
+
+// Run-time lookup by name, for field names that arrive as data (query strings, CLI flags).
+template <typename T>
+const FieldDescriptor* find_field(std::string_view name)
+{
+    for (const auto& f : RecordSchema<T>::fields)
+        if (f.name == name) return &f;
+
+    return nullptr;
+}
+
+// Little-endian integer of `width` bytes at `p`, sign-extended when asked.
+inline std::int64_t load_integer_le(const std::byte* p, std::size_t width, bool isSigned)
+{
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < width; ++i)
+        v |= std::to_integer<std::uint64_t>(p[i]) << (8 * i);
+
+    if (isSigned && width < 8)
+    {
+        const std::uint64_t sign = std::uint64_t{1} << (8 * width - 1);
+        v = (v ^ sign) - sign;
+    }
+    return static_cast<std::int64_t>(v);
+}
+
+// Integer field (or element `index` of an integer array) of a record.
+template <typename T>
+std::int64_t field_value(const T& rec, const FieldDescriptor& f, std::size_t index = 0)
+{
+    if (f.type != FieldType::Integer && f.type != FieldType::IntegerArray)
+        throw std::invalid_argument(std::string(f.name) + " is not an integer field");
+
+    const auto* p = reinterpret_cast<const std::byte*>(&rec) + f.offset + index * f.elementWidth;
+    return load_integer_le(p, f.elementWidth, f.isSigned);
+}
+
+template <typename T>
+std::string_view field_text(const T& rec, const FieldDescriptor& f)
+{
+    std::string_view text(reinterpret_cast<const char*>(&rec) + f.offset, f.width);
+    return text.substr(0, text.find('\0'));
+}
+
+// Host integer type of a width/signedness pair.
+template <std::size_t Width, bool Signed>
+using field_int_t = std::conditional_t<Width == 1, std::conditional_t<Signed, std::int8_t, std::uint8_t>,
+                    std::conditional_t<Width == 2, std::conditional_t<Signed, std::int16_t, std::uint16_t>,
+                                                   std::conditional_t<Signed, std::int32_t, std::uint32_t>>>;
+
+// Field handle resolved at compile time: Get() is a fixed-offset load with no
+// lookup or width dispatch, e.g. FieldAt<Staff, field_index<Staff>("Wage")>::Get(staff).
+template <typename T, std::size_t I>
+struct FieldAt {
+    static constexpr const FieldDescriptor& descriptor = RecordSchema<T>::fields[I];
+    static_assert(descriptor.type == FieldType::Integer, "FieldAt only reads integer fields");
+
+    using value_type = field_int_t<descriptor.width, descriptor.isSigned>;
+
+    static value_type Get(const T& rec)
+    {
+        value_type v;
+        std::memcpy(&v, reinterpret_cast<const std::byte*>(&rec) + descriptor.offset, sizeof(v));
+        return v;
+    }
+};
+
+// Predicate lo <= field <= hi for RecordQuery::Where and the scan executor.
+template <typename T, std::size_t I>
+auto field_between(std::int64_t lo, std::int64_t hi)
+{
+    return [lo, hi](const T& rec) {
+        const std::int64_t v = FieldAt<T, I>::Get(rec);
+        return v >= lo && v <= hi;
+    };
+}
+
+// Same predicate with the field picked at run time; the descriptor is resolved once.
+template <typename T>
+auto field_between(const FieldDescriptor& f, std::int64_t lo, std::int64_t hi)
+{
+    if (f.type != FieldType::Integer)
+        throw std::invalid_argument(std::string(f.name) + " is not an integer field");
+
+    return [offset = f.offset, width = f.elementWidth, isSigned = f.isSigned, lo, hi](const T& rec) {
+        const std::int64_t v = load_integer_le(reinterpret_cast<const std::byte*>(&rec) + offset, width, isSigned);
+        return v >= lo && v <= hi;
+    };
+}
+
+// One integer field of every record, e.g. to build a column or a histogram.
+template <typename V, typename T>
+std::vector<V> extract_column(std::span<const T> records, const FieldDescriptor& f)
+{
+    std::vector<V> column;
+    column.reserve(records.size());
+    for (const auto& rec : records) column.push_back(static_cast<V>(field_value(rec, f)));
+    return column;
+}
+
+// Reverses every multi-byte integer in place, turning records read on a
+// big-endian host into host order (or back).
+template <typename T>
+void byteswap_fields(std::span<T> records)
+{
+    auto swap_at = [](std::byte* p, std::size_t width) {
+        if (width == 2)
+        {
+            std::uint16_t v;
+            std::memcpy(&v, p, 2);
+            v = std::byteswap(v);
+            std::memcpy(p, &v, 2);
+        }
+        else if (width == 4)
+        {
+            std::uint32_t v;
+            std::memcpy(&v, p, 4);
+            v = std::byteswap(v);
+            std::memcpy(p, &v, 4);
+        }
+    };
+
+    // Field by field over the whole batch, so each pass is a simple strided loop.
+    auto* base = reinterpret_cast<std::byte*>(records.data());
+    for (const auto& f : RecordSchema<T>::fields)
+    {
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            std::byte* p = base + i * sizeof(T) + f.offset;
+            switch (f.type)
+            {
+            case FieldType::Integer:
+            case FieldType::IntegerArray:
+                for (std::size_t e = 0; e < f.Count(); ++e) swap_at(p + e * f.elementWidth, f.elementWidth);
+                break;
+            case FieldType::Date:
+                swap_at(p + offsetof(CMDate, Day), 2);
+                swap_at(p + offsetof(CMDate, Year), 2);
+                swap_at(p + offsetof(CMDate, LeapYear), 4);
+                break;
+            case FieldType::Text:
+                break;
+            }
+        }
+    }
+}
+
+// Decodes out.size() consecutive little-endian records from `bytes`: one copy
+// on little-endian hosts, plus a byteswap_fields pass on big-endian ones.
+template <typename T>
+void decode_records(std::span<const std::byte> bytes, std::span<T> out)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (bytes.size() < out.size() * sizeof(T))
+        throw std::runtime_error(std::string(RecordSchema<T>::name) + " block holds " + std::to_string(bytes.size() / sizeof(T))
+                                 + " records, " + std::to_string(out.size()) + " requested");
+
+    std::memcpy(out.data(), bytes.data(), out.size() * sizeof(T));
+
+    if constexpr (std::endian::native == std::endian::big)
+        byteswap_fields(out);
+}
+
+// "Name {\n  field=value\n ... }" for any described record.
+template <typename T>
+void print_record(std::ostream& os, const T& rec)
+{
+    os << RecordSchema<T>::name << " {\n";
+    for (const auto& f : RecordSchema<T>::fields)
+    {
+        os << "  " << f.name << '=';
+        switch (f.type)
+        {
+        case FieldType::Integer:
+            os << field_value(rec, f);
+            break;
+        case FieldType::Text:
+            os << '"' << field_text(rec, f) << '"';
+            break;
+        case FieldType::Date:
+        {
+            CMDate d;
+            std::memcpy(&d, reinterpret_cast<const std::byte*>(&rec) + f.offset, sizeof(d));
+            os << d;
+            break;
+        }
+        case FieldType::IntegerArray:
+            os << '[';
+            for (std::size_t e = 0; e < f.Count(); ++e) os << (e ? " " : "") << field_value(rec, f, e);
+            os << ']';
+            break;
+        }
+        os << '\n';
+    }
+    os << '}';
+}
@@ -1,5 +1,7 @@
+#pragma once
 #include <array>
 #include <cstdint>
+#include <string>
 
 #include "entity.h"
 
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "bitmap_index.h"
+#include "club.h"
+#include "player.h"
+#include "player_columns.h"
+#include "range_index.h"
+#include "roaring_bitmap.h"
+#include "staff.h"
+#include "staff_join.h"
+
+// Goalkeeper..FreeRole: the position ratings at the front of the attribute run.
+inline constexpr std::size_t PLAYER_POSITION_COUNT = static_cast<std::size_t>(PlayerAttribute::FreeRole) + 1;
+
+// A position rating at or above this marks a natural position.
+inline constexpr std::int8_t NATURAL_POSITION_RATING = 18;
+
+// Clauses over staff. Each non-empty list is one IN clause that matches any
+// of its values, each range one inclusive range clause (the player ones only
+// match staff with a player record); clauses are AND-ed, and no clauses match
+// every row.
+struct StaffFilter {
+    std::vector<std::int32_t> nations;
+    std::vector<std::int32_t> classifications;
+    std::vector<std::int32_t> jobsForClub;
+    std::vector<std::int32_t> playingSquads;
+    std::vector<PlayerAttribute> naturalPositions;      // Goalkeeper..FreeRole
+    std::optional<IntRange> value;
+    std::optional<IntRange> wage;
+    std::optional<IntRange> currentAbility;
+    std::optional<IntRange> potentialAbility;
+    std::optional<IntRange> worldReputation;
+    std::optional<IntRange> birthDay;               // day numbers, see day_number and age_range
+    std::optional<IntRange> clubExpiryDay;
+};
+
+// Indexes over the fields filters name, built at load time: bitmap indexes
+// for the low-cardinality ones and sorted range indexes for the numeric ones.
+// Staff and player indexes hold staff rows, club indexes club rows.
+class SecondaryIndexes {
+
+public:
+    SecondaryIndexes() = default;
+    SecondaryIndexes(std::span<const Staff> staffs, std::span<const Club> clubs, std::span<const Player> players, const StaffJoin& join);
+
+    const BitmapIndex& StaffNation() const { return m_staffNation; }
+    const BitmapIndex& StaffClassification() const { return m_staffClassification; }
+    const BitmapIndex& StaffJobForClub() const { return m_staffJobForClub; }
+    const BitmapIndex& StaffPlayingSquad() const { return m_staffPlayingSquad; }
+    const BitmapIndex& ClubDivision() const { return m_clubDivision; }
+
+    // Staff rows whose player rates NATURAL_POSITION_RATING or more at
+    // `position`; throws std::out_of_range for an attribute that is not a position.
+    const RoaringBitmap& StaffNaturalAt(PlayerAttribute position) const;
+
+    // Staff rows ordered by the field; the player ones only hold staff with a player record.
+    const RangeIndex& StaffValue() const { return m_staffValue; }
+    const RangeIndex& StaffWage() const { return m_staffWage; }
+    const RangeIndex& PlayerCurrentAbility() const { return m_playerCurrentAbility; }
+    const RangeIndex& PlayerPotentialAbility() const { return m_playerPotentialAbility; }
+    const RangeIndex& PlayerWorldReputation() const { return m_playerWorldReputation; }
+
+    // Staff rows ordered by day_number of DateOfBirth / DateExpiresClub; empty dates sort first as NO_DAY.
+    const RangeIndex& StaffBirthDay() const { return m_staffBirthDay; }
+    const RangeIndex& StaffClubExpiryDay() const { return m_staffClubExpiryDay; }
+
+    // Staff rows matching every clause of `filter`, computed from the indexes
+    // alone: each IN clause is an OR of value bitmaps, each range clause a
+    // slice of its range index, then the clauses are intersected smallest first.
+    RoaringBitmap MatchStaff(const StaffFilter& filter) const;
+
+    std::size_t ByteSize() const;
+
+    void Save(SnapshotWriter& out) const;
+    static SecondaryIndexes Load(SnapshotReader& in);
+
+private:
+    std::uint32_t m_staffCount = 0;
+    BitmapIndex m_staffNation;
+    BitmapIndex m_staffClassification;
+    BitmapIndex m_staffJobForClub;
+    BitmapIndex m_staffPlayingSquad;
+    BitmapIndex m_clubDivision;
+    std::array<RoaringBitmap, PLAYER_POSITION_COUNT> m_naturalAt;
+    RangeIndex m_staffValue;
+    RangeIndex m_staffWage;
+    RangeIndex m_playerCurrentAbility;
+    RangeIndex m_playerPotentialAbility;
+    RangeIndex m_playerWorldReputation;
+    RangeIndex m_staffBirthDay;
+    RangeIndex m_staffClubExpiryDay;
+
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One bit per row, produced by the columnar filter kernels.
+class SelectionBitmap {
+
+public: 
+    SelectionBitmap() = default;
+    explicit SelectionBitmap(std::size_t rows): m_rows(rows), m_words((rows + 63) / 64, 0) {}
+
+    std::size_t Rows() const { return m_rows; }
+
+    bool Test(std::size_t row) const { return (m_words[row / 64] >> (row % 64)) & 1u; }
+    void Set(std::size_t row) { m_words[row / 64] |= std::uint64_t{1} << (row % 64); }
+
+    std::size_t Count() const 
+    {
+        std::size_t n = 0;
+        for (auto w : m_words) n += static_cast<std::size_t>(std::popcount(w));
+        return n;
+    }
+
+    SelectionBitmap& operator&=(const SelectionBitmap& other)
+    {
+        for (std::size_t i = 0; i < m_words.size() && i < other.m_words.size(); ++i) m_words[i] &= other.m_words[i];
+        return *this;
+    }
+
+    // Calls fn(row) for every selected row in ascending order.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const 
+    {
+        for (std::size_t i = 0; i < m_words.size(); ++i)
+        {
+            for (auto w = m_words[i]; w != 0; w &= w - 1)
+                fn(i * 64 + static_cast<std::size_t>(std::countr_zero(w)));
+        }
+    }
+
+    std::vector<std::uint64_t>& Words() { return m_words; }
+    const std::vector<std::uint64_t>& Words() const { return m_words; }
+
+private: 
+    std::size_t m_rows = 0;
+    std::vector<std::uint64_t> m_words;
+
+};
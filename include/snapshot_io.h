@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Snapshot payloads are a sequence of blobs: an 8-byte length followed by the
+// raw bytes, each blob starting on a 64-byte boundary so record blocks can be
+// viewed in place from a mapped snapshot. Values are stored in host byte order.
+inline constexpr std::size_t SNAPSHOT_ALIGNMENT = 64;
+
+class SnapshotWriter {
+
+public: 
+    void WriteBytes(std::span<const std::byte> bytes)
+    {
+        const std::uint64_t length = bytes.size();
+        Append(std::as_bytes(std::span(&length, 1)));
+        Pad();
+        Append(bytes);
+        Pad();
+    }
+
+    template <typename T>
+    void Write(std::span<const T> values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(std::as_bytes(values));
+    }
+
+    template <typename T>
+    void Write(const std::vector<T>& values) { Write(std::span<const T>(values)); }
+
+    template <typename T>
+    void WriteValue(const T& value) { Write(std::span<const T>(&value, 1)); }
+
+    void WriteString(std::string_view s) { WriteBytes(std::as_bytes(std::span(s.data(), s.size()))); }
+
+    const std::vector<std::byte>& Buffer() const { return m_buffer; }
+
+private: 
+    std::vector<std::byte> m_buffer;
+
+    void Append(std::span<const std::byte> bytes) { m_buffer.insert(m_buffer.end(), bytes.begin(), bytes.end()); }
+    void Pad() { m_buffer.resize((m_buffer.size() + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT); }
+
+};
+
+class SnapshotReader {
+
+public: 
+    // `base` is the file offset of `payload`, so blob offsets can be reported in file terms.
+    SnapshotReader(std::span<const std::byte> payload, std::size_t base): m_payload(payload), m_base(base) {}
+
+    std::span<const std::byte> ReadBytes()
+    {
+        std::uint64_t length = 0;
+        Take(&length, sizeof(length));
+        Align();
+
+        if (length > m_payload.size() - m_pos) throw std::runtime_error("Snapshot blob is truncated.");
+
+        m_lastOffset = m_base + m_pos;
+        auto bytes = m_payload.subspan(m_pos, static_cast<std::size_t>(length));
+        m_pos += static_cast<std::size_t>(length);
+        Align();
+        return bytes;
+    }
+
+    // File offset of the blob returned by the last read.
+    std::size_t LastOffset() const { return m_lastOffset; }
+
+    template <typename T>
+    std::vector<T> ReadVector()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto bytes = ReadBytes();
+        if (bytes.size() % sizeof(T) != 0) throw std::runtime_error("Snapshot blob has a bad size.");
+
+        std::vector<T> values(bytes.size() / sizeof(T));
+        if (!bytes.empty()) std::memcpy(values.data(), bytes.data(), bytes.size());
+        return values;
+    }
+
+    template <typename T>
+    T ReadValue()
+    {
+        auto values = ReadVector<T>();
+        if (values.size() != 1) throw std::runtime_error("Snapshot value has a bad size.");
+        return values.front();
+    }
+
+    std::string ReadString()
+    {
+        auto bytes = ReadBytes();
+        return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+private: 
+    std::span<const std::byte> m_payload;
+    std::size_t m_base = 0;
+    std::size_t m_pos = 0;
+    std::size_t m_lastOffset = 0;
+
+    void Take(void* out, std::size_t n)
+    {
+        if (n > m_payload.size() - m_pos) throw std::runtime_error("Snapshot is truncated.");
+        std::memcpy(out, m_payload.data() + m_pos, n);
+        m_pos += n;
+    }
+
+    void Align()
+    {
+        m_pos = std::min(m_payload.size(), (m_pos + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT);
+    }
+
+};
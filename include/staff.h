@@ -1,5 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <ostream>
 
 #include "entity.h"
 
@@ -14,6 +17,54 @@ struct CMDate
 };
 #pragma pack(pop)
 
+// Day number of the empty date (year 0), below every real one.
+inline constexpr std::int32_t NO_DAY = INT32_MIN;
+
+inline std::int32_t first_day_of_year(int year)
+{
+    return std::chrono::sys_days(std::chrono::year(year) / 1 / 1).time_since_epoch().count();
+}
+
+// Days since 1970-01-01, so dates compare and subtract as plain integers.
+inline std::int32_t day_number(const CMDate& date)
+{
+    if (date.Year == 0) return NO_DAY;
+    return first_day_of_year(date.Year) + date.Day;
+}
+
+inline std::chrono::year_month_day calendar_date(const CMDate& date)
+{
+    return std::chrono::sys_days(std::chrono::days(first_day_of_year(date.Year) + date.Day));
+}
+
+// Whole years between two dates, counting a birthday on `date` as reached.
+// Month and day are compared rather than day of year, so leap days do not
+// shift birthdays; a 29 February birthday is reached on 1 March in common years.
+inline int age_on(const CMDate& birth, const CMDate& date)
+{
+    const auto b = calendar_date(birth);
+    const auto d = calendar_date(date);
+
+    int age = static_cast<int>(d.year()) - static_cast<int>(b.year());
+    if (d.month() < b.month() || (d.month() == b.month() && d.day() < b.day())) --age;
+    return age;
+}
+
+// Last birth day number that makes someone at least `age` on `date`, as
+// age_on counts it: age_on(birth, date) >= age exactly when
+// day_number(birth) <= latest_birth_day(age, date).
+inline std::int32_t latest_birth_day(int age, const CMDate& date)
+{
+    const auto d = calendar_date(date);
+    const auto birthday = (d.year() - std::chrono::years(age)) / d.month() / d.day();
+
+    // 29 February `age` years back falls in a common year: the 28th is the latest.
+    const std::chrono::sys_days latest = birthday.ok()
+        ? std::chrono::sys_days(birthday)
+        : std::chrono::sys_days(birthday.year() / birthday.month() / std::chrono::last);
+    return latest.time_since_epoch().count();
+}
+
 #pragma pack(push, 1)
 struct Staff : public Entity
 {
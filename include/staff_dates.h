@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "selection_bitmap.h"
+#include "staff.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// The CMDate fields of Staff, in record order.
+enum class StaffDate : std::uint8_t {
+    Birth, JoinedNation, ExpiresNation, JoinedClub, ExpiresClub,
+    Count
+};
+
+inline constexpr std::size_t STAFF_DATE_COUNT = static_cast<std::size_t>(StaffDate::Count);
+
+// Inclusive range predicate on one date column, in day numbers (see day_number).
+// The empty date is NO_DAY, so it only matches a range left open at the bottom.
+struct DateRange {
+    StaffDate date;
+    std::int32_t min = INT32_MIN;
+    std::int32_t max = INT32_MAX;
+};
+
+// Birth-date range of everyone aged minAge..maxAge (inclusive) on `date`, as age_on counts it.
+inline DateRange age_range(int minAge, int maxAge, const CMDate& date)
+{
+    return { StaffDate::Birth, latest_birth_day(maxAge + 1, date) + 1, latest_birth_day(minAge, date) };
+}
+
+// The staff dates as day-number columns, converted once at load time: an age
+// or contract filter becomes an integer compare over one contiguous int32
+// column instead of calendar arithmetic on 110-byte records. Indexed by staff row.
+class StaffDateColumns {
+
+public:
+    StaffDateColumns() = default;
+    explicit StaffDateColumns(std::span<const Staff> staffs);
+
+    std::size_t Size() const { return m_rows; }
+
+    std::span<const std::int32_t> Column(StaffDate date) const
+    {
+        return { m_data.data() + static_cast<std::size_t>(date) * m_stride, m_rows };
+    }
+
+    // Rows for which every range holds. An empty predicate list selects all rows.
+    SelectionBitmap Filter(std::span<const DateRange> ranges) const;
+
+    void Save(SnapshotWriter& out) const;
+    static StaffDateColumns Load(SnapshotReader& in);
+
+private:
+    std::size_t m_rows = 0;
+    std::size_t m_stride = 0;           // column length rounded up to a multiple of 64 rows
+    std::vector<std::int32_t> m_data;   // STAFF_DATE_COUNT columns back to back
+
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "staff.h"
+
+// Decodes out.size() consecutive 110-byte little-endian records from `bytes`
+// in one pass. On little-endian hosts the packed struct is the file layout,
+// so this is a single copy; big-endian hosts then swap each multi-byte field
+// listed in RecordSchema<Staff> (schema.h) over the whole batch. Throws when
+// `bytes` is too short.
+void decode_staff_block(std::span<const std::byte> bytes, std::span<Staff> out);
+
+std::vector<Staff> decode_staff_block(std::span<const std::byte> bytes);
+
+// Reverses the byte order of every multi-byte field in place; the
+// big-endian half of decode_staff_block.
+void byteswap_staff_fields(std::span<Staff> records);
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "non_player.h"
+#include "player.h"
+#include "player_columns.h"
+#include "repository.h"
+#include "staff.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// The Staff fields search filters and result lists use, stored next to the
+// player's ratings so a result row is one contiguous 88-byte read.
+struct PlayerRow {
+    std::int32_t staffId;
+    std::uint32_t staffRow;
+    std::uint32_t playerRow;
+    std::int32_t nation;
+    std::int32_t clubJob;
+    std::int32_t value;
+    std::int32_t wage;
+    std::int16_t birthYear;             // DateOfBirth.Year
+    std::int16_t currentAbility;
+    std::int16_t potentialAbility;
+    std::array<std::int8_t, PLAYER_ATTRIBUTE_COUNT> attributes;
+
+    std::int8_t Attribute(PlayerAttribute attribute) const { return attributes[static_cast<std::size_t>(attribute)]; }
+};
+static_assert(sizeof(PlayerRow) == 88);
+
+// Load-time join of the staff table with the player (type 10) and
+// non-player (type 9) blocks of staff.dat: Staff::Player and
+// Staff::NonPlayer are resolved to row numbers once instead of per lookup.
+// Everything is indexed by staff row.
+class StaffJoin {
+
+public:
+    StaffJoin() = default;
+    StaffJoin(std::span<const Staff> staffs, const Repository<Player>& players, const Repository<NonPlayer>& nonPlayers);
+
+    std::optional<std::size_t> PlayerOf(std::size_t staffRow) const { return row_of(m_playerOf, staffRow); }
+    std::optional<std::size_t> NonPlayerOf(std::size_t staffRow) const { return row_of(m_nonPlayerOf, staffRow); }
+
+    // Position of the staff member in PlayerRows().
+    std::optional<std::size_t> PlayerRowOf(std::size_t staffRow) const { return row_of(m_playerRowOf, staffRow); }
+
+    // One entry per staff member with a player record, in staff row order.
+    std::span<const PlayerRow> PlayerRows() const { return m_playerRows; }
+
+    void Save(SnapshotWriter& out) const;
+    static StaffJoin Load(SnapshotReader& in);
+
+private:
+    static constexpr std::int32_t NO_ROW = -1;
+
+    std::vector<std::int32_t> m_playerOf;
+    std::vector<std::int32_t> m_nonPlayerOf;
+    std::vector<std::int32_t> m_playerRowOf;
+    std::vector<PlayerRow> m_playerRows;
+
+    static std::optional<std::size_t> row_of(const std::vector<std::int32_t>& rows, std::size_t staffRow)
+    {
+        if (staffRow >= rows.size() || rows[staffRow] == NO_ROW) return std::nullopt;
+
+        return static_cast<std::size_t>(rows[staffRow]);
+    }
+
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "first_name.h"
+#include "repository.h"
+#include "second_name.h"
+#include "staff.h"
+
+// common_names.dat uses the same 60-byte TNames record as second_names.dat.
+using CommonName = SecondName;
+
+// The fixed 51-byte name without its NUL padding and trailing spaces.
+template <typename Names>
+inline std::string_view name_view(const Names& rec)
+{
+    std::string_view name(reinterpret_cast<const char*>(rec.Name.data()), rec.Name.size());
+    name = name.substr(0, name.find('\0'));
+    while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+    return name;
+}
+
+template <typename Names>
+inline std::string_view lookup_name(const Repository<Names>& names, std::int32_t id)
+{
+    if (id < 0) return {};
+
+    const Names* rec = names.FindById(id);
+    if (rec == nullptr) return {};
+
+    return name_view(*rec);
+}
+
+// Appends the name as the game shows it: the common name when there is one, otherwise "first second".
+inline void append_display_name(std::string& out, std::string_view common, std::string_view first, std::string_view second)
+{
+    if (!common.empty())
+    {
+        out.append(common);
+        return;
+    }
+
+    out.append(first);
+    if (!first.empty() && !second.empty()) out.push_back(' ');
+    out.append(second);
+}
+
+inline std::string staff_display_name(const Staff& s,
+                                      const Repository<FirstName>& firstNames,
+                                      const Repository<SecondName>& secondNames,
+                                      const Repository<CommonName>* commonNames = nullptr)
+{
+    std::string name;
+    append_display_name(name,
+                        commonNames != nullptr ? lookup_name(*commonNames, s.CommonName) : std::string_view{},
+                        lookup_name(firstNames, s.FirstName),
+                        lookup_name(secondNames, s.SecondName));
+    return name;
+}
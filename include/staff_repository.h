@@ -10,22 +10,37 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 
+#include "id_index.h"
+#include "lru_cache.h"
 #include "staff.h"
+#include "trigram_index.h"
 
 class StaffRepository {
 
 public: 
-    explicit StaffRepository(const std::filesystem::path& tableName);
+    // Reads the people block of `tableName`, located through the index.dat in the same directory.
+    explicit StaffRepository(const std::filesystem::path& tableName, std::size_t searchCacheBytes = DEFAULT_SEARCH_CACHE_BYTES);
 
     std::optional<Staff> GetById(int id) const; 
     std::optional<Staff> GetByName(const std::string& name) const; 
 
     std::optional<std::vector<Staff>> SearchByName(const std::string& name) const;
 
+    CacheStats SearchCacheStats() const { return m_searchCache.Stats(); }
+
+    // Staff records only hold name ids, so the caller supplies the resolution
+    // (see staff_display_name) and SearchByName stays empty until this is called.
+    using DisplayNameFn = std::function<std::string(const Staff&)>;
+    void BuildNameIndex(const DisplayNameFn& displayName);
+
 private: 
     std::filesystem::path m_tablePath; 
     std::vector<Staff> m_staffs;
+    IdIndex m_ids;
+    TrigramIndex m_nameIndex;
+    mutable ShardedLruCache<std::string, std::vector<std::uint32_t>> m_searchCache;
 
     template <typename T>
     static void dump_record_bytes(const std::filesystem::path& path, size_t idx)
@@ -108,6 +123,9 @@ private:
         return d;
     }
 
+public: 
+    // Field-by-field little-endian decode of one 110-byte record, independent
+    // of host byte order and struct packing; LazyRepository<Staff> uses it too.
     static Staff read_staff_le(std::istream& in) {
         Staff s{};
 
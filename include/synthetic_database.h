@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Row counts of a generated database at scale 1.0. The table sizes match the
+// shipped CM 01/02 index (see README.md), so scale 10 approximates a 10x larger
+// database; the employment share is a guess.
+struct SyntheticDatabaseOptions {
+    double scale = 1.0;
+    std::uint64_t seed = 2001;
+
+    std::size_t clubs = 10580;
+    std::size_t staffs = 132722;
+    double playerShare = 0.828;         // of staffs that get a Player row
+    double nonPlayerShare = 0.172;      // of staffs that get a NonPlayer row; disjoint from the players
+    double employedShare = 0.7;         // of staffs that are offered a club slot
+    std::size_t nations = 213;
+    std::size_t divisions = 390;
+    std::size_t firstNames = 34363;
+    std::size_t secondNames = 82338;
+    std::size_t commonNames = 8493;
+};
+
+struct SyntheticDatabaseSummary {
+    std::size_t clubs = 0;
+    std::size_t staffs = 0;
+    std::size_t players = 0;
+    std::size_t nonPlayers = 0;
+    std::size_t bytes = 0;              // written across all files
+};
+
+// Writes index.dat, club.dat, staff.dat (people, non-player, player and
+// preference blocks) and the three name tables into `dir`, laid out exactly
+// as Database::Load expects them. The same options and seed always produce
+// byte-identical files.
+SyntheticDatabaseSummary write_synthetic_database(const std::filesystem::path& dir,
+                                                  const SyntheticDatabaseOptions& options = {});
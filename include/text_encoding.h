@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// The .dat name tables are Windows-1252; anything leaving the process (JSON,
+// HTTP) is UTF-8. Bytes 0x80..0x9F are the only ones that differ from Latin-1.
+inline constexpr std::array<char16_t, 32> CP1252_HIGH = {
+    0x20AC, 0xFFFD, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0xFFFD, 0x017D, 0xFFFD,
+    0xFFFD, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0xFFFD, 0x017E, 0x0178
+};
+
+inline void append_utf8(std::string& out, char32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out.push_back(static_cast<char>(cp));
+    }
+    else if (cp < 0x800)
+    {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000)
+    {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Length of the well-formed UTF-8 sequence `text` starts with, or 0 when it is
+// malformed, overlong, a surrogate or above U+10FFFF.
+inline std::size_t utf8_sequence_length(std::string_view text)
+{
+    if (text.empty()) return 0;
+
+    const auto lead = static_cast<unsigned char>(text[0]);
+    const std::size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || length > text.size()) return 0;
+
+    char32_t cp = length == 1 ? lead : lead & (0x7F >> length);
+    for (std::size_t k = 1; k < length; ++k)
+    {
+        const auto cont = static_cast<unsigned char>(text[k]);
+        if ((cont & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (cont & 0x3F);
+    }
+
+    static constexpr char32_t MIN_CODE_POINT[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    if (cp < MIN_CODE_POINT[length] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+
+    return length;
+}
+
+inline std::string cp1252_to_utf8(std::string_view text)
+{
+    std::string res;
+    res.reserve(text.size());
+    for (unsigned char ch : text)
+    {
+        if (ch >= 0x80 && ch < 0xA0) append_utf8(res, CP1252_HIGH[ch - 0x80]);
+        else append_utf8(res, ch);
+    }
+    return res;
+}
+
+// Code points with no Windows-1252 byte, and malformed sequences, become '?'.
+inline std::string utf8_to_cp1252(std::string_view text)
+{
+    std::string res;
+    res.reserve(text.size());
+    for (std::size_t i = 0; i < text.size();)
+    {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        const std::size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        if (length == 0 || i + length > text.size())
+        {
+            res.push_back('?');
+            ++i;
+            continue;
+        }
+
+        char32_t cp = length == 1 ? lead : lead & (0x7F >> length);
+        bool valid = true;
+        for (std::size_t k = 1; k < length; ++k)
+        {
+            const auto cont = static_cast<unsigned char>(text[i + k]);
+            valid = valid && (cont & 0xC0) == 0x80;
+            cp = (cp << 6) | (cont & 0x3F);
+        }
+        i += valid ? length : 1;
+
+        if (!valid)
+        {
+            res.push_back('?');
+        }
+        else if (cp < 0x80 || (cp >= 0xA0 && cp < 0x100))
+        {
+            res.push_back(static_cast<char>(cp));
+        }
+        else
+        {
+            char mapped = '?';
+            for (std::size_t k = 0; k < CP1252_HIGH.size(); ++k)
+                if (CP1252_HIGH[k] == cp && cp != 0xFFFD) mapped = static_cast<char>(0x80 + k);
+            res.push_back(mapped);
+        }
+    }
+    return res;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from one FIFO queue.
+class ThreadPool {
+
+public: 
+    // threads == 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto Submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+
+        std::packaged_task<R()> task(std::forward<F>(fn));
+        auto future = task.get_future();
+        {
+            std::lock_guard lock(m_mutex);
+            m_tasks.emplace_back(std::move(task));
+        }
+        m_cv.notify_one();
+        return future;
+    }
+
+    std::size_t Size() const { return m_workers.size(); }
+
+private: 
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::move_only_function<void()>> m_tasks;
+    bool m_stop = false;
+    std::vector<std::thread> m_workers;
+
+    void WorkerLoop();
+
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "metrics.h"
+#include "scan_executor.h"
+#include "thread_pool.h"
+
+struct ScoredRow {
+    std::size_t row;
+    double score;
+};
+
+// Ranking order: higher score first, lower row first on ties, so results are
+// the same however the rows were split between threads.
+struct ScoreOrder {
+    constexpr bool operator()(const ScoredRow& a, const ScoredRow& b) const
+    {
+        return a.score > b.score || (a.score == b.score && a.row < b.row);
+    }
+};
+
+// Keeps the best K rows pushed so far in a min-heap of at most K entries:
+// the worst kept row sits on top and is the admission threshold.
+class TopKHeap {
+
+public:
+    explicit TopKHeap(std::size_t k): m_k(k) { m_heap.reserve(k); }
+
+    void Push(const ScoredRow& candidate)
+    {
+        if (m_heap.size() < m_k)
+        {
+            m_heap.push_back(candidate);
+            std::ranges::push_heap(m_heap, ScoreOrder{});
+        }
+        else if (m_k != 0 && ScoreOrder{}(candidate, m_heap.front()))
+        {
+            std::ranges::pop_heap(m_heap, ScoreOrder{});
+            m_heap.back() = candidate;
+            std::ranges::push_heap(m_heap, ScoreOrder{});
+        }
+    }
+
+    void Merge(const TopKHeap& other)
+    {
+        for (const auto& candidate : other.m_heap) Push(candidate);
+    }
+
+    std::size_t Size() const { return m_heap.size(); }
+
+    // Best first; only the K kept rows are sorted.
+    std::vector<ScoredRow> Sorted() &&
+    {
+        std::ranges::sort_heap(m_heap, ScoreOrder{});
+        return std::move(m_heap);
+    }
+
+private:
+    std::size_t m_k;
+    std::vector<ScoredRow> m_heap;
+
+};
+
+inline constexpr std::size_t TOP_K_MORSEL_ROWS = 16384;
+
+// Best `k` of rows [0, rowCount) by `score(row)`, which returns std::nullopt
+// for rows that do not qualify. With a pool, morsels of rows are scored by a
+// ScanExecutor into one bounded heap per morsel that are merged at the end;
+// no row is copied and nothing but the K winners is ever sorted.
+template <typename Score>
+std::vector<ScoredRow> top_k(std::size_t rowCount, std::size_t k, Score score,
+                             ThreadPool* pool = nullptr, std::size_t morselRows = TOP_K_MORSEL_ROWS)
+{
+    CM_TIME_SCOPE("cm_query_seconds", "type=\"top_k\"");
+
+    auto scan = [&score, k](std::size_t begin, std::size_t end) {
+        TopKHeap heap(k);
+        for (std::size_t row = begin; row < end; ++row)
+        {
+            std::optional<double> s = std::invoke(score, row);
+            if (s.has_value()) heap.Push({ row, *s });
+        }
+        return heap;
+    };
+
+    if (k == 0 || rowCount == 0) return {};
+
+    if (pool == nullptr || rowCount <= morselRows)
+        return scan(0, rowCount).Sorted();
+
+    std::vector<std::optional<TopKHeap>> parts((rowCount + morselRows - 1) / morselRows);
+    ScanExecutor(*pool).ForEachMorsel(rowCount, morselRows, [&](std::size_t begin, std::size_t end, std::size_t morsel) {
+        parts[morsel] = scan(begin, end);
+    });
+
+    TopKHeap result(k);
+    for (const auto& part : parts) result.Merge(*part);
+    return std::move(result).Sorted();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Case-folded trigram inverted index answering "contains" queries.
+// Each document can carry several texts (e.g. a club's short and long name).
+// Texts are folded once at build time; a query intersects the posting lists of
+// its trigrams and only verifies the surviving candidates.
+class TrigramIndex {
+
+public: 
+    void Add(std::uint32_t doc, std::string_view text);
+
+    // Must be called once after the last Add and before searching.
+    void Finalize();
+
+    // Sorted ids of the documents with a text containing `needle`, ignoring
+    // case. A needle that folds to fewer than 3 characters has no trigram to
+    // look up, so it falls back to checking every document's texts (linear in
+    // the index size, and the result can be most of the documents); an empty
+    // one returns every document. Callers that search per keystroke should
+    // wait for 3 characters or cache the short needles, as the repositories'
+    // SearchByName caches do.
+    std::vector<std::uint32_t> Search(std::string_view needle) const;
+
+    std::size_t DocumentCount() const { return m_docCount; }
+
+    static unsigned char fold_case(unsigned char ch);
+
+    // Case-folded copy of `text`, exactly as Search matches it, so two search
+    // strings with the same fold have the same results.
+    static std::string fold(std::string_view text);
+
+private: 
+    struct Text {
+        std::uint32_t doc;
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    std::string m_arena;            // folded texts back to back
+    std::vector<Text> m_texts;      // sorted by doc after Finalize
+    std::vector<std::uint32_t> m_docs;
+
+    // CSR posting lists: m_keys[i] owns m_postings[m_offsets[i] .. m_offsets[i + 1])
+    std::vector<std::uint32_t> m_keys;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<std::uint32_t> m_postings;
+    std::size_t m_docCount = 0;
+
+    bool TextsContain(std::uint32_t doc, std::string_view folded) const;
+    static std::uint32_t key_of(const char* p);
+
+};
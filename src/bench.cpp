@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <spanstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "club_repository.h"
+#include "database.h"
+#include "lazy_repository.h"
+#include "metrics.h"
+#include "player_columns.h"
+#include "player_search.h"
+#include "player_similarity.h"
+#include "scan_executor.h"
+#include "secondary_indexes.h"
+#include "staff_dates.h"
+#include "staff_decoder.h"
+#include "synthetic_database.h"
+#include "thread_pool.h"
+#include "trigram_index.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+// Results are folded into this so the optimizer cannot drop the measured work.
+static volatile std::uint64_t g_sink = 0;
+
+struct BenchOptions {
+    fs::path dataDir;
+    double scale = 1.0;
+    size_t repeats = 5;
+    bool metrics = false;
+};
+
+// Runs `body` `repeats` times after one warm-up; each run performs `ops`
+// operations and the report shows the median and best run. A scan counts
+// every row it visits; an index probe, which skips most rows, counts as one.
+static void run(std::string_view name, size_t repeats, size_t ops, const std::function<std::uint64_t()>& body)
+{
+    g_sink = g_sink + body();
+
+    std::vector<double> seconds;
+    seconds.reserve(repeats);
+    for (size_t i = 0; i < repeats; ++i)
+    {
+        const auto start = Clock::now();
+        g_sink = g_sink + body();
+        seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    std::ranges::sort(seconds);
+
+    const double median = seconds[seconds.size() / 2];
+    const double best = seconds.front();
+
+    std::cout << std::left << std::setw(36) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3) << median * 1e3 << " ms"
+              << std::setw(12) << best * 1e3 << " ms"
+              << std::setw(14) << std::setprecision(1) << median * 1e9 / static_cast<double>(ops) << " ns/op\n";
+}
+
+static void usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0 << " [data-dir] [--scale X] [--repeats N] [--metrics]\n"
+              << "Without a data-dir a synthetic database of the given scale is generated\n"
+              << "under the system temp directory and reused by later runs.\n"
+              << "--metrics keeps the built-in instrumentation on and prints its latency report.\n";
+}
+
+static constexpr double MAX_SCALE = 1000.0;
+static constexpr std::size_t MAX_REPEATS = 1'000'000;
+
+// Whole-string parses; std::nullopt for anything else or a value outside (0, max].
+template <typename T>
+static std::optional<T> parse_positive(std::string_view text, T max)
+{
+    T value{};
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size() || text.empty()) return std::nullopt;
+    if (!(value > T{}) || value > max) return std::nullopt;
+
+    return value;
+}
+
+static bool parse_args(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--scale" && i + 1 < argc)
+        {
+            const auto scale = parse_positive(argv[++i], MAX_SCALE);
+            if (!scale.has_value()) return false;
+            options.scale = *scale;
+        }
+        else if (arg == "--repeats" && i + 1 < argc)
+        {
+            const auto repeats = parse_positive(argv[++i], MAX_REPEATS);
+            if (!repeats.has_value()) return false;
+            options.repeats = *repeats;
+        }
+        else if (arg == "--metrics")
+            options.metrics = true;
+        else if (!arg.starts_with("--") && options.dataDir.empty())
+            options.dataDir = arg;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    BenchOptions options;
+    if (!parse_args(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Timings are measured without instrumentation unless asked for.
+    MetricsRegistry::SetEnabled(options.metrics);
+
+    if (options.dataDir.empty())
+    {
+        options.dataDir = fs::temp_directory_path() / ("cm-bench-" + std::to_string(options.scale));
+        if (!fs::exists(options.dataDir / "index.dat"))
+        {
+            SyntheticDatabaseOptions gen;
+            gen.scale = options.scale;
+            const auto summary = write_synthetic_database(options.dataDir, gen);
+            std::cout << "Generated " << summary.staffs << " staff, " << summary.clubs << " clubs ("
+                      << summary.bytes / (1024 * 1024) << " MiB) in " << options.dataDir.string() << "\n";
+        }
+    }
+
+    std::cout << "Data: " << options.dataDir.string() << "\n\n"
+              << std::left << std::setw(36) << "benchmark" << std::right
+              << std::setw(15) << "median" << std::setw(15) << "best" << std::setw(20) << "per op\n";
+
+    const size_t repeats = options.repeats;
+
+    // Load
+    run("load (copy)", repeats, 1, [&]{
+        return Database::Load(options.dataDir, { .mode = LoadMode::Copy })->Staffs().Size();
+    });
+    run("load (mapped)", repeats, 1, [&]{
+        return Database::Load(options.dataDir, { .mode = LoadMode::Mapped })->Staffs().Size();
+    });
+
+    auto db = Database::Load(options.dataDir);
+
+    // What a CLI tool pays to open staff.dat and read a handful of records.
+    const Index people = *db->FindIndex("staff.dat", static_cast<std::uint32_t>(StaffBlock::People));
+    run("lazy staff open + 50 lookups", repeats, 1, [&]{
+        LazyRepository<Staff> staffs(options.dataDir / "staff.dat", people.offset, people.table_size);
+        std::uint64_t sum = 0;
+        for (std::int32_t id = 0; id < 50; ++id)
+            if (auto s = staffs.FindById(id * 97)) sum += static_cast<std::uint32_t>(s->Value);
+        return sum;
+    });
+
+    // Decoding the people block: per-field stream reads vs one bulk decode.
+    const auto peopleBytes = std::as_bytes(db->Staffs().Records());
+    run("staff decode (read_staff_le)", repeats, db->Staffs().Size(), [&]{
+        std::ispanstream in(std::span<const char>(reinterpret_cast<const char*>(peopleBytes.data()), peopleBytes.size()));
+        std::uint64_t sum = 0;
+        for (size_t i = 0; i < db->Staffs().Size(); ++i) sum += static_cast<std::uint32_t>(StaffRepository::read_staff_le(in).Value);
+        return sum;
+    });
+    run("staff decode (bulk)", repeats, db->Staffs().Size(), [&]{
+        return static_cast<std::uint64_t>(decode_staff_block(peopleBytes).size());
+    });
+
+    // Point lookups, ids drawn up front so the generator is not measured.
+    constexpr size_t LOOKUPS = 1'000'000;
+    std::mt19937_64 rng(42);
+    std::vector<std::int32_t> staffIds(LOOKUPS);
+    const auto staffRecords = db->Staffs().Records();
+    for (auto& id : staffIds)
+        id = staffRecords[rng() % staffRecords.size()].id;
+
+    run("staff FindById", repeats, LOOKUPS, [&]{
+        std::uint64_t sum = 0;
+        for (auto id : staffIds)
+            if (const Staff* s = db->Staffs().FindById(id)) sum += static_cast<std::uint32_t>(s->Wage);
+        return sum;
+    });
+    run("staff display name by id", repeats, LOOKUPS, [&]{
+        std::uint64_t sum = 0;
+        for (auto id : staffIds) sum += db->StaffNames().GetById(id).size();
+        return sum;
+    });
+
+    // Name search
+    const std::array<std::string_view, 6> needles = { "ma", "ro", "mar", "tino", "M\xFC", "zzz" };
+
+    // A zero-byte cache keeps nothing, so that run measures the index itself.
+    ClubRepository uncachedClubs(options.dataDir / "club.dat", 0);
+    ClubRepository clubs(options.dataDir / "club.dat");
+    run("club name search", repeats, needles.size(), [&]{
+        std::uint64_t sum = 0;
+        for (auto needle : needles)
+            if (auto hits = uncachedClubs.SearchByName(std::string(needle))) sum += hits->size();
+        return sum;
+    });
+    run("club name search (cached)", repeats, needles.size(), [&]{
+        std::uint64_t sum = 0;
+        for (auto needle : needles)
+            if (auto hits = clubs.SearchByName(std::string(needle))) sum += hits->size();
+        return sum;
+    });
+
+    TrigramIndex staffNameIndex;
+    for (size_t row = 0; row < db->StaffNames().Size(); ++row)
+        staffNameIndex.Add(static_cast<std::uint32_t>(row), db->StaffNames().GetByRow(row));
+    staffNameIndex.Finalize();
+
+    run("staff name search", repeats, needles.size(), [&]{
+        std::uint64_t sum = 0;
+        for (auto needle : needles) sum += staffNameIndex.Search(needle).size();
+        return sum;
+    });
+
+    const std::array<std::string_view, 5> fuzzyNeedles = { "muller", "Mueller", "M\xFClller", "rodriguez", "silva" };
+    run("staff fuzzy name search", repeats, fuzzyNeedles.size(), [&]{
+        std::uint64_t sum = 0;
+        for (auto needle : fuzzyNeedles) sum += db->StaffNameIndex().Search(needle).size();
+        return sum;
+    });
+
+    // Full-table scans, single-threaded and on the morsel executor.
+    ThreadPool pool;
+    const ScanExecutor executor(pool);
+    auto wealthyVeteran = [](const Staff& s){ return s.Value > 1'000'000 && s.DateOfBirth.Year < 1970; };
+
+    run("staff scan (serial)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->Staffs().Query().Where(wealthyVeteran).Count());
+    });
+    run("staff scan (executor)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->Staffs().Query().Where(wealthyVeteran).Count(executor));
+    });
+
+    // Multi-clause equality filter: nation IN (3 values) AND job AND natural striker or winger.
+    StaffFilter staffFilter;
+    staffFilter.nations = { 1, 2, 3 };
+    staffFilter.jobsForClub = { 1 };
+    staffFilter.naturalPositions = { PlayerAttribute::Attacker, PlayerAttribute::WingBack };
+    run("staff filter (row scan)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->Staffs().Query().Where([&](const Staff& s) {
+            if (s.Nation < 1 || s.Nation > 3 || s.JobForClub != 1) return false;
+            const auto row = static_cast<std::size_t>(&s - staffRecords.data());
+            const auto playerRow = db->Joined().PlayerRowOf(row);
+            if (!playerRow.has_value()) return false;
+            const PlayerRow& pr = db->Joined().PlayerRows()[*playerRow];
+            return pr.Attribute(PlayerAttribute::Attacker) >= NATURAL_POSITION_RATING
+                || pr.Attribute(PlayerAttribute::WingBack) >= NATURAL_POSITION_RATING;
+        }).Count());
+    });
+    run("staff filter (bitmaps)", repeats, 1, [&]{
+        return static_cast<std::uint64_t>(db->Secondary().MatchStaff(staffFilter).Cardinality());
+    });
+
+    // Range query and ordered scan: staff valued 1M-5M, and the 50 most valuable.
+    const IntRange valueRange{ 1'000'000, 5'000'000 };
+    run("staff value range (row scan)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->Staffs().Query()
+            .Where([&](const Staff& s){ return s.Value >= valueRange.min && s.Value <= valueRange.max; })
+            .Count());
+    });
+    run("staff value range (range index)", repeats, 1, [&]{
+        return static_cast<std::uint64_t>(db->Secondary().StaffValue().Between(valueRange).size());
+    });
+    run("top 50 staff by value (sort)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->Staffs().Query().OrderByDescending([](const Staff& s){ return s.Value; }).Limit(50).Rows().size());
+    });
+    run("top 50 staff by value (range index)", repeats, 1, [&]{
+        const auto rows = db->Secondary().StaffValue().Rows();
+        std::uint64_t sum = 0;
+        const auto last = rows.rbegin() + static_cast<std::ptrdiff_t>(std::min<std::size_t>(50, rows.size()));
+        for (auto it = rows.rbegin(); it != last; ++it) sum += *it;
+        return sum;
+    });
+
+    // Scouting dates: aged 20-25 today with a club contract running out by the end of next year.
+    const CMDate scoutingDay{ 180, 2001, 0 };
+    const std::int32_t expiryLimit = day_number(CMDate{ 364, 2002, 0 });
+    const std::array<DateRange, 2> dateRanges = {{
+        age_range(20, 25, scoutingDay),
+        { StaffDate::ExpiresClub, day_number(scoutingDay), expiryLimit },
+    }};
+
+    run("staff age + expiry (row scan)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->Staffs().Query().Where([&](const Staff& s) {
+            const int age = age_on(s.DateOfBirth, scoutingDay);
+            const std::int32_t expires = day_number(s.DateExpiresClub);
+            return age >= 20 && age <= 25 && expires >= day_number(scoutingDay) && expires <= expiryLimit;
+        }).Count());
+    });
+    run("staff age + expiry (date columns)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(db->StaffDates().Filter(dateRanges).Count());
+    });
+    StaffFilter dateFilter;
+    dateFilter.birthDay = IntRange{ dateRanges[0].min, dateRanges[0].max };
+    dateFilter.clubExpiryDay = IntRange{ dateRanges[1].min, dateRanges[1].max };
+    run("staff age + expiry (range indexes)", repeats, 1, [&]{
+        return static_cast<std::uint64_t>(db->Secondary().MatchStaff(dateFilter).Cardinality());
+    });
+
+    // Attribute filtering
+    const auto players = db->Players().Records();
+    const std::array<AttributeRange, 3> ranges = {{
+        { PlayerAttribute::Finishing, 15 },
+        { PlayerAttribute::PlayerPace, 14 },
+        { PlayerAttribute::Dirtiness, INT8_MIN, 8 },
+    }};
+
+    run("player filter (row scan)", repeats, players.size(), [&]{
+        return static_cast<std::uint64_t>(db->Players().Query()
+            .Where([](const Player& p){ return p.Finishing >= 15 && p.PlayerPace >= 14 && p.Dirtiness <= 8; })
+            .Count());
+    });
+
+    const PlayerColumns columns(players);
+    run("player filter (columns)", repeats, players.size(), [&]{
+        return static_cast<std::uint64_t>(columns.Filter(ranges).Count());
+    });
+
+    // Ranked search: best 50 under-21s of one nation by a weighted attribute score.
+    const std::array<AttributeWeight, 3> weights = {{
+        { PlayerAttribute::Finishing, 2.0 },
+        { PlayerAttribute::PlayerPace, 1.5 },
+        { PlayerAttribute::Movement, 1.0 },
+    }};
+    const CMDate today{ 0, 2001, 0 };
+    auto scouting = [&](const Staff& s, const Player& p) -> std::optional<double> {
+        if (s.Nation >= 20 || age_on(s.DateOfBirth, today) >= 21) return std::nullopt;
+        return weighted_score(p, weights);
+    };
+
+    run("top 50 players (serial)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(top_players(*db, 50, scouting).size());
+    });
+
+    run("top 50 players (pool)", repeats, staffRecords.size(), [&]{
+        return static_cast<std::uint64_t>(top_players(*db, 50, scouting, &pool).size());
+    });
+
+    // Similarity search: the 10 players nearest one player's attribute profile,
+    // alone and among the age + expiry matches above.
+    const auto playerRows = db->Joined().PlayerRows();
+    const PlayerSimilarity similarity(*db, static_cast<std::size_t>(std::sqrt(static_cast<double>(playerRows.size()))), &pool);
+    const auto likeTarget = similarity.TargetOf(playerRows[playerRows.size() / 2].staffId);
+    const RoaringBitmap scoutingRows = db->Secondary().MatchStaff(dateFilter);
+
+    run("players like X (exact L2)", repeats, playerRows.size(), [&]{
+        return static_cast<std::uint64_t>(similarity.Nearest(*likeTarget, { 10, SimilarityMetric::WeightedL2 }).size());
+    });
+    run("players like X (exact cosine)", repeats, playerRows.size(), [&]{
+        return static_cast<std::uint64_t>(similarity.Nearest(*likeTarget, { 10, SimilarityMetric::Cosine }).size());
+    });
+    run("players like X (filtered)", repeats, 1, [&]{
+        return static_cast<std::uint64_t>(similarity.Nearest(*likeTarget, { 10, SimilarityMetric::WeightedL2, &scoutingRows }).size());
+    });
+    run("players like X (IVF, 8 probes)", repeats, 1, [&]{
+        return static_cast<std::uint64_t>(similarity.Nearest(*likeTarget, { 10, SimilarityMetric::WeightedL2, nullptr, 8 }).size());
+    });
+
+    if (options.metrics)
+    {
+        std::cout << "\n";
+        metrics().WriteText(std::cout);
+    }
+
+    return 0;
+}
@@ -5,12 +5,8 @@
 
 #include "club_repository.h"
 
-// index offset and lazy deserialize. 
-// normally, in this implementation one time indexing offsets should be done 
-// and then the deserialization for only the offset 
-// think about thread safety as well
-// additionally add a small LRU cache 
-ClubRepository::ClubRepository(const std::filesystem::path& tableName): m_tablePath(tableName) 
+ClubRepository::ClubRepository(const std::filesystem::path& tableName, std::size_t searchCacheBytes)
+    : m_tablePath(tableName), m_searchCache(searchCacheBytes)
 {
     std::ifstream in(m_tablePath, std::ios::binary);
     if (!in) throw std::runtime_error("Failed to open: " + m_tablePath.string());
@@ -34,15 +30,24 @@ ClubRepository::ClubRepository(const std::filesystem::path& tableName): m_tableP
         if (!in) throw std::runtime_error("Read error while reading record " + std::to_string(i));
         m_clubs[i] = rec;
     }
+
+    m_ids = IdIndex::Build(m_clubs, [](const Club& club){ return club.id; });
+
+    for (size_t i = 0; i < m_clubs.size(); ++i) {
+        const auto& club = m_clubs[i];
+        m_nameIndex.Add(static_cast<std::uint32_t>(i), std::string_view(club.short_name.data(), club.short_name.size()));
+        m_nameIndex.Add(static_cast<std::uint32_t>(i), std::string_view(club.long_name.data(), club.long_name.size()));
+    }
+    m_nameIndex.Finalize();
 }
 
 std::optional<Club> ClubRepository::GetById(int id) const 
 {
-    auto it = std::ranges::find_if(m_clubs, [&](const auto& club){ return id == club.id; });
-    if (it == m_clubs.end())
+    auto row = m_ids.Find(id);
+    if (!row.has_value())
         return std::nullopt;
 
-    return *it;
+    return m_clubs[*row];
 }
 
 std::optional<Club> ClubRepository::GetByName(const std::string& name) const
@@ -54,23 +59,18 @@ std::optional<Club> ClubRepository::GetByName(const std::string& name) const
     return *it;
 } 
 
-static std::string to_lower(std::string s) {
-    for (auto& ch : s) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-    return s;
-}
-
+// Matches against both the short and the long name.
 std::optional<std::vector<Club>> ClubRepository::SearchByName(const std::string& name) const
 {
     std::vector<Club> res; 
 
-    for (const auto& club : m_clubs) 
-    {
-        auto clubName = to_lower(fixed_cstr_to_string(club.short_name.data(), club.short_name.size()));
+    const std::string key = TrigramIndex::fold(name);
+    auto rows = m_searchCache.GetOrCompute(key, [&]{ return m_nameIndex.Search(key); });
 
-        if (clubName.contains(to_lower(name)))
-        {
-            res.push_back(club);
-        }
+    res.reserve(rows->size());
+    for (auto row : *rows) 
+    {
+        res.push_back(m_clubs[row]);
     }
 
     if (res.size() == 0) 
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <utility>
+
+#include "database.h"
+#include "metrics.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+static std::optional<Index> find_entry(std::span<const Index> entries,
+                                       std::string_view fileName,
+                                       std::optional<std::uint32_t> type = std::nullopt)
+{
+    auto it = std::ranges::find_if(entries, [&](const Index& idx) {
+        return index_file_name(idx) == fileName && (!type || index_block_type(idx) == *type);
+    });
+    if (it == entries.end())
+        return std::nullopt;
+
+    return *it;
+}
+
+static Index require_staff_block(std::span<const Index> entries, StaffBlock block)
+{
+    auto entry = find_entry(entries, "staff.dat", static_cast<std::uint32_t>(block));
+    if (!entry.has_value() || entry->table_size == 0)
+        throw std::runtime_error("index.dat has no staff.dat block of type " + std::to_string(static_cast<std::uint32_t>(block)));
+
+    return *entry;
+}
+
+// Blocks carry no record size, so a block ends where the next staff.dat block (or the file) starts.
+static size_t staff_block_end(std::span<const Index> entries, size_t begin, size_t fileSize)
+{
+    size_t end = fileSize;
+    for (const auto& idx : entries)
+    {
+        if (index_file_name(idx) == "staff.dat" && idx.offset > begin)
+            end = std::min<size_t>(end, idx.offset);
+    }
+    return end;
+}
+
+// A stand-alone table file; index.dat supplies its record count when it lists it.
+template <typename T>
+static std::future<Repository<T>> load_table(ThreadPool& pool, fs::path path, std::optional<Index> entry, LoadMode mode)
+{
+    return pool.Submit([path = std::move(path), entry, mode] {
+        const size_t offset = entry ? entry->offset : 0;
+        const size_t count = entry ? entry->table_size : 0;
+        return Repository<T>(path, offset, count, mode);
+    });
+}
+
+static FuzzyIndex build_staff_name_index(std::span<const Staff> staffs,
+                                         const NameTable& firstNames,
+                                         const NameTable& secondNames,
+                                         const NameTable* commonNames)
+{
+    FuzzyIndex index;
+    for (std::size_t row = 0; row < staffs.size(); ++row)
+    {
+        const auto doc = static_cast<std::uint32_t>(row);
+        index.Add(doc, firstNames.GetById(staffs[row].FirstName));
+        index.Add(doc, secondNames.GetById(staffs[row].SecondName));
+        if (commonNames != nullptr) index.Add(doc, commonNames->GetById(staffs[row].CommonName));
+    }
+    index.Finalize();
+    return index;
+}
+
+static FuzzyIndex build_club_name_index(std::span<const Club> clubs)
+{
+    FuzzyIndex index;
+    for (std::size_t row = 0; row < clubs.size(); ++row)
+    {
+        const auto doc = static_cast<std::uint32_t>(row);
+        index.Add(doc, std::string_view(clubs[row].short_name.data(), clubs[row].short_name.size()));
+        index.Add(doc, std::string_view(clubs[row].long_name.data(), clubs[row].long_name.size()));
+    }
+    index.Finalize();
+    return index;
+}
+
+template <typename T>
+static std::future<Repository<T>> load_staff_block(ThreadPool& pool, std::shared_ptr<const MappedFile> file, Index entry, LoadMode mode)
+{
+    return pool.Submit([file = std::move(file), entry, mode] {
+        if (mode == LoadMode::Mapped)
+            return Repository<T>(file, entry.offset, entry.table_size);
+
+        return Repository<T>(file->Path(), entry.offset, entry.table_size, LoadMode::Copy);
+    });
+}
+
+std::shared_ptr<const Database> Database::Load(const fs::path& dataDir, const DatabaseOptions& options)
+{
+    constexpr size_t INDEX_HEADER_OFFSET = 8;
+
+    CM_TIME_SCOPE("cm_load_seconds", "step=\"total\"");
+
+    // Taken before reading anything, so a file replaced mid-load invalidates the snapshot.
+    std::string sources = SourceFingerprint(dataDir, options);
+
+    Repository<Index> indexes(dataDir / options.indexFile, INDEX_HEADER_OFFSET, 0, options.mode);
+    const auto entries = indexes.Records();
+
+    const Index people      = require_staff_block(entries, StaffBlock::People);
+    const Index nonPlayers  = require_staff_block(entries, StaffBlock::NonPlayers);
+    const Index players     = require_staff_block(entries, StaffBlock::Players);
+    const auto preferences  = find_entry(entries, "staff.dat", static_cast<std::uint32_t>(StaffBlock::Preferences));
+
+    // Mapping is lazy, so this costs nothing until a block is touched; the
+    // preferences block is always viewed through it.
+    auto staffFile = std::make_shared<const MappedFile>(dataDir / "staff.dat");
+
+    // Declared before the pool so that, if a task throws, the pool drains the
+    // derived-phase tasks still reading it before it is destroyed.
+    std::optional<Tables> loaded;
+    ThreadPool pool(options.threads);
+
+#if CM_METRICS
+    // Table reads run concurrently, so phases are timed as wall-clock steps of the whole load.
+    std::optional<ScopedTimer> step(std::in_place, metrics().GetHistogram("cm_load_seconds", "step=\"tables\""));
+#endif
+
+    auto clubs       = load_table<Club>(pool, dataDir / "club.dat", find_entry(entries, "club.dat"), options.mode);
+    auto firstNames  = load_table<FirstName>(pool, dataDir / "first_names.dat", find_entry(entries, "first_names.dat"), options.mode);
+    auto secondNames = load_table<SecondName>(pool, dataDir / "second_names.dat", find_entry(entries, "second_names.dat"), options.mode);
+
+    std::optional<std::future<Repository<CommonName>>> commonNames;
+    if (fs::exists(dataDir / "common_names.dat"))
+        commonNames = load_table<CommonName>(pool, dataDir / "common_names.dat", find_entry(entries, "common_names.dat"), options.mode);
+
+    auto staffs      = load_staff_block<Staff>(pool, staffFile, people, options.mode);
+    auto nonPlayerDb = load_staff_block<NonPlayer>(pool, staffFile, nonPlayers, options.mode);
+    auto playerDb    = load_staff_block<Player>(pool, staffFile, players, options.mode);
+
+    std::span<const std::byte> preferenceBytes;
+    if (preferences.has_value())
+    {
+        const size_t begin = preferences->offset;
+        const size_t end = staff_block_end(entries, begin, staffFile->Size());
+        preferenceBytes = staffFile->Slice(begin, end - std::min(begin, end));
+    }
+
+    Tables& tables = loaded.emplace(Tables{
+        dataDir,
+        staffFile,
+        std::move(indexes),
+        clubs.get(),
+        staffs.get(),
+        nonPlayerDb.get(),
+        playerDb.get(),
+        firstNames.get(),
+        secondNames.get(),
+        commonNames ? std::optional<Repository<CommonName>>(commonNames->get()) : std::nullopt,
+        preferenceBytes,
+        {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+        std::move(sources),
+        options.searchCacheBytes
+    });
+
+#if CM_METRICS
+    step.emplace(metrics().GetHistogram("cm_load_seconds", "step=\"derived\""));
+#endif
+    auto references = pool.Submit([&]{ return ReferenceIndex(tables.clubs.Records(), tables.staffs.Records()); });
+    auto staffJoin  = pool.Submit([&]{ return StaffJoin(tables.staffs.Records(), tables.players, tables.nonPlayers); });
+    auto clubIndex  = pool.Submit([&]{ return build_club_name_index(tables.clubs.Records()); });
+    auto staffDates = pool.Submit([&]{ return StaffDateColumns(tables.staffs.Records()); });
+
+    // Intern the name tables in parallel, then resolve every display name once.
+    auto firstTable  = pool.Submit([&]{ return NameTable(tables.firstNames.Records()); });
+    auto secondTable = pool.Submit([&]{ return NameTable(tables.secondNames.Records()); });
+    if (tables.commonNames.has_value())
+        tables.commonNameTable = NameTable(tables.commonNames->Records());
+    tables.firstNameTable = firstTable.get();
+    tables.secondNameTable = secondTable.get();
+
+    tables.staffJoin = staffJoin.get();
+    auto secondary = pool.Submit([&]{ return SecondaryIndexes(tables.staffs.Records(), tables.clubs.Records(), tables.players.Records(), tables.staffJoin); });
+
+    tables.staffNames = StaffNameCache(tables.staffs.Records(),
+                                       tables.firstNameTable,
+                                       tables.secondNameTable,
+                                       tables.commonNames ? &tables.commonNameTable : nullptr);
+    tables.staffNameIndex = build_staff_name_index(tables.staffs.Records(),
+                                                   tables.firstNameTable,
+                                                   tables.secondNameTable,
+                                                   tables.commonNames ? &tables.commonNameTable : nullptr);
+    tables.references = references.get();
+    tables.clubNameIndex = clubIndex.get();
+    tables.staffDates = staffDates.get();
+    tables.secondary = secondary.get();
+#if CM_METRICS
+    step.reset();
+#endif
+
+    return std::shared_ptr<const Database>(new Database(std::move(tables)));
+}
+
+Database::Database(Tables&& tables)
+    : m_dataDir(std::move(tables.dataDir)),
+      m_backingFile(std::move(tables.backingFile)),
+      m_indexes(std::move(tables.indexes)),
+      m_clubs(std::move(tables.clubs)),
+      m_staffs(std::move(tables.staffs)),
+      m_nonPlayers(std::move(tables.nonPlayers)),
+      m_players(std::move(tables.players)),
+      m_firstNames(std::move(tables.firstNames)),
+      m_secondNames(std::move(tables.secondNames)),
+      m_commonNames(std::move(tables.commonNames)),
+      m_staffPreferences(tables.staffPreferences),
+      m_firstNameTable(std::move(tables.firstNameTable)),
+      m_secondNameTable(std::move(tables.secondNameTable)),
+      m_commonNameTable(std::move(tables.commonNameTable)),
+      m_staffNames(std::move(tables.staffNames)),
+      m_references(std::move(tables.references)),
+      m_staffJoin(std::move(tables.staffJoin)),
+      m_staffDates(std::move(tables.staffDates)),
+      m_staffNameIndex(std::move(tables.staffNameIndex)),
+      m_clubNameIndex(std::move(tables.clubNameIndex)),
+      m_secondary(std::move(tables.secondary)),
+      m_sources(std::move(tables.sources)),
+      m_staffSearchCache(tables.searchCacheBytes),
+      m_clubSearchCache(tables.searchCacheBytes)
+{
+}
+
+// The words FuzzyIndex::Search matches on, so queries that differ only in
+// case, accents or punctuation share an entry and get identical results.
+static std::string search_cache_key(std::string_view query, std::size_t limit)
+{
+    std::string key = std::to_string(limit);
+    for (const auto& word : FuzzyIndex::words(query))
+    {
+        key += ' ';
+        key += word;
+    }
+    return key;
+}
+
+std::shared_ptr<const std::vector<FuzzyMatch>> Database::SearchStaffNames(std::string_view query, std::size_t limit) const
+{
+    return m_staffSearchCache.GetOrCompute(search_cache_key(query, limit), [&]{ return m_staffNameIndex.Search(query, limit); });
+}
+
+std::shared_ptr<const std::vector<FuzzyMatch>> Database::SearchClubNames(std::string_view query, std::size_t limit) const
+{
+    return m_clubSearchCache.GetOrCompute(search_cache_key(query, limit), [&]{ return m_clubNameIndex.Search(query, limit); });
+}
+
+CacheStats Database::SearchCacheStats() const
+{
+    CacheStats stats = m_staffSearchCache.Stats();
+    const CacheStats clubs = m_clubSearchCache.Stats();
+    stats.hits += clubs.hits;
+    stats.misses += clubs.misses;
+    stats.evictions += clubs.evictions;
+    stats.entries += clubs.entries;
+    stats.bytes += clubs.bytes;
+    return stats;
+}
+
+StaffView Database::StaffViewOfRow(std::size_t staffRow) const
+{
+    const auto player = m_staffJoin.PlayerOf(staffRow);
+    const auto nonPlayer = m_staffJoin.NonPlayerOf(staffRow);
+    const auto playerRow = m_staffJoin.PlayerRowOf(staffRow);
+
+    return StaffView{
+        &m_staffs.Records()[staffRow],
+        player ? &m_players.Records()[*player] : nullptr,
+        nonPlayer ? &m_nonPlayers.Records()[*nonPlayer] : nullptr,
+        playerRow ? &m_staffJoin.PlayerRows()[*playerRow] : nullptr
+    };
+}
+
+std::optional<Index> Database::FindIndex(std::string_view fileName, std::optional<std::uint32_t> type) const
+{
+    return find_entry(m_indexes.Records(), fileName, type);
+}
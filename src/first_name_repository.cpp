@@ -5,11 +5,6 @@
 
 #include "first_name_repository.h"
 
-// index offset and lazy deserialize. 
-// normally, in this implementation one time indexing offsets should be done 
-// and then the deserialization for only the offset 
-// think about thread safety as well
-// additionally add a small LRU cache 
 FirstNameRepository::FirstNameRepository(const std::filesystem::path& tableName): m_tablePath(tableName) 
 {
     std::ifstream in(m_tablePath, std::ios::binary);
@@ -34,13 +29,15 @@ FirstNameRepository::FirstNameRepository(const std::filesystem::path& tableName)
         if (!in) throw std::runtime_error("Read error while reading record " + std::to_string(i));
         m_firstNames[i] = rec;
     }
+
+    m_ids = IdIndex::Build(m_firstNames, [](const FirstName& firstName){ return firstName.id; });
 }
 
 std::optional<std::string> FirstNameRepository::GetById(int id) const 
 {
-    auto it = std::ranges::find_if(m_firstNames, [&](const auto& firstName){ return id == firstName.id; });
-    if (it == m_firstNames.end())
+    auto row = m_ids.Find(id);
+    if (!row.has_value())
         return std::nullopt;
 
-    return name_as_string(*it);
+    return name_as_string(m_firstNames[*row]);
 }
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "fuzzy_index.h"
+#include "metrics.h"
+
+// Folded form of one Windows-1252 byte: its base letter(s), "" to drop it, or " " to split words.
+static constexpr std::string_view fold_char(unsigned char ch)
+{
+    constexpr std::string_view LOWER = "abcdefghijklmnopqrstuvwxyz";
+    constexpr std::string_view DIGITS = "0123456789";
+
+    if (ch >= 'a' && ch <= 'z') return LOWER.substr(ch - 'a', 1);
+    if (ch >= 'A' && ch <= 'Z') return LOWER.substr(ch - 'A', 1);
+    if (ch >= '0' && ch <= '9') return DIGITS.substr(ch - '0', 1);
+
+    // Upper and lower case Latin-1 letters differ by 0x20 (except × / ÷ and ß / ÿ).
+    if (ch >= 0xC0 && ch <= 0xDE && ch != 0xD7) ch = static_cast<unsigned char>(ch + 0x20);
+
+    switch (ch)
+    {
+    case '\'': case '`': case 0x91: case 0x92: case 0xB4:
+        return "";
+    case 0x83: return "f";
+    case 0x8A: case 0x9A: return "s";
+    case 0x8C: case 0x9C: return "oe";
+    case 0x8E: case 0x9E: return "z";
+    case 0x9F: case 0xFD: case 0xFF: return "y";
+    case 0xDF: return "ss";
+    case 0xE0: case 0xE1: case 0xE2: case 0xE3: case 0xE4: case 0xE5: return "a";
+    case 0xE6: return "ae";
+    case 0xE7: return "c";
+    case 0xE8: case 0xE9: case 0xEA: case 0xEB: return "e";
+    case 0xEC: case 0xED: case 0xEE: case 0xEF: return "i";
+    case 0xF0: return "d";
+    case 0xF1: return "n";
+    case 0xF2: case 0xF3: case 0xF4: case 0xF5: case 0xF6: case 0xF8: return "o";
+    case 0xF9: case 0xFA: case 0xFB: case 0xFC: return "u";
+    case 0xFE: return "th";
+    default: return " ";
+    }
+}
+
+static constexpr auto FOLD_TABLE = [] {
+    std::array<std::string_view, 256> table{};
+    for (unsigned ch = 0; ch < 256; ++ch) table[ch] = fold_char(static_cast<unsigned char>(ch));
+    return table;
+}();
+
+std::string FuzzyIndex::fold(std::string_view text)
+{
+    std::string res;
+    res.reserve(text.size());
+    for (unsigned char ch : text)
+    {
+        if (ch == '\0') break;
+        res.append(FOLD_TABLE[ch]);
+    }
+    return res;
+}
+
+std::vector<std::string> FuzzyIndex::words(std::string_view text)
+{
+    const std::string folded = fold(text);
+
+    std::vector<std::string> res;
+    std::size_t pos = 0;
+    while (pos < folded.size())
+    {
+        const auto begin = folded.find_first_not_of(' ', pos);
+        if (begin == std::string::npos) break;
+
+        auto end = folded.find(' ', begin);
+        if (end == std::string::npos) end = folded.size();
+
+        res.emplace_back(folded, begin, std::min(end - begin, MAX_TERM_LENGTH));
+        pos = end;
+    }
+    return res;
+}
+
+unsigned FuzzyIndex::default_max_edits(std::size_t length)
+{
+    if (length <= 2) return 0;
+    if (length <= 5) return 1;
+    return 2;
+}
+
+unsigned FuzzyIndex::edit_distance(std::string_view a, std::string_view b)
+{
+    std::vector<unsigned> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); ++j) row[j] = static_cast<unsigned>(j);
+
+    for (std::size_t i = 1; i <= a.size(); ++i)
+    {
+        unsigned diagonal = row[0];
+        row[0] = static_cast<unsigned>(i);
+        for (std::size_t j = 1; j <= b.size(); ++j)
+        {
+            const unsigned up = row[j];
+            row[j] = std::min({ up + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0u : 1u) });
+            diagonal = up;
+        }
+    }
+    return row[b.size()];
+}
+
+void FuzzyIndex::Add(std::uint32_t doc, std::string_view text)
+{
+    for (auto& word : words(text))
+        m_pending.emplace_back(std::move(word), doc);
+}
+
+void FuzzyIndex::Finalize()
+{
+    std::ranges::sort(m_pending);
+    const auto dup = std::ranges::unique(m_pending);
+    m_pending.erase(dup.begin(), dup.end());
+
+    m_terms.clear();
+    m_termOffsets.clear();
+
+    std::vector<std::pair<std::int64_t, std::uint32_t>> edges;   // (term, doc), docs ascending per term
+    edges.reserve(m_pending.size());
+    for (const auto& [word, doc] : m_pending)
+    {
+        if (m_termOffsets.empty() || Term(m_termOffsets.size() - 2) != word)
+        {
+            if (m_terms.size() + word.size() > UINT32_MAX) throw std::runtime_error("FuzzyIndex term arena overflow.");
+
+            if (m_termOffsets.empty()) m_termOffsets.push_back(0);
+            m_terms.append(word);
+            m_termOffsets.push_back(static_cast<std::uint32_t>(m_terms.size()));
+        }
+        edges.emplace_back(static_cast<std::int64_t>(m_termOffsets.size() - 2), doc);
+    }
+    if (m_termOffsets.empty()) m_termOffsets.push_back(0);
+
+    m_postings = CsrIndex<std::uint32_t>(TermCount(), edges);
+
+    std::vector<std::uint32_t> docs;
+    docs.reserve(edges.size());
+    for (const auto& edge : edges) docs.push_back(edge.second);
+    std::ranges::sort(docs);
+    m_docCount = static_cast<std::size_t>(std::ranges::unique(docs).begin() - docs.begin());
+
+    m_pending.clear();
+    m_pending.shrink_to_fit();
+}
+
+std::vector<std::pair<std::uint32_t, unsigned>> FuzzyIndex::MatchTerms(std::string_view term, unsigned maxEdits) const
+{
+    std::vector<std::pair<std::uint32_t, unsigned>> res;
+    const std::size_t n = TermCount();
+    const std::size_t m = term.size();
+    if (n == 0) return res;
+
+    // rows[d] is the Levenshtein row of the dictionary prefix of length d against `term`.
+    const std::size_t width = m + 1;
+    std::vector<std::uint16_t> rows((MAX_TERM_LENGTH + 1) * width);
+    for (std::size_t j = 0; j <= m; ++j) rows[j] = static_cast<std::uint16_t>(j);
+
+    std::string_view previous;
+    std::size_t computed = 0;       // rows [0, computed] hold prefixes of `previous`
+
+    std::size_t i = 0;
+    while (i < n)
+    {
+        const std::string_view candidate = Term(i);
+
+        std::size_t d = 0;
+        const std::size_t shared = std::min(computed, std::min(candidate.size(), previous.size()));
+        while (d < shared && candidate[d] == previous[d]) ++d;
+
+        bool pruned = false;
+        for (; d < candidate.size(); ++d)
+        {
+            const std::uint16_t* up = &rows[d * width];
+            std::uint16_t* row = &rows[(d + 1) * width];
+            row[0] = static_cast<std::uint16_t>(d + 1);
+            std::uint16_t best = row[0];
+            for (std::size_t j = 1; j <= m; ++j)
+            {
+                const unsigned cost = candidate[d] == term[j - 1] ? 0 : 1;
+                row[j] = static_cast<std::uint16_t>(std::min({ up[j] + 1u, row[j - 1] + 1u, up[j - 1] + cost }));
+                best = std::min(best, row[j]);
+            }
+
+            if (best > maxEdits)
+            {
+                // No extension of this prefix can come back within budget: skip the whole subtree.
+                const std::string_view prefix = candidate.substr(0, d + 1);
+                computed = d + 1;
+                previous = candidate;
+                std::size_t lo = i + 1, hi = n;
+                while (lo < hi)
+                {
+                    const std::size_t mid = lo + (hi - lo) / 2;
+                    if (Term(mid).substr(0, prefix.size()) == prefix) lo = mid + 1;
+                    else hi = mid;
+                }
+                i = lo;
+                pruned = true;
+                break;
+            }
+        }
+        if (pruned) continue;
+
+        const unsigned distance = rows[candidate.size() * width + m];
+        if (distance <= maxEdits) res.emplace_back(static_cast<std::uint32_t>(i), distance);
+
+        computed = candidate.size();
+        previous = candidate;
+        ++i;
+    }
+    return res;
+}
+
+std::vector<FuzzyMatch> FuzzyIndex::MatchWord(std::string_view word, unsigned maxEdits) const
+{
+    std::vector<FuzzyMatch> res;
+    for (const auto& [term, distance] : MatchTerms(word, maxEdits))
+        for (auto doc : m_postings.Get(term))
+            res.push_back(FuzzyMatch{ doc, distance });
+
+    // Keep the closest term per document.
+    std::ranges::sort(res, [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.doc != b.doc ? a.doc < b.doc : a.distance < b.distance;
+    });
+    const auto dup = std::ranges::unique(res, {}, &FuzzyMatch::doc);
+    res.erase(dup.begin(), dup.end());
+    return res;
+}
+
+std::vector<FuzzyMatch> FuzzyIndex::Search(std::string_view query, std::size_t limit, std::optional<unsigned> maxEdits) const
+{
+    CM_TIME_SCOPE("cm_query_seconds", "type=\"fuzzy_search\"");
+
+    const auto queryWords = words(query);
+    if (queryWords.empty()) return {};
+
+    std::vector<FuzzyMatch> matches;
+    for (std::size_t w = 0; w < queryWords.size(); ++w)
+    {
+        unsigned budget = default_max_edits(queryWords[w].size());
+        if (maxEdits.has_value()) budget = std::min(budget, *maxEdits);
+
+        auto docs = MatchWord(queryWords[w], budget);
+        if (w == 0)
+        {
+            matches = std::move(docs);
+        }
+        else
+        {
+            // Both lists are sorted by doc: keep the documents in both, adding the edits.
+            std::vector<FuzzyMatch> merged;
+            auto a = matches.begin();
+            auto b = docs.begin();
+            while (a != matches.end() && b != docs.end())
+            {
+                if (a->doc < b->doc) ++a;
+                else if (b->doc < a->doc) ++b;
+                else merged.push_back(FuzzyMatch{ a->doc, (a++)->distance + (b++)->distance });
+            }
+            matches = std::move(merged);
+        }
+        if (matches.empty()) return {};
+    }
+
+    auto better = [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.doc < b.doc;
+    };
+    if (matches.size() > limit)
+    {
+        std::ranges::partial_sort(matches, matches.begin() + static_cast<std::ptrdiff_t>(limit), better);
+        matches.resize(limit);
+    }
+    else
+    {
+        std::ranges::sort(matches, better);
+    }
+    return matches;
+}
+
+void FuzzyIndex::Save(SnapshotWriter& out) const
+{
+    out.WriteString(m_terms);
+    out.Write(m_termOffsets);
+    m_postings.Save(out);
+    out.WriteValue<std::uint64_t>(m_docCount);
+}
+
+FuzzyIndex FuzzyIndex::Load(SnapshotReader& in)
+{
+    FuzzyIndex index;
+    index.m_terms = in.ReadString();
+    index.m_termOffsets = in.ReadVector<std::uint32_t>();
+    index.m_postings = CsrIndex<std::uint32_t>::Load(in);
+    index.m_docCount = static_cast<std::size_t>(in.ReadValue<std::uint64_t>());
+    if (index.m_termOffsets.empty() || index.m_termOffsets.back() != index.m_terms.size()
+        || index.m_postings.KeyCount() != index.TermCount())
+        throw std::runtime_error("Snapshot fuzzy index is corrupt.");
+    return index;
+}
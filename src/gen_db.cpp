@@ -0,0 +1,101 @@
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "synthetic_database.h"
+
+static void usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0 << " <out-dir> [--scale X] [--seed N]\n"
+              << "X is a positive number up to 1000; N is an unsigned 64-bit integer.\n"
+              << "Writes a synthetic, format-correct CM database (index.dat, club.dat,\n"
+              << "staff.dat and the name tables). Scale 1 is about the size of CM 01/02.\n";
+}
+
+// Positive and finite; a scale past MAX_SCALE would not fit in memory anyway.
+static constexpr double MAX_SCALE = 1000.0;
+
+static std::optional<double> parse_scale(std::string_view text)
+{
+    double scale = 0.0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), scale);
+    if (ec != std::errc() || ptr != text.data() + text.size() || text.empty()) return std::nullopt;
+    if (!std::isfinite(scale) || scale <= 0.0 || scale > MAX_SCALE) return std::nullopt;
+
+    return scale;
+}
+
+static std::optional<std::uint64_t> parse_seed(std::string_view text)
+{
+    std::uint64_t seed = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), seed);
+    if (ec != std::errc() || ptr != text.data() + text.size() || text.empty()) return std::nullopt;
+
+    return seed;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const std::filesystem::path outDir = argv[1];
+    SyntheticDatabaseOptions options;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        const std::string_view value = argv[++i];
+        if (arg == "--scale")
+        {
+            const auto scale = parse_scale(value);
+            if (!scale.has_value())
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            options.scale = *scale;
+        }
+        else if (arg == "--seed")
+        {
+            const auto seed = parse_seed(value);
+            if (!seed.has_value())
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            options.seed = *seed;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const auto summary = write_synthetic_database(outDir, options);
+
+    std::cout << "Wrote " << outDir.string() << ": "
+              << summary.clubs << " clubs, "
+              << summary.staffs << " staff, "
+              << summary.players << " players, "
+              << summary.nonPlayers << " non-players, "
+              << summary.bytes / 1024 << " KiB\n";
+
+    return 0;
+}
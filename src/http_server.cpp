@@ -0,0 +1,538 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "http_server.h"
+#include "json_writer.h"
+
+using Clock = std::chrono::steady_clock;
+
+static std::system_error os_error(std::string_view what)
+{
+    return std::system_error(errno, std::generic_category(), std::string(what));
+}
+
+static std::string lower(std::string_view text)
+{
+    std::string res(text);
+    for (auto& ch : res) if (ch >= 'A' && ch <= 'Z') ch = static_cast<char>(ch + ('a' - 'A'));
+    return res;
+}
+
+static std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+std::optional<std::string_view> HttpRequest::Param(std::string_view name) const
+{
+    for (const auto& [key, value] : query)
+        if (key == name) return value;
+
+    return std::nullopt;
+}
+
+std::optional<std::string_view> HttpRequest::Header(std::string_view name) const
+{
+    for (const auto& [key, value] : headers)
+        if (key == name) return value;
+
+    return std::nullopt;
+}
+
+HttpResponse HttpResponse::Error(int status, std::string_view message)
+{
+    JsonWriter json;
+    json.BeginObject().Key("error").Value(message).Key("status").Value(status).EndObject();
+    return Json(std::move(json).Take(), status);
+}
+
+std::string percent_decode(std::string_view text, bool plusAsSpace)
+{
+    auto hex = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        return -1;
+    };
+
+    std::string res;
+    res.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == '%' && i + 2 < text.size() && hex(text[i + 1]) >= 0 && hex(text[i + 2]) >= 0)
+        {
+            res.push_back(static_cast<char>(hex(text[i + 1]) * 16 + hex(text[i + 2])));
+            i += 2;
+        }
+        else if (text[i] == '+' && plusAsSpace)
+        {
+            res.push_back(' ');
+        }
+        else
+        {
+            res.push_back(text[i]);
+        }
+    }
+    return res;
+}
+
+std::vector<std::pair<std::string, std::string>> parse_query_string(std::string_view query)
+{
+    std::vector<std::pair<std::string, std::string>> res;
+    while (!query.empty())
+    {
+        const auto amp = query.find('&');
+        const auto part = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+        if (part.empty()) continue;
+
+        const auto eq = part.find('=');
+        if (eq == std::string_view::npos) res.emplace_back(percent_decode(part, true), std::string());
+        else res.emplace_back(percent_decode(part.substr(0, eq), true), percent_decode(part.substr(eq + 1), true));
+    }
+    return res;
+}
+
+std::string_view http_status_text(int status)
+{
+    switch (status)
+    {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
+
+namespace {
+
+enum class ParseResult { Incomplete, Complete, Invalid };
+
+struct Connection {
+    std::string in;
+    std::string out;
+    std::size_t outSent = 0;
+    Clock::time_point lastActive = Clock::now();
+    bool closeAfterWrite = false;
+    bool peerClosed = false;
+    bool wantRead = true;
+    bool wantWrite = false;
+};
+
+// Parses one request from the front of `buffer`; `consumed` is its length.
+ParseResult parse_request(std::string_view buffer, const HttpServerOptions& options,
+                          HttpRequest& req, std::size_t& consumed, int& errorStatus)
+{
+    const auto headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos ? buffer.size() > options.maxHeaderBytes : headerEnd > options.maxHeaderBytes)
+    {
+        errorStatus = 431;
+        return ParseResult::Invalid;
+    }
+    if (headerEnd == std::string_view::npos) return ParseResult::Incomplete;
+
+    std::string_view head = buffer.substr(0, headerEnd);
+    const auto lineEnd = head.find("\r\n");
+    const std::string_view requestLine = head.substr(0, lineEnd);
+    head = lineEnd == std::string_view::npos ? std::string_view{} : head.substr(lineEnd + 2);
+
+    // METHOD SP target SP HTTP/x.y
+    const auto sp1 = requestLine.find(' ');
+    const auto sp2 = requestLine.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 == sp1)
+    {
+        errorStatus = 400;
+        return ParseResult::Invalid;
+    }
+    req.method = std::string(requestLine.substr(0, sp1));
+    const std::string_view target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    const std::string_view version = requestLine.substr(sp2 + 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0")
+    {
+        errorStatus = version.starts_with("HTTP/") ? 505 : 400;
+        return ParseResult::Invalid;
+    }
+
+    const auto question = target.find('?');
+    req.path = percent_decode(target.substr(0, question), false);
+    req.query = question == std::string_view::npos ? decltype(req.query){} : parse_query_string(target.substr(question + 1));
+
+    req.headers.clear();
+    while (!head.empty())
+    {
+        const auto end = head.find("\r\n");
+        const std::string_view line = head.substr(0, end);
+        head = end == std::string_view::npos ? std::string_view{} : head.substr(end + 2);
+
+        const auto colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0)
+        {
+            errorStatus = 400;
+            return ParseResult::Invalid;
+        }
+        req.headers.emplace_back(lower(line.substr(0, colon)), std::string(trim(line.substr(colon + 1))));
+    }
+
+    const auto connection = req.Header("connection");
+    const std::string connectionValue = connection ? lower(*connection) : std::string();
+    req.keepAlive = version == "HTTP/1.1" ? connectionValue != "close" : connectionValue == "keep-alive";
+
+    if (req.Header("transfer-encoding").has_value())
+    {
+        errorStatus = 501;      // chunked request bodies are not supported
+        return ParseResult::Invalid;
+    }
+
+    std::size_t bodyBytes = 0;
+    if (auto length = req.Header("content-length"))
+    {
+        auto [ptr, ec] = std::from_chars(length->data(), length->data() + length->size(), bodyBytes);
+        if (ec != std::errc() || ptr != length->data() + length->size())
+        {
+            errorStatus = 400;
+            return ParseResult::Invalid;
+        }
+        if (bodyBytes > options.maxBodyBytes)
+        {
+            errorStatus = 413;
+            return ParseResult::Invalid;
+        }
+    }
+
+    const std::size_t total = headerEnd + 4 + bodyBytes;
+    if (buffer.size() < total) return ParseResult::Incomplete;
+
+    req.body = std::string(buffer.substr(headerEnd + 4, bodyBytes));
+    consumed = total;
+    return ParseResult::Complete;
+}
+
+void append_response(std::string& out, const HttpResponse& res, bool keepAlive, bool headOnly)
+{
+    out.append("HTTP/1.1 ");
+    out.append(std::to_string(res.status));
+    out.push_back(' ');
+    out.append(http_status_text(res.status));
+    out.append("\r\nContent-Type: ");
+    out.append(res.contentType);
+    out.append("\r\nContent-Length: ");
+    out.append(std::to_string(res.body.size()));
+    out.append(keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    if (!headOnly) out.append(res.body);
+}
+
+} // namespace
+
+HttpServer::HttpServer(HttpServerOptions options, Handler handler)
+    : m_options(std::move(options)), m_handler(std::move(handler))
+{
+    m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) throw os_error("socket");
+
+    const int yes = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_options.port);
+    if (inet_pton(AF_INET, m_options.bindAddress.c_str(), &addr.sin_addr) != 1)
+    {
+        close(m_listenFd);
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument), "Bad bind address " + m_options.bindAddress);
+    }
+
+    if (bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(m_listenFd, SOMAXCONN) < 0)
+    {
+        auto error = os_error("bind/listen on port " + std::to_string(m_options.port));
+        close(m_listenFd);
+        throw error;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    m_port = ntohs(addr.sin_port);
+
+    m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_stopFd < 0)
+    {
+        auto error = os_error("eventfd");
+        close(m_listenFd);
+        throw error;
+    }
+}
+
+HttpServer::~HttpServer()
+{
+    Stop();
+    if (m_stopFd >= 0) close(m_stopFd);
+    if (m_listenFd >= 0) close(m_listenFd);
+}
+
+void HttpServer::Start()
+{
+    if (m_running.exchange(true)) return;
+
+    std::size_t threads = m_options.threads != 0 ? m_options.threads : std::thread::hardware_concurrency();
+    threads = std::max<std::size_t>(1, threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        m_threads.emplace_back([this]{ Run(); });
+}
+
+void HttpServer::Stop()
+{
+    if (!m_running.exchange(false)) return;
+
+    // The counter stays non-zero, so every loop sees the eventfd readable.
+    const std::uint64_t one = 1;
+    [[maybe_unused]] auto written = write(m_stopFd, &one, sizeof(one));
+    for (auto& t : m_threads) t.join();
+    m_threads.clear();
+}
+
+void HttpServer::Run()
+{
+    const int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) return;
+
+    // Tags for the two shared descriptors; connections use their fd.
+    constexpr std::uint64_t LISTEN_TAG = ~0ull;
+    constexpr std::uint64_t STOP_TAG = ~0ull - 1;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, m_listenFd, &ev);
+
+    ev.events = EPOLLIN;
+    ev.data.u64 = STOP_TAG;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, m_stopFd, &ev);
+
+    std::unordered_map<int, Connection> connections;
+
+    auto close_connection = [&](int fd) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    };
+
+    // The largest request parse_request accepts; input past it waits in the socket.
+    const std::size_t maxInputBytes = m_options.maxHeaderBytes + 4 + m_options.maxBodyBytes;
+
+    auto backlogged = [&](const Connection& conn) {
+        return conn.out.size() - conn.outSent > m_options.maxPendingOutputBytes;
+    };
+
+    // Reads only while the output backlog and the input buffer are under their caps,
+    // so a client that pipelines without reading is held back by TCP flow control.
+    auto update_interest = [&](int fd, Connection& conn) {
+        const bool wantWrite = conn.outSent < conn.out.size();
+        const bool wantRead = !conn.closeAfterWrite && !conn.peerClosed && !backlogged(conn) && conn.in.size() < maxInputBytes;
+        if (wantWrite == conn.wantWrite && wantRead == conn.wantRead) return;
+
+        epoll_event mod{};
+        mod.events = (wantRead ? EPOLLIN | EPOLLRDHUP : 0u) | (wantWrite ? EPOLLOUT : 0u);
+        mod.data.u64 = static_cast<std::uint64_t>(fd);
+        epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &mod);
+        conn.wantRead = wantRead;
+        conn.wantWrite = wantWrite;
+    };
+
+    // Sends as much pending output as the socket takes; false when the connection is gone.
+    auto flush = [&](int fd, Connection& conn) {
+        while (conn.outSent < conn.out.size())
+        {
+            const ssize_t n = send(fd, conn.out.data() + conn.outSent, conn.out.size() - conn.outSent, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                conn.outSent += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0 && errno == EINTR) continue;
+
+            close_connection(fd);
+            return false;
+        }
+
+        if (conn.outSent == conn.out.size())
+        {
+            conn.out.clear();
+            conn.outSent = 0;
+            if (conn.closeAfterWrite)
+            {
+                close_connection(fd);
+                return false;
+            }
+        }
+        update_interest(fd, conn);
+        return true;
+    };
+
+    // Answers the complete requests in the input buffer, in order. Requests
+    // are held back while the output backlog is over its cap and resume once
+    // a flush (here or on EPOLLOUT) brings it under again.
+    auto serve = [&](int fd, Connection& conn) {
+        while (true)
+        {
+            std::size_t offset = 0;
+            bool held = false;
+            while (!conn.closeAfterWrite)
+            {
+                if (backlogged(conn))
+                {
+                    held = true;
+                    break;
+                }
+
+                HttpRequest req;
+                std::size_t consumed = 0;
+                int errorStatus = 400;
+                const auto result = parse_request(std::string_view(conn.in).substr(offset), m_options, req, consumed, errorStatus);
+                if (result == ParseResult::Incomplete) break;
+
+                if (result == ParseResult::Invalid)
+                {
+                    append_response(conn.out, HttpResponse::Error(errorStatus, http_status_text(errorStatus)), false, false);
+                    conn.closeAfterWrite = true;
+                    break;
+                }
+                offset += consumed;
+
+                HttpResponse res;
+                const bool headOnly = req.method == "HEAD";
+                try
+                {
+                    res = m_handler(req);
+                }
+                catch (const std::exception& e)
+                {
+                    res = HttpResponse::Error(500, e.what());
+                }
+                append_response(conn.out, res, req.keepAlive, headOnly);
+                if (!req.keepAlive) conn.closeAfterWrite = true;
+            }
+            conn.in.erase(0, offset);
+
+            // Nothing more will arrive: finish writing what is queued, then close.
+            if (conn.peerClosed && !held) conn.closeAfterWrite = true;
+            if (!flush(fd, conn)) return false;
+            if (!held || backlogged(conn)) return true;
+        }
+    };
+
+    std::array<epoll_event, 64> events;
+    const int tickMs = 1000;
+    auto lastSweep = Clock::now();
+    bool running = true;
+
+    while (running)
+    {
+        const int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), tickMs);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; ++i)
+        {
+            const std::uint64_t tag = events[i].data.u64;
+            if (tag == STOP_TAG)
+            {
+                running = false;
+                break;
+            }
+
+            if (tag == LISTEN_TAG)
+            {
+                while (true)
+                {
+                    const int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0) break;      // EAGAIN: another loop got the rest
+
+                    const int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+                    epoll_event add{};
+                    add.events = EPOLLIN | EPOLLRDHUP;
+                    add.data.u64 = static_cast<std::uint64_t>(fd);
+                    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &add) < 0)
+                    {
+                        close(fd);
+                        continue;
+                    }
+                    connections.emplace(fd, Connection{});
+                }
+                continue;
+            }
+
+            const int fd = static_cast<int>(tag);
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& conn = it->second;
+            conn.lastActive = Clock::now();
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                close_connection(fd);
+                continue;
+            }
+
+            // Draining the backlog may let requests that were held back through.
+            if ((events[i].events & EPOLLOUT) && (!flush(fd, conn) || !serve(fd, conn))) continue;
+
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+            {
+                char buf[16 * 1024];
+                while (conn.wantRead && conn.in.size() < maxInputBytes)
+                {
+                    const ssize_t r = recv(fd, buf, std::min(sizeof(buf), maxInputBytes - conn.in.size()), 0);
+                    if (r > 0)
+                    {
+                        conn.in.append(buf, static_cast<std::size_t>(r));
+                        continue;
+                    }
+                    if (r < 0 && errno == EINTR) continue;
+
+                    conn.peerClosed = r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                    break;
+                }
+
+                if (!serve(fd, conn)) continue;
+            }
+        }
+
+        const auto now = Clock::now();
+        if (now - lastSweep >= std::chrono::milliseconds(tickMs))
+        {
+            lastSweep = now;
+            const auto idle = std::chrono::seconds(m_options.idleTimeoutSeconds);
+            std::vector<int> expired;
+            for (const auto& [fd, conn] : connections)
+                if (now - conn.lastActive > idle) expired.push_back(fd);
+            for (int fd : expired) close_connection(fd);
+        }
+    }
+
+    for (auto& [fd, conn] : connections) close(fd);
+    close(epfd);
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "id_index.h"
+#include "snapshot_io.h"
+
+// A direct table is used while at least half of its slots are occupied.
+static constexpr std::uint64_t DENSE_SLACK = 64;
+
+IdIndex::IdIndex(std::span<const std::int32_t> ids): m_size(ids.size())
+{
+    if (ids.size() >= EMPTY) throw std::runtime_error("Too many records for IdIndex.");
+    if (ids.empty()) return;
+
+    const auto [minIt, maxIt] = std::ranges::minmax_element(ids);
+    const std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(*maxIt) - *minIt) + 1;
+
+    m_dense = range <= 2 * static_cast<std::uint64_t>(ids.size()) + DENSE_SLACK;
+    if (m_dense)
+    {
+        m_minId = *minIt;
+        m_slots.assign(range, EMPTY);
+        for (std::size_t row = 0; row < ids.size(); ++row)
+        {
+            auto& slot = m_slots[static_cast<std::uint64_t>(ids[row] - m_minId)];
+            if (slot == EMPTY) slot = static_cast<std::uint32_t>(row);
+        }
+        return;
+    }
+
+    m_sparse.reserve(ids.size());
+    for (std::size_t row = 0; row < ids.size(); ++row)
+        m_sparse.try_emplace(ids[row], static_cast<std::uint32_t>(row));
+}
+
+void IdIndex::Save(SnapshotWriter& out) const
+{
+    out.WriteValue<std::uint8_t>(m_dense ? 1 : 0);
+    out.WriteValue<std::uint64_t>(m_size);
+    out.WriteValue<std::int64_t>(m_minId);
+    out.Write(m_slots);
+
+    std::vector<std::int32_t> keys;
+    std::vector<std::uint32_t> rows;
+    keys.reserve(m_sparse.size());
+    rows.reserve(m_sparse.size());
+    for (const auto& [id, row] : m_sparse)
+    {
+        keys.push_back(id);
+        rows.push_back(row);
+    }
+    out.Write(keys);
+    out.Write(rows);
+}
+
+IdIndex IdIndex::Load(SnapshotReader& in)
+{
+    IdIndex index;
+    index.m_dense = in.ReadValue<std::uint8_t>() != 0;
+    index.m_size = static_cast<std::size_t>(in.ReadValue<std::uint64_t>());
+    index.m_minId = in.ReadValue<std::int64_t>();
+    index.m_slots = in.ReadVector<std::uint32_t>();
+
+    const auto keys = in.ReadVector<std::int32_t>();
+    const auto rows = in.ReadVector<std::uint32_t>();
+    if (keys.size() != rows.size()) throw std::runtime_error("Snapshot id index is corrupt.");
+
+    index.m_sparse.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) index.m_sparse.emplace(keys[i], rows[i]);
+    return index;
+}
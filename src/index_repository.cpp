@@ -5,15 +5,8 @@
 
 #include "index_repository.h"
 
-// index offset and lazy deserialize. 
-// normally, in this implementation one time indexing offsets should be done 
-// and then the deserialization for only the offset 
-// think about thread safety as well
-// additionally add a small LRU cache 
 IndexRepository::IndexRepository(const std::filesystem::path& tableName): m_tablePath(tableName) 
 {
-    std::cout << "Index size = " << sizeof(Index) << std::endl;
-
     std::ifstream in(m_tablePath, std::ios::binary);
     if (!in) throw std::runtime_error("Failed to open: " + m_tablePath.string());
 
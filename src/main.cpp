@@ -1,103 +1,47 @@
 #include <iostream>
 #include <ranges> 
 #include <algorithm> 
+#include <filesystem>
 
-#include "club_repository.h"
-#include "staff_repository.h"
-#include "non_player.h"
-#include "first_name_repository.h"
-#include "index_repository.h"
-#include "player.h"
+#include "database.h"
 
-#include "repository.h"
-#include "second_name.h"
+int main(int argc, char** argv) {
 
-int main() {
+    const std::filesystem::path dataDir = argc > 1
+        ? std::filesystem::path(argv[1])
+        : std::filesystem::path("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2");
 
-    // TODO: Move these repo related codes to the repository lib 
-    // make a dbset class to set these db related mechanisms.
-
-    constexpr size_t INDEX_HEADER_OFFSET = 8;
-
-    Repository<Index> ir("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/index2.dat", INDEX_HEADER_OFFSET);
-    auto indexList = ir.GetAll();
-    if (!indexList.has_value())
-        return -1;
+    // index.dat drives the load: every table and staff.dat block is read in parallel.
+    auto db = Database::Load(dataDir);
 
     std::cout << "Indexes" << std::endl;
-    for (const auto& ind : indexList.value())
+    for (const auto& ind : db->Indexes().Records())
     {
         std::cout << ind << std::endl;
     }
     std::cout << "===============\n";
 
-    Repository<Club> clubRepository("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/club.dat");
-    auto club244 = clubRepository.GetById(245);
-    if (club244.has_value())
+    if (const Club* club245 = db->Clubs().FindById(245))
     {
-        Club cb244 = club244.value();
-
-        std::cout << cb244 << "\n";
+        std::cout << *club245 << "\n";
     }
 
-    // find the staff index: 
-    auto staffInd = std::ranges::find_if(
-        indexList.value(),
-        [](const auto& ind) {
-            std::string_view name(ind.file_name.data());
-            return name == "staff.dat";
-        }
-    );
-    Repository<Staff> staffRepository("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/staff.dat", 
-                                    staffInd->offset, 
-                                    staffInd->table_size);
-    
-    auto y = staffRepository.GetById(89037);
-    if (!y.has_value())
+    const Staff* staff = db->Staffs().FindById(89037);
+    if (staff == nullptr)
         return -1;
-    Staff staff = y.value();
-
-    std::cout << staff << std::endl;
 
-    Repository<FirstName> fnr("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/first_names.dat");
-    auto z = fnr.GetById(61);
-    std::cout << name_as_string(z.value()) << std::endl; 
+    std::cout << *staff << std::endl;
+    std::cout << db->StaffName(*staff) << std::endl;
 
-    z = fnr.GetById(6997);
-    std::cout << name_as_string(z.value()) << std::endl; 
-
-    z = fnr.GetById(32052);
-    std::cout << name_as_string(z.value()) << std::endl;
-
-    Repository<SecondName> snr("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/second_names.dat");
-    auto t = snr.GetById(37055);
-    std::cout << name_as_string(t.value()) << std::endl; 
-
-    // find the player index: 
-    auto playerInd = std::ranges::find_if(
-        indexList.value(),
-        [](const auto& ind) {
-            std::string_view name(ind.file_name.data());
-            return name == "staff.dat" && ind.version == 10;
-        }
-    );  
-    Repository<Player> playerRepository("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/staff.dat", 
-                                    playerInd->offset, 
-                                    playerInd->table_size);
+    for (int id : { 61, 6997, 32052 })
+    {
+        std::cout << db->FirstNameTable().GetById(id) << std::endl; 
+    }
 
-    std::cout << "Player has been read!\n";
+    std::cout << db->SecondNameTable().GetById(37055) << std::endl; 
 
-    // find the non-player index: 
-    auto nonPlayerInd = std::ranges::find_if(
-        indexList.value(),
-        [](const auto& ind) {
-            std::string_view name(ind.file_name.data());
-            return name == "staff.dat" && ind.version == 9;
-        }
-    );  
-    Repository<NonPlayer> nonPlayerRepository("/Users/tcatak/Documents/repos/cm-advanced-search/data/v2/staff.dat", 
-                                    nonPlayerInd->offset, 
-                                    nonPlayerInd->table_size);
+    std::cout << "Players: " << db->Players().Size()
+              << ", non-players: " << db->NonPlayers().Size() << "\n";
 
     return 0;
 }
@@ -0,0 +1,79 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.h"
+#include "metrics.h"
+
+MappedFile::MappedFile(const std::filesystem::path& path): m_path(path)
+{
+    CM_TIME_SCOPE("cm_load_phase_seconds", "phase=\"open\"");
+    const int fd = ::open(m_path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open: " + m_path.string());
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat: " + m_path.string());
+    }
+
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (m_size == 0) {
+        // mmap rejects zero-length mappings, an empty file is simply an empty span.
+        ::close(fd);
+        return;
+    }
+
+    void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) throw std::runtime_error("Failed to mmap: " + m_path.string());
+
+    m_data = static_cast<const std::byte*>(addr);
+}
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_path(std::move(other.m_path)),
+      m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+        m_path = std::move(other.m_path);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+std::span<const std::byte> MappedFile::Slice(std::size_t offset, std::size_t length) const
+{
+    if (offset > m_size || length > m_size - offset)
+        throw std::runtime_error("Range [" + std::to_string(offset) + ", +" + std::to_string(length)
+                                 + ") is out of " + m_path.string());
+
+    return { m_data + offset, length };
+}
+
+void MappedFile::Unmap() noexcept
+{
+    if (m_data != nullptr)
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,152 @@
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "metrics.h"
+
+MetricsRegistry& metrics()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::uint64_t LatencyHistogram::Percentile(double q) const
+{
+    const std::uint64_t count = Count();
+    if (count == 0) return 0;
+
+    const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < BUCKETS; ++b)
+    {
+        seen += m_buckets[b].load(std::memory_order_relaxed);
+        if (seen >= target) return std::min(bucket_high(b), MaxNanos());
+    }
+    return MaxNanos();
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+Counter& MetricsRegistry::GetCounter(std::string_view name, std::string_view labels, std::string_view help)
+{
+    std::lock_guard lock(m_mutex);
+    if (!help.empty()) m_help.try_emplace(std::string(name), help);
+
+    auto& slot = m_counters[Key(name, labels)];
+    if (slot == nullptr) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+LatencyHistogram& MetricsRegistry::GetHistogram(std::string_view name, std::string_view labels, std::string_view help)
+{
+    std::lock_guard lock(m_mutex);
+    if (!help.empty()) m_help.try_emplace(std::string(name), help);
+
+    auto& slot = m_histograms[Key(name, labels)];
+    if (slot == nullptr) slot = std::make_unique<LatencyHistogram>();
+    return *slot;
+}
+
+void MetricsRegistry::Reset()
+{
+    std::lock_guard lock(m_mutex);
+    for (auto& [key, counter] : m_counters) counter->Reset();
+    for (auto& [key, histogram] : m_histograms) histogram->Reset();
+}
+
+static std::string series(const std::string& name, const std::string& labels, std::string_view extra = {})
+{
+    std::string res = name;
+    if (labels.empty() && extra.empty()) return res;
+
+    res.push_back('{');
+    res.append(labels);
+    if (!labels.empty() && !extra.empty()) res.push_back(',');
+    res.append(extra);
+    res.push_back('}');
+    return res;
+}
+
+// 950ns, 12.3us, 4.56ms, 1.23s
+static std::string format_duration(double nanos)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(nanos < 1e3 ? 0 : 2);
+    if (nanos < 1e3) out << nanos << "ns";
+    else if (nanos < 1e6) out << nanos / 1e3 << "us";
+    else if (nanos < 1e9) out << nanos / 1e6 << "ms";
+    else out << nanos / 1e9 << "s";
+    return out.str();
+}
+
+void MetricsRegistry::WriteText(std::ostream& out) const
+{
+    std::lock_guard lock(m_mutex);
+
+    std::size_t width = 24;
+    for (const auto& [key, h] : m_histograms) width = std::max(width, series(key.first, key.second).size() + 2);
+    for (const auto& [key, c] : m_counters) width = std::max(width, series(key.first, key.second).size() + 2);
+
+    out << std::left << std::setw(static_cast<int>(width)) << "histogram" << std::right
+        << std::setw(10) << "count" << std::setw(11) << "mean" << std::setw(11) << "p50"
+        << std::setw(11) << "p90" << std::setw(11) << "p99" << std::setw(11) << "p99.9" << std::setw(11) << "max" << "\n";
+    for (const auto& [key, h] : m_histograms)
+    {
+        const auto count = h->Count();
+        const double mean = count != 0 ? static_cast<double>(h->SumNanos()) / static_cast<double>(count) : 0.0;
+        out << std::left << std::setw(static_cast<int>(width)) << series(key.first, key.second) << std::right
+            << std::setw(10) << count
+            << std::setw(11) << format_duration(mean)
+            << std::setw(11) << format_duration(static_cast<double>(h->Percentile(0.5)))
+            << std::setw(11) << format_duration(static_cast<double>(h->Percentile(0.9)))
+            << std::setw(11) << format_duration(static_cast<double>(h->Percentile(0.99)))
+            << std::setw(11) << format_duration(static_cast<double>(h->Percentile(0.999)))
+            << std::setw(11) << format_duration(static_cast<double>(h->MaxNanos())) << "\n";
+    }
+
+    if (m_counters.empty()) return;
+
+    out << "\n" << std::left << std::setw(static_cast<int>(width)) << "counter" << std::right << std::setw(10) << "value" << "\n";
+    for (const auto& [key, c] : m_counters)
+        out << std::left << std::setw(static_cast<int>(width)) << series(key.first, key.second) << std::right
+            << std::setw(10) << c->Value() << "\n";
+}
+
+void MetricsRegistry::WritePrometheus(std::ostream& out) const
+{
+    std::lock_guard lock(m_mutex);
+
+    // One HELP/TYPE header per metric name, before its first series.
+    std::string previous;
+    auto header = [&](const std::string& name, std::string_view type) {
+        if (name == previous) return;
+
+        previous = name;
+        if (auto it = m_help.find(name); it != m_help.end()) out << "# HELP " << name << " " << it->second << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+    };
+
+    for (const auto& [key, c] : m_counters)
+    {
+        header(key.first, "counter");
+        out << series(key.first, key.second) << " " << c->Value() << "\n";
+    }
+
+    previous.clear();
+    for (const auto& [key, h] : m_histograms)
+    {
+        header(key.first, "summary");
+        for (const auto& [q, label] : { std::pair{ 0.5, "quantile=\"0.5\"" }, std::pair{ 0.9, "quantile=\"0.9\"" },
+                                        std::pair{ 0.99, "quantile=\"0.99\"" }, std::pair{ 0.999, "quantile=\"0.999\"" } })
+            out << series(key.first, key.second, label) << " " << static_cast<double>(h->Percentile(q)) / 1e9 << "\n";
+
+        out << series(key.first + "_sum", key.second) << " " << static_cast<double>(h->SumNanos()) / 1e9 << "\n";
+        out << series(key.first + "_count", key.second) << " " << h->Count() << "\n";
+    }
+}
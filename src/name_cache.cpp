@@ -0,0 +1,53 @@
+#include "name_cache.h"
+#include "snapshot_io.h"
+
+StaffNameCache::StaffNameCache(std::span<const Staff> staffs,
+                               const NameTable& firstNames,
+                               const NameTable& secondNames,
+                               const NameTable* commonNames)
+{
+    m_offsets.reserve(staffs.size() + 1);
+    for (const auto& s : staffs)
+    {
+        m_offsets.push_back(static_cast<std::uint32_t>(m_arena.size()));
+        append_display_name(m_arena,
+                            commonNames != nullptr ? commonNames->GetById(s.CommonName) : std::string_view{},
+                            firstNames.GetById(s.FirstName),
+                            secondNames.GetById(s.SecondName));
+    }
+    m_offsets.push_back(static_cast<std::uint32_t>(m_arena.size()));
+
+    m_ids = IdIndex::Build(staffs, [](const Staff& s){ return s.id; });
+}
+
+void NameTable::Save(SnapshotWriter& out) const
+{
+    out.WriteString(m_arena);
+    out.Write(m_offsets);
+    m_ids.Save(out);
+}
+
+NameTable NameTable::Load(SnapshotReader& in)
+{
+    NameTable table;
+    table.m_arena = in.ReadString();
+    table.m_offsets = in.ReadVector<std::uint32_t>();
+    table.m_ids = IdIndex::Load(in);
+    return table;
+}
+
+void StaffNameCache::Save(SnapshotWriter& out) const
+{
+    out.WriteString(m_arena);
+    out.Write(m_offsets);
+    m_ids.Save(out);
+}
+
+StaffNameCache StaffNameCache::Load(SnapshotReader& in)
+{
+    StaffNameCache cache;
+    cache.m_arena = in.ReadString();
+    cache.m_offsets = in.ReadVector<std::uint32_t>();
+    cache.m_ids = IdIndex::Load(in);
+    return cache;
+}
@@ -0,0 +1,131 @@
+#include "player_columns.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CM_X86_KERNELS 1
+#endif
+
+struct ColumnRange {
+    const std::int8_t* column;
+    std::int8_t min;
+    std::int8_t max;
+};
+
+// Rows [first, rows) one at a time; also used for the tail the SIMD kernels leave.
+static void filter_scalar(const std::vector<ColumnRange>& ranges, std::size_t first, std::size_t rows, std::uint64_t* words)
+{
+    for (std::size_t row = first; row < rows; ++row)
+    {
+        bool keep = true;
+        for (const auto& r : ranges)
+        {
+            const auto v = r.column[row];
+            keep = keep && v >= r.min && v <= r.max;
+        }
+        if (keep) words[row / 64] |= std::uint64_t{1} << (row % 64);
+    }
+}
+
+#ifdef CM_X86_KERNELS
+
+// Bits of the 64 rows starting at `base` that fall outside [min, max].
+__attribute__((target("avx2")))
+static inline std::uint64_t out_of_range_avx2(const ColumnRange& r, std::size_t base)
+{
+    const __m256i lo = _mm256_set1_epi8(r.min);
+    const __m256i hi = _mm256_set1_epi8(r.max);
+    const auto* p = reinterpret_cast<const __m256i*>(r.column + base);
+
+    const __m256i a = _mm256_loadu_si256(p);
+    const __m256i b = _mm256_loadu_si256(p + 1);
+    const __m256i outA = _mm256_or_si256(_mm256_cmpgt_epi8(lo, a), _mm256_cmpgt_epi8(a, hi));
+    const __m256i outB = _mm256_or_si256(_mm256_cmpgt_epi8(lo, b), _mm256_cmpgt_epi8(b, hi));
+
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(outA))
+         | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(outB))) << 32);
+}
+
+__attribute__((target("avx2")))
+static std::size_t filter_avx2(const std::vector<ColumnRange>& ranges, std::size_t rows, std::uint64_t* words)
+{
+    const std::size_t full = rows / 64;
+    for (std::size_t w = 0; w < full; ++w)
+    {
+        std::uint64_t keep = ~std::uint64_t{0};
+        for (std::size_t i = 0; i < ranges.size() && keep != 0; ++i)
+            keep &= ~out_of_range_avx2(ranges[i], w * 64);
+        words[w] = keep;
+    }
+    return full * 64;
+}
+
+static inline std::uint64_t out_of_range_sse2(const ColumnRange& r, std::size_t base)
+{
+    const __m128i lo = _mm_set1_epi8(r.min);
+    const __m128i hi = _mm_set1_epi8(r.max);
+    const auto* p = reinterpret_cast<const __m128i*>(r.column + base);
+
+    std::uint64_t bits = 0;
+    for (int k = 0; k < 4; ++k)
+    {
+        const __m128i v = _mm_loadu_si128(p + k);
+        const __m128i out = _mm_or_si128(_mm_cmpgt_epi8(lo, v), _mm_cmpgt_epi8(v, hi));
+        bits |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(out))) << (16 * k);
+    }
+    return bits;
+}
+
+static std::size_t filter_sse2(const std::vector<ColumnRange>& ranges, std::size_t rows, std::uint64_t* words)
+{
+    const std::size_t full = rows / 64;
+    for (std::size_t w = 0; w < full; ++w)
+    {
+        std::uint64_t keep = ~std::uint64_t{0};
+        for (std::size_t i = 0; i < ranges.size() && keep != 0; ++i)
+            keep &= ~out_of_range_sse2(ranges[i], w * 64);
+        words[w] = keep;
+    }
+    return full * 64;
+}
+
+#endif
+
+PlayerColumns::PlayerColumns(std::span<const Player> players)
+    : m_rows(players.size()),
+      m_stride((players.size() + 63) / 64 * 64),
+      m_data(PLAYER_ATTRIBUTE_COUNT * m_stride, 0)
+{
+    m_ids.reserve(m_rows);
+
+    // Transpose in row order so every record is read exactly once.
+    for (std::size_t row = 0; row < m_rows; ++row)
+    {
+        const auto* attrs = reinterpret_cast<const std::int8_t*>(&players[row]) + PLAYER_ATTRIBUTE_OFFSET;
+        for (std::size_t a = 0; a < PLAYER_ATTRIBUTE_COUNT; ++a)
+            m_data[a * m_stride + row] = attrs[a];
+
+        m_ids.push_back(players[row].id);
+    }
+}
+
+SelectionBitmap PlayerColumns::Filter(std::span<const AttributeRange> ranges) const
+{
+    SelectionBitmap selection(m_rows);
+    auto* words = selection.Words().data();
+
+    std::vector<ColumnRange> columns;
+    columns.reserve(ranges.size());
+    for (const auto& r : ranges)
+        columns.push_back({ Column(r.attribute).data(), r.min, r.max });
+
+    std::size_t done = 0;
+#ifdef CM_X86_KERNELS
+    if (__builtin_cpu_supports("avx2"))
+        done = filter_avx2(columns, m_rows, words);
+    else
+        done = filter_sse2(columns, m_rows, words);
+#endif
+    filter_scalar(columns, done, m_rows, words);
+
+    return selection;
+}
@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "metrics.h"
+#include "player_similarity.h"
+#include "scan_executor.h"
+#include "selection_bitmap.h"
+#include "top_k.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CM_X86_KERNELS 1
+#endif
+
+// Largest quantized weight. With |x - t| <= 255 the product w * (x - t) stays
+// within int16 and a whole row's sum within int32, so every kernel is exact.
+static constexpr int WEIGHT_SCALE = 127;
+
+// k-means training: Lloyd iterations over an evenly strided sample of this many rows per list.
+static constexpr std::size_t KMEANS_ITERATIONS = 8;
+static constexpr std::size_t KMEANS_SAMPLE_PER_LIST = 64;
+static constexpr std::size_t KMEANS_MORSEL_ROWS = 1024;
+
+// The target widened to int16 and padded like the matrix rows, as the kernels read it.
+struct KernelQuery {
+    alignas(32) std::array<std::int16_t, SIMILARITY_DIMENSIONS> target{};
+    alignas(32) std::array<std::int16_t, SIMILARITY_DIMENSIONS> weight{};
+    alignas(32) std::array<std::int16_t, SIMILARITY_DIMENSIONS> weightedTarget{};  // weight * target
+};
+
+// Integer sums over one matrix row. WeightedL2: first = sum w (x - t)^2.
+// Cosine: first = sum w x t, second = sum w x^2.
+struct RowSums {
+    std::int32_t first;
+    std::int32_t second;
+};
+
+using RowKernel = RowSums (*)(const std::int8_t* row, const KernelQuery& q);
+
+// The reference the SIMD kernels match exactly; only dispatched to off x86.
+[[maybe_unused]] static RowSums l2_scalar(const std::int8_t* row, const KernelQuery& q)
+{
+    std::int32_t sum = 0;
+    for (std::size_t i = 0; i < SIMILARITY_DIMENSIONS; ++i)
+    {
+        const std::int32_t d = row[i] - q.target[i];
+        sum += d * d * q.weight[i];
+    }
+    return { sum, 0 };
+}
+
+[[maybe_unused]] static RowSums cosine_scalar(const std::int8_t* row, const KernelQuery& q)
+{
+    std::int32_t dot = 0;
+    std::int32_t norm = 0;
+    for (std::size_t i = 0; i < SIMILARITY_DIMENSIONS; ++i)
+    {
+        dot += row[i] * q.weightedTarget[i];
+        norm += row[i] * row[i] * q.weight[i];
+    }
+    return { dot, norm };
+}
+
+#ifdef CM_X86_KERNELS
+
+__attribute__((target("avx2")))
+static inline __m256i widen_avx2(const std::int8_t* p)
+{
+    return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load_avx2(const std::int16_t* p)
+{
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+static inline std::int32_t horizontal_sum(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("avx2")))
+static inline std::int32_t horizontal_sum_avx2(__m256i v)
+{
+    return horizontal_sum(_mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+
+// 16 attributes per step: widen to int16, then madd pairs of products into int32 lanes.
+__attribute__((target("avx2")))
+static RowSums l2_avx2(const std::int8_t* row, const KernelQuery& q)
+{
+    __m256i acc = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < SIMILARITY_DIMENSIONS; i += 16)
+    {
+        const __m256i d = _mm256_sub_epi16(widen_avx2(row + i), load_avx2(q.target.data() + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, _mm256_mullo_epi16(d, load_avx2(q.weight.data() + i))));
+    }
+    return { horizontal_sum_avx2(acc), 0 };
+}
+
+__attribute__((target("avx2")))
+static RowSums cosine_avx2(const std::int8_t* row, const KernelQuery& q)
+{
+    __m256i dot = _mm256_setzero_si256();
+    __m256i norm = _mm256_setzero_si256();
+    for (std::size_t i = 0; i < SIMILARITY_DIMENSIONS; i += 16)
+    {
+        const __m256i x = widen_avx2(row + i);
+        dot = _mm256_add_epi32(dot, _mm256_madd_epi16(x, load_avx2(q.weightedTarget.data() + i)));
+        norm = _mm256_add_epi32(norm, _mm256_madd_epi16(x, _mm256_mullo_epi16(x, load_avx2(q.weight.data() + i))));
+    }
+    return { horizontal_sum_avx2(dot), horizontal_sum_avx2(norm) };
+}
+
+// SSE2 has no sign-extending byte load: duplicate each byte into both halves
+// of a 16-bit lane, then shift the copy in the high half down arithmetically.
+static inline void widen_sse2(const std::int8_t* p, __m128i& lo, __m128i& hi)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+    hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+}
+
+static inline __m128i load_sse2(const std::int16_t* p)
+{
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static RowSums l2_sse2(const std::int8_t* row, const KernelQuery& q)
+{
+    __m128i acc = _mm_setzero_si128();
+    for (std::size_t i = 0; i < SIMILARITY_DIMENSIONS; i += 16)
+    {
+        __m128i lo, hi;
+        widen_sse2(row + i, lo, hi);
+        const __m128i dLo = _mm_sub_epi16(lo, load_sse2(q.target.data() + i));
+        const __m128i dHi = _mm_sub_epi16(hi, load_sse2(q.target.data() + i + 8));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(dLo, _mm_mullo_epi16(dLo, load_sse2(q.weight.data() + i))));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(dHi, _mm_mullo_epi16(dHi, load_sse2(q.weight.data() + i + 8))));
+    }
+    return { horizontal_sum(acc), 0 };
+}
+
+static RowSums cosine_sse2(const std::int8_t* row, const KernelQuery& q)
+{
+    __m128i dot = _mm_setzero_si128();
+    __m128i norm = _mm_setzero_si128();
+    for (std::size_t i = 0; i < SIMILARITY_DIMENSIONS; i += 16)
+    {
+        __m128i lo, hi;
+        widen_sse2(row + i, lo, hi);
+        dot = _mm_add_epi32(dot, _mm_madd_epi16(lo, load_sse2(q.weightedTarget.data() + i)));
+        dot = _mm_add_epi32(dot, _mm_madd_epi16(hi, load_sse2(q.weightedTarget.data() + i + 8)));
+        norm = _mm_add_epi32(norm, _mm_madd_epi16(lo, _mm_mullo_epi16(lo, load_sse2(q.weight.data() + i))));
+        norm = _mm_add_epi32(norm, _mm_madd_epi16(hi, _mm_mullo_epi16(hi, load_sse2(q.weight.data() + i + 8))));
+    }
+    return { horizontal_sum(dot), horizontal_sum(norm) };
+}
+
+#endif
+
+static RowKernel row_kernel(SimilarityMetric metric)
+{
+    const bool l2 = metric == SimilarityMetric::WeightedL2;
+#ifdef CM_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) return l2 ? l2_avx2 : cosine_avx2;
+    return l2 ? l2_sse2 : cosine_sse2;
+#else
+    return l2 ? l2_scalar : cosine_scalar;
+#endif
+}
+
+// A target ready for the kernels, with what it takes to turn row sums back into distances.
+struct PreparedTarget {
+    KernelQuery query;
+    double unitWeight;          // the weight one quantization step stands for
+    double targetNorm;          // sqrt(sum w t^2) in quantized weights, for Cosine
+};
+
+static PreparedTarget prepare(const SimilarityTarget& target)
+{
+    double maxWeight = 0;
+    for (double w : target.weights)
+    {
+        if (!(w >= 0) || !std::isfinite(w)) throw std::invalid_argument("Similarity weights must be finite and not negative.");
+        maxWeight = std::max(maxWeight, w);
+    }
+    if (maxWeight == 0) throw std::invalid_argument("At least one similarity weight must be positive.");
+
+    PreparedTarget prepared{ {}, maxWeight / WEIGHT_SCALE, 0 };
+    std::int64_t norm = 0;
+    for (std::size_t i = 0; i < PLAYER_ATTRIBUTE_COUNT; ++i)
+    {
+        // A positive weight below half a step would round to 0 and silently drop
+        // the attribute; it is kept at the smallest step instead.
+        long step = std::lround(target.weights[i] / maxWeight * WEIGHT_SCALE);
+        if (target.weights[i] > 0) step = std::max(step, 1L);
+        const auto w = static_cast<std::int16_t>(step);
+        const std::int16_t t = target.values[i];
+        prepared.query.target[i] = t;
+        prepared.query.weight[i] = w;
+        prepared.query.weightedTarget[i] = static_cast<std::int16_t>(w * t);
+        norm += std::int64_t{ w } * t * t;
+    }
+    prepared.targetNorm = std::sqrt(static_cast<double>(norm));
+    return prepared;
+}
+
+// Ranking score, higher is nearer. Rows of one target compare by cosine
+// similarity without dividing by the target's norm, which every row shares.
+static double score_of(SimilarityMetric metric, const RowSums& sums)
+{
+    if (metric == SimilarityMetric::WeightedL2) return -static_cast<double>(sums.first);
+    return sums.second == 0 ? 0.0 : sums.first / std::sqrt(static_cast<double>(sums.second));
+}
+
+static double distance_of(SimilarityMetric metric, const PreparedTarget& target, double score)
+{
+    if (metric == SimilarityMetric::WeightedL2) return std::sqrt(-score * target.unitWeight);
+    return target.targetNorm == 0 ? 1.0 : 1.0 - score / target.targetNorm;
+}
+
+// Unweighted squared L2 distance between a matrix row and a centroid, as k-means clusters them.
+static float centroid_distance(const std::int8_t* row, const float* centroid)
+{
+    float sum = 0;
+    for (std::size_t i = 0; i < PLAYER_ATTRIBUTE_COUNT; ++i)
+    {
+        const float d = static_cast<float>(row[i]) - centroid[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+// Index of the nearest of `lists` centroids for each of `rows`, in morsels on `pool` when given.
+static std::vector<std::uint32_t> nearest_centroids(const std::int8_t* matrix, std::span<const std::size_t> rows,
+                                                    const std::vector<float>& centroids, std::size_t lists, ThreadPool* pool)
+{
+    std::vector<std::uint32_t> nearest(rows.size());
+    auto assign = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const std::int8_t* row = matrix + rows[i] * SIMILARITY_DIMENSIONS;
+            float best = std::numeric_limits<float>::max();
+            for (std::size_t l = 0; l < lists; ++l)
+            {
+                const float d = centroid_distance(row, centroids.data() + l * SIMILARITY_DIMENSIONS);
+                if (d < best)
+                {
+                    best = d;
+                    nearest[i] = static_cast<std::uint32_t>(l);
+                }
+            }
+        }
+    };
+
+    if (pool == nullptr)
+        assign(0, rows.size(), 0);
+    else
+        ScanExecutor(*pool).ForEachMorsel(rows.size(), KMEANS_MORSEL_ROWS, assign);
+    return nearest;
+}
+
+std::array<double, PLAYER_ATTRIBUTE_COUNT> default_similarity_weights()
+{
+    std::array<double, PLAYER_ATTRIBUTE_COUNT> weights{};
+    std::fill(weights.begin() + static_cast<std::ptrdiff_t>(PlayerAttribute::Acceleration), weights.end(), 1.0);
+    return weights;
+}
+
+PlayerSimilarity::PlayerSimilarity(const Database& db, std::size_t lists, ThreadPool* pool)
+    : m_db(db)
+{
+    const auto rows = db.Joined().PlayerRows();
+    m_rows = rows.size();
+    m_matrix.assign(m_rows * SIMILARITY_DIMENSIONS, 0);
+    for (std::size_t row = 0; row < m_rows; ++row)
+        std::ranges::copy(rows[row].attributes, m_matrix.begin() + static_cast<std::ptrdiff_t>(row * SIMILARITY_DIMENSIONS));
+
+    if (lists > 0) BuildLists(lists, pool);
+}
+
+void PlayerSimilarity::BuildLists(std::size_t lists, ThreadPool* pool)
+{
+    lists = std::min(lists, m_rows);
+    if (lists == 0) return;
+
+    // Train on an evenly strided sample, starting from evenly strided sample rows.
+    const std::size_t sampleSize = std::min(m_rows, lists * KMEANS_SAMPLE_PER_LIST);
+    std::vector<std::size_t> sample(sampleSize);
+    for (std::size_t i = 0; i < sampleSize; ++i) sample[i] = i * m_rows / sampleSize;
+
+    m_centroids.assign(lists * SIMILARITY_DIMENSIONS, 0.0f);
+    for (std::size_t l = 0; l < lists; ++l)
+    {
+        const std::int8_t* row = m_matrix.data() + sample[l * sampleSize / lists] * SIMILARITY_DIMENSIONS;
+        std::copy(row, row + PLAYER_ATTRIBUTE_COUNT, m_centroids.begin() + static_cast<std::ptrdiff_t>(l * SIMILARITY_DIMENSIONS));
+    }
+
+    for (std::size_t iteration = 0; iteration < KMEANS_ITERATIONS; ++iteration)
+    {
+        const auto nearest = nearest_centroids(m_matrix.data(), sample, m_centroids, lists, pool);
+
+        std::vector<double> sums(lists * SIMILARITY_DIMENSIONS, 0.0);
+        std::vector<std::size_t> counts(lists, 0);
+        for (std::size_t i = 0; i < sampleSize; ++i)
+        {
+            const std::int8_t* row = m_matrix.data() + sample[i] * SIMILARITY_DIMENSIONS;
+            double* sum = sums.data() + nearest[i] * SIMILARITY_DIMENSIONS;
+            for (std::size_t a = 0; a < PLAYER_ATTRIBUTE_COUNT; ++a) sum[a] += row[a];
+            ++counts[nearest[i]];
+        }
+
+        // A list nothing was assigned to keeps its centroid.
+        for (std::size_t l = 0; l < lists; ++l)
+        {
+            if (counts[l] == 0) continue;
+            for (std::size_t a = 0; a < PLAYER_ATTRIBUTE_COUNT; ++a)
+                m_centroids[l * SIMILARITY_DIMENSIONS + a] = static_cast<float>(sums[l * SIMILARITY_DIMENSIONS + a] / static_cast<double>(counts[l]));
+        }
+    }
+
+    // Assign every row, then lay the lists out back to back, each in row order.
+    std::vector<std::size_t> all(m_rows);
+    std::iota(all.begin(), all.end(), std::size_t{0});
+    const auto listOf = nearest_centroids(m_matrix.data(), all, m_centroids, lists, pool);
+
+    m_listBegin.assign(lists + 1, 0);
+    for (auto l : listOf) ++m_listBegin[l + 1];
+    std::partial_sum(m_listBegin.begin(), m_listBegin.end(), m_listBegin.begin());
+
+    std::vector<std::uint32_t> next(m_listBegin.begin(), m_listBegin.end() - 1);
+    m_listRows.resize(m_rows);
+    m_listMatrix.resize(m_matrix.size());
+    for (std::size_t row = 0; row < m_rows; ++row)
+    {
+        const std::size_t entry = next[listOf[row]]++;
+        m_listRows[entry] = static_cast<std::uint32_t>(row);
+        std::copy_n(m_matrix.begin() + static_cast<std::ptrdiff_t>(row * SIMILARITY_DIMENSIONS), SIMILARITY_DIMENSIONS,
+                    m_listMatrix.begin() + static_cast<std::ptrdiff_t>(entry * SIMILARITY_DIMENSIONS));
+    }
+}
+
+std::optional<SimilarityTarget> PlayerSimilarity::TargetOf(std::int32_t staffId, std::span<const AttributeWeight> weights) const
+{
+    const auto staffRow = m_db.Staffs().RowOf(staffId);
+    if (!staffRow.has_value()) return std::nullopt;
+
+    const auto row = m_db.Joined().PlayerRowOf(*staffRow);
+    if (!row.has_value()) return std::nullopt;
+
+    SimilarityTarget target;
+    std::copy_n(m_matrix.begin() + static_cast<std::ptrdiff_t>(*row * SIMILARITY_DIMENSIONS), PLAYER_ATTRIBUTE_COUNT, target.values.begin());
+    if (weights.empty())
+        target.weights = default_similarity_weights();
+    else
+        for (const auto& w : weights) target.weights[static_cast<std::size_t>(w.attribute)] = w.weight;
+    target.staffRow = *staffRow;
+    return target;
+}
+
+std::vector<SimilarPlayer> PlayerSimilarity::Nearest(const SimilarityTarget& target, const SimilarityOptions& options) const
+{
+    CM_TIME_SCOPE("cm_query_seconds", "type=\"similarity\"");
+
+    const PreparedTarget prepared = prepare(target);
+    if (options.k == 0 || m_rows == 0) return {};
+
+    const auto& join = m_db.Joined();
+    const RowKernel kernel = row_kernel(options.metric);
+
+    std::optional<std::size_t> excluded;
+    if (target.staffRow.has_value()) excluded = join.PlayerRowOf(*target.staffRow);
+
+    // The staff-row filter as a bitmap over PlayerRows positions.
+    std::optional<SelectionBitmap> selection;
+    if (options.staffRows != nullptr)
+    {
+        selection.emplace(m_rows);
+        options.staffRows->ForEach([&](std::uint32_t staffRow) {
+            if (const auto row = join.PlayerRowOf(staffRow)) selection->Set(*row);
+        });
+    }
+
+    TopKHeap heap(options.k);
+    auto visit = [&](std::size_t row, const std::int8_t* attributes) {
+        if (row != excluded) heap.Push({ row, score_of(options.metric, kernel(attributes, prepared.query)) });
+    };
+
+    if (options.probes == 0 || Lists() == 0)
+    {
+        if (selection.has_value())
+            selection->ForEach([&](std::size_t row) { visit(row, m_matrix.data() + row * SIMILARITY_DIMENSIONS); });
+        else
+            for (std::size_t row = 0; row < m_rows; ++row) visit(row, m_matrix.data() + row * SIMILARITY_DIMENSIONS);
+    }
+    else
+    {
+        // Rank the centroids by the query's own metric and weights, then scan the nearest lists.
+        std::vector<std::pair<double, std::size_t>> lists(Lists());
+        for (std::size_t l = 0; l < lists.size(); ++l)
+        {
+            const float* c = m_centroids.data() + l * SIMILARITY_DIMENSIONS;
+            double l2 = 0, dot = 0, norm = 0;
+            for (std::size_t a = 0; a < PLAYER_ATTRIBUTE_COUNT; ++a)
+            {
+                const double w = prepared.query.weight[a];
+                const double d = c[a] - prepared.query.target[a];
+                l2 += w * d * d;
+                dot += w * c[a] * prepared.query.target[a];
+                norm += w * c[a] * c[a];
+            }
+            const double cosine = norm == 0 || prepared.targetNorm == 0 ? 0.0 : dot / (std::sqrt(norm) * prepared.targetNorm);
+            lists[l] = { options.metric == SimilarityMetric::WeightedL2 ? l2 : -cosine, l };
+        }
+
+        const std::size_t probes = std::min(options.probes, lists.size());
+        std::ranges::partial_sort(lists, lists.begin() + static_cast<std::ptrdiff_t>(probes));
+        for (std::size_t p = 0; p < probes; ++p)
+        {
+            const std::size_t l = lists[p].second;
+            for (std::size_t entry = m_listBegin[l]; entry < m_listBegin[l + 1]; ++entry)
+            {
+                const std::size_t row = m_listRows[entry];
+                if (!selection.has_value() || selection->Test(row))
+                    visit(row, m_listMatrix.data() + entry * SIMILARITY_DIMENSIONS);
+            }
+        }
+    }
+
+    const auto staffs = m_db.Staffs().Records();
+    const auto players = m_db.Players().Records();
+    const auto rows = join.PlayerRows();
+
+    std::vector<SimilarPlayer> res;
+    res.reserve(heap.Size());
+    for (const auto& r : std::move(heap).Sorted())
+        res.push_back({ &staffs[rows[r.row].staffRow], &players[rows[r.row].playerRow], distance_of(options.metric, prepared, r.score) });
+    return res;
+}
@@ -0,0 +1,168 @@
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "database.h"
+#include "query_planner.h"
+#include "text_encoding.h"
+
+namespace fs = std::filesystem;
+
+// Runs query-language statements against one loaded database:
+//   cm-query data/v2 "player where Finishing>=15 and age<23 order by PotentialAbility desc limit 50"
+//   cm-query data/v2 "explain staff where Nation=12 and Value>=1000000"
+// Without a query on the command line, reads one query per line from stdin.
+
+struct CliOptions {
+    fs::path dataDir;
+    std::optional<fs::path> snapshot;
+    QueryOptions query;
+    std::string text;
+};
+
+static void usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0 << " <data-dir> [--snapshot FILE] [--today YEAR:DAY] [query]\n"
+              << "Queries look like: player where Finishing>=15 and age<23 order by PotentialAbility desc limit 50\n"
+              << "Prefix with EXPLAIN for the chosen plan with estimated and actual row counts.\n"
+              << "age and contract_days count from --today (default 2001:0); without a query, stdin is read line by line.\n";
+}
+
+static std::optional<int> parse_int(std::string_view text)
+{
+    int n = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), n);
+    if (ec != std::errc() || ptr != text.data() + text.size() || text.empty()) return std::nullopt;
+
+    return n;
+}
+
+// YEAR:DAY with DAY the zero-based day of the year, as stored in CMDate.
+static std::optional<CMDate> parse_date(std::string_view text)
+{
+    const auto colon = text.find(':');
+    if (colon == std::string_view::npos) return std::nullopt;
+
+    const auto year = parse_int(text.substr(0, colon));
+    const auto day = parse_int(text.substr(colon + 1));
+    if (!year || !day || *year < 1 || *year > 9999) return std::nullopt;
+
+    const bool leap = std::chrono::year(*year).is_leap();
+    if (*day < 0 || *day > (leap ? 365 : 364)) return std::nullopt;
+
+    CMDate date{};
+    date.Day = static_cast<std::int16_t>(*day);
+    date.Year = static_cast<std::int16_t>(*year);
+    date.LeapYear = leap ? 1 : 0;
+    return date;
+}
+
+static bool parse_args(int argc, char** argv, CliOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--snapshot" && i + 1 < argc)
+        {
+            options.snapshot = fs::path(argv[++i]);
+        }
+        else if (arg == "--today" && i + 1 < argc)
+        {
+            const auto today = parse_date(argv[++i]);
+            if (!today.has_value()) return false;
+            options.query.today = *today;
+        }
+        else if (arg.starts_with("--"))
+        {
+            return false;
+        }
+        else if (options.dataDir.empty())
+        {
+            options.dataDir = arg;
+        }
+        else
+        {
+            if (!options.text.empty()) options.text += ' ';
+            options.text += arg;
+        }
+    }
+    return !options.dataDir.empty();
+}
+
+static void print_rows(const Database& db, const QueryEngine& engine, const QueryPlan& plan, const QueryResult& result)
+{
+    std::cout << "id\tname";
+    for (const auto& column : result.columns) std::cout << '\t' << column.name;
+    std::cout << '\n';
+
+    for (auto row : result.rows)
+    {
+        const std::int32_t id = plan.table == QueryTable::Club ? db.Clubs().Records()[row].id : db.Staffs().Records()[row].id;
+        std::cout << id << '\t' << cp1252_to_utf8(engine.RowName(plan.table, row));
+        for (const auto& column : result.columns)
+        {
+            std::cout << '\t';
+            if (const auto value = engine.Value(column, plan.table, row)) std::cout << *value;
+        }
+        std::cout << '\n';
+    }
+    std::cout << "(" << result.rows.size() << " rows, " << std::fixed << std::setprecision(3) << result.milliseconds << " ms)\n";
+}
+
+// False when the query does not parse or bind.
+static bool run_query(const Database& db, const QueryEngine& engine, std::string_view text)
+{
+    try
+    {
+        const QueryPlan plan = engine.Plan(text);
+        const QueryResult result = engine.Execute(plan);
+        if (plan.explain)
+            write_explain(std::cout, plan, result);
+        else
+            print_rows(db, engine, plan, result);
+        return true;
+    }
+    catch (const QueryError& e)
+    {
+        std::cerr << "[error] " << e.what() << "\n";
+        return false;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    CliOptions options;
+    if (!parse_args(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::shared_ptr<const Database> db;
+    try
+    {
+        db = options.snapshot ? Database::Open(options.dataDir, *options.snapshot) : Database::Load(options.dataDir);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[error] " << e.what() << "\n";
+        return 1;
+    }
+
+    const QueryEngine engine(*db, options.query);
+    if (!options.text.empty()) return run_query(*db, engine, options.text) ? 0 : 1;
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        run_query(*db, engine, line);
+    }
+    return 0;
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+#include "query_language.h"
+
+enum class QueryTokenKind : std::uint8_t { Word, Number, Symbol, End };
+
+struct QueryToken {
+    QueryTokenKind kind;
+    std::string_view text;
+    std::size_t position;
+    std::int64_t number = 0;
+};
+
+static bool is_word_start(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+static bool is_word_char(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+static bool is_digit(char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+
+static std::vector<QueryToken> tokenize(std::string_view text)
+{
+    std::vector<QueryToken> tokens;
+    std::size_t i = 0;
+    while (i < text.size())
+    {
+        const char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            ++i;
+            continue;
+        }
+
+        const std::size_t start = i;
+        if (is_word_start(c))
+        {
+            while (i < text.size() && is_word_char(text[i])) ++i;
+            tokens.push_back({ QueryTokenKind::Word, text.substr(start, i - start), start });
+        }
+        else if (is_digit(c) || (c == '-' && i + 1 < text.size() && is_digit(text[i + 1])))
+        {
+            ++i;
+            while (i < text.size() && is_digit(text[i])) ++i;
+
+            QueryToken token{ QueryTokenKind::Number, text.substr(start, i - start), start };
+            auto [ptr, ec] = std::from_chars(text.data() + start, text.data() + i, token.number);
+            if (ec != std::errc()) throw QueryError("number out of range: " + std::string(token.text), start);
+            tokens.push_back(token);
+        }
+        else
+        {
+            // Two-character operators first, then single characters.
+            const std::string_view two = text.substr(i, 2);
+            if (two == "<=" || two == ">=" || two == "!=" || two == "<>")
+                i += 2;
+            else if (std::string_view("=<>(),").find(c) != std::string_view::npos)
+                ++i;
+            else
+                throw QueryError(std::string("unexpected character '") + c + "'", start);
+
+            tokens.push_back({ QueryTokenKind::Symbol, text.substr(start, i - start), start });
+        }
+    }
+    tokens.push_back({ QueryTokenKind::End, {}, text.size() });
+    return tokens;
+}
+
+class QueryParser {
+
+public:
+    explicit QueryParser(std::string_view text): m_tokens(tokenize(text)) {}
+
+    ParsedQuery Parse()
+    {
+        ParsedQuery query;
+        if (Accept("explain")) query.explain = true;
+
+        const QueryToken& table = Expect(QueryTokenKind::Word, "a table name");
+        if (equals_ignore_case(table.text, "player") || equals_ignore_case(table.text, "players"))
+            query.table = QueryTable::Player;
+        else if (equals_ignore_case(table.text, "staff"))
+            query.table = QueryTable::Staff;
+        else if (equals_ignore_case(table.text, "club") || equals_ignore_case(table.text, "clubs"))
+            query.table = QueryTable::Club;
+        else
+            throw QueryError("unknown table '" + std::string(table.text) + "' (expected player, staff or club)", table.position);
+
+        if (Accept("where"))
+        {
+            do query.where.push_back(ParseCondition());
+            while (Accept("and"));
+        }
+
+        if (Accept("order"))
+        {
+            ExpectKeyword("by");
+            const QueryToken& field = Expect(QueryTokenKind::Word, "a field name");
+            OrderClause order{ std::string(field.text), false, field.position };
+            if (Accept("desc"))
+                order.descending = true;
+            else
+                Accept("asc");
+            query.orderBy = std::move(order);
+        }
+
+        if (Accept("limit"))
+        {
+            const QueryToken& n = Expect(QueryTokenKind::Number, "a row count");
+            if (n.number < 0) throw QueryError("LIMIT must not be negative", n.position);
+            query.limit = static_cast<std::size_t>(n.number);
+        }
+
+        if (Peek().kind != QueryTokenKind::End)
+            throw QueryError("unexpected '" + std::string(Peek().text) + "'", Peek().position);
+        return query;
+    }
+
+private:
+    std::vector<QueryToken> m_tokens;
+    std::size_t m_next = 0;
+
+    const QueryToken& Peek() const { return m_tokens[m_next]; }
+
+    const QueryToken& Take() { return m_tokens[m_next < m_tokens.size() - 1 ? m_next++ : m_next]; }
+
+    bool IsKeyword(const QueryToken& token, std::string_view keyword) const
+    {
+        return token.kind == QueryTokenKind::Word && equals_ignore_case(token.text, keyword);
+    }
+
+    bool Accept(std::string_view keyword)
+    {
+        if (!IsKeyword(Peek(), keyword)) return false;
+        Take();
+        return true;
+    }
+
+    bool AcceptSymbol(std::string_view symbol)
+    {
+        if (Peek().kind != QueryTokenKind::Symbol || Peek().text != symbol) return false;
+        Take();
+        return true;
+    }
+
+    [[noreturn]] void Fail(std::string_view expected) const
+    {
+        const QueryToken& token = Peek();
+        const std::string found = token.kind == QueryTokenKind::End ? "end of query" : "'" + std::string(token.text) + "'";
+        throw QueryError("expected " + std::string(expected) + ", found " + found, token.position);
+    }
+
+    const QueryToken& Expect(QueryTokenKind kind, std::string_view expected)
+    {
+        if (Peek().kind != kind) Fail(expected);
+        return Take();
+    }
+
+    void ExpectKeyword(std::string_view keyword)
+    {
+        if (!Accept(keyword)) Fail(keyword);
+    }
+
+    void ExpectSymbol(std::string_view symbol)
+    {
+        if (!AcceptSymbol(symbol)) Fail("'" + std::string(symbol) + "'");
+    }
+
+    QueryValue ParseValue()
+    {
+        const QueryToken& token = Peek();
+        if (token.kind == QueryTokenKind::Number)
+        {
+            Take();
+            return token.number;
+        }
+        if (token.kind == QueryTokenKind::Word)
+        {
+            Take();
+            return std::string(token.text);
+        }
+        Fail("a number or a name");
+    }
+
+    Condition ParseCondition()
+    {
+        const QueryToken& field = Expect(QueryTokenKind::Word, "a field name");
+        Condition condition{ std::string(field.text), CompareOp::Equal, {}, field.position };
+
+        if (Accept("in"))
+        {
+            condition.op = CompareOp::In;
+            ExpectSymbol("(");
+            do condition.values.push_back(ParseValue());
+            while (AcceptSymbol(","));
+            ExpectSymbol(")");
+            return condition;
+        }
+
+        if (Accept("between"))
+        {
+            condition.op = CompareOp::Between;
+            condition.values.push_back(ParseValue());
+            ExpectKeyword("and");
+            condition.values.push_back(ParseValue());
+            return condition;
+        }
+
+        const QueryToken& op = Peek();
+        if (op.kind != QueryTokenKind::Symbol) Fail("a comparison");
+        if (op.text == "=")
+            condition.op = CompareOp::Equal;
+        else if (op.text == "!=" || op.text == "<>")
+            condition.op = CompareOp::NotEqual;
+        else if (op.text == "<")
+            condition.op = CompareOp::Less;
+        else if (op.text == "<=")
+            condition.op = CompareOp::LessEqual;
+        else if (op.text == ">")
+            condition.op = CompareOp::Greater;
+        else if (op.text == ">=")
+            condition.op = CompareOp::GreaterEqual;
+        else
+            Fail("a comparison");
+        Take();
+
+        condition.values.push_back(ParseValue());
+        return condition;
+    }
+
+};
+
+static std::string value_text(const QueryValue& value)
+{
+    if (const auto* n = std::get_if<std::int64_t>(&value)) return std::to_string(*n);
+    return std::get<std::string>(value);
+}
+
+ParsedQuery parse_query(std::string_view text)
+{
+    return QueryParser(text).Parse();
+}
+
+std::string_view table_name(QueryTable table)
+{
+    switch (table)
+    {
+    case QueryTable::Staff: return "staff";
+    case QueryTable::Player: return "player";
+    case QueryTable::Club: return "club";
+    }
+    return "?";
+}
+
+bool equals_ignore_case(std::string_view a, std::string_view b)
+{
+    return std::ranges::equal(a, b, [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+std::string to_string(const Condition& condition)
+{
+    static constexpr std::string_view OPERATORS[] = { " = ", " != ", " < ", " <= ", " > ", " >= " };
+
+    std::string text = condition.field;
+    switch (condition.op)
+    {
+    case CompareOp::In:
+        text += " IN (";
+        for (std::size_t i = 0; i < condition.values.size(); ++i)
+            text += (i == 0 ? "" : ", ") + value_text(condition.values[i]);
+        return text + ")";
+    case CompareOp::Between:
+        return text + " BETWEEN " + value_text(condition.values[0]) + " AND " + value_text(condition.values[1]);
+    default:
+        return text + std::string(OPERATORS[static_cast<std::size_t>(condition.op)]) + value_text(condition.values[0]);
+    }
+}
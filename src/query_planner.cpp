@@ -0,0 +1,1007 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+
+#include "metrics.h"
+#include "query_planner.h"
+#include "secondary_indexes.h"
+#include "top_k.h"
+
+// Planner cost units, relative to reading one record in a sequential scan.
+static constexpr double COST_ROW = 1.0;
+static constexpr double COST_RANDOM_ROW = 3.0;          // a record at a row picked by an index
+static constexpr double COST_PREDICATE = 0.5;           // one row-by-row predicate check
+static constexpr double COST_JOIN_LOOKUP = 1.5;         // StaffJoin::PlayerOf and the player record it names
+static constexpr double COST_BITMAP_VALUE = 0.05;       // one row through a bitmap OR / AND
+static constexpr double COST_INDEX_SEARCH = 20.0;       // the two searches of a range index slice
+static constexpr double COST_INDEX_ENTRY = 0.3;         // one range index row scattered into a bitmap
+static constexpr double COST_DAY_COMPARE = 0.05;        // one day of one column in the SIMD filter
+static constexpr double COST_MEMBERSHIP = 0.2;          // one bitmap Contains
+static constexpr double COST_SORT_COMPARE = 0.3;        // one heap comparison
+
+// Query numbers are clamped to one step past the int32 range: no field holds
+// more, so comparisons keep their meaning and +-1 cannot overflow.
+static constexpr std::int64_t VALUE_MIN = std::int64_t{ INT32_MIN } - 1;
+static constexpr std::int64_t VALUE_MAX = std::int64_t{ INT32_MAX } + 1;
+static constexpr std::int64_t OPEN_MIN = std::numeric_limits<std::int64_t>::min();
+static constexpr std::int64_t OPEN_MAX = std::numeric_limits<std::int64_t>::max();
+
+// Ages past this are treated as an open end.
+static constexpr std::int64_t AGE_LIMIT = 1000;
+
+struct QueryEngine::RowRecords {
+    std::size_t row;
+    const Staff* staff = nullptr;
+    const Player* player = nullptr;     // set when asked for and the staff member has one
+    const Club* club = nullptr;
+};
+
+// The index that answers predicates on a column, if it has one.
+struct IndexSource {
+    const BitmapIndex* bitmap = nullptr;
+    const RangeIndex* range = nullptr;
+    bool natural = false;
+    bool playerRowsOnly = false;        // holds only staff with a player record
+    std::string_view name;
+};
+
+static std::optional<IndexSource> index_source(const SecondaryIndexes& s, const BoundColumn& column)
+{
+    const std::string_view field = column.field != nullptr ? column.field->name : std::string_view{};
+    switch (column.kind)
+    {
+    case ColumnKind::StaffField:
+        if (field == "Nation") return IndexSource{ &s.StaffNation(), nullptr, false, false, "Nation bitmaps" };
+        if (field == "Classification") return IndexSource{ &s.StaffClassification(), nullptr, false, false, "Classification bitmaps" };
+        if (field == "JobForClub") return IndexSource{ &s.StaffJobForClub(), nullptr, false, false, "JobForClub bitmaps" };
+        if (field == "PlayingSquad") return IndexSource{ &s.StaffPlayingSquad(), nullptr, false, false, "PlayingSquad bitmaps" };
+        if (field == "Value") return IndexSource{ nullptr, &s.StaffValue(), false, false, "Value range index" };
+        if (field == "Wage") return IndexSource{ nullptr, &s.StaffWage(), false, false, "Wage range index" };
+        break;
+    case ColumnKind::PlayerField:
+        if (field == "CurrentAbility") return IndexSource{ nullptr, &s.PlayerCurrentAbility(), false, true, "CurrentAbility range index" };
+        if (field == "PotentialAbility") return IndexSource{ nullptr, &s.PlayerPotentialAbility(), false, true, "PotentialAbility range index" };
+        if (field == "WorldReputation") return IndexSource{ nullptr, &s.PlayerWorldReputation(), false, true, "WorldReputation range index" };
+        break;
+    case ColumnKind::ClubField:
+        if (field == "division_id") return IndexSource{ &s.ClubDivision(), nullptr, false, false, "division_id bitmaps" };
+        break;
+    case ColumnKind::Age:
+        return IndexSource{ nullptr, &s.StaffBirthDay(), false, false, "birth day range index" };
+    case ColumnKind::ContractDays:
+        return IndexSource{ nullptr, &s.StaffClubExpiryDay(), false, false, "club expiry range index" };
+    case ColumnKind::Natural:
+        return IndexSource{ nullptr, nullptr, true, true, "natural position bitmaps" };
+    }
+    return std::nullopt;
+}
+
+// The part of a value range an int32 key can hold; std::nullopt when none.
+static std::optional<IntRange> key_range(const ValueRange& r)
+{
+    if (r.min > r.max || r.min > INT32_MAX || r.max < INT32_MIN) return std::nullopt;
+
+    return IntRange{ static_cast<std::int32_t>(std::max<std::int64_t>(r.min, INT32_MIN)),
+                     static_cast<std::int32_t>(std::min<std::int64_t>(r.max, INT32_MAX)) };
+}
+
+// Natural position indexes in a range, clipped to Goalkeeper..FreeRole.
+static std::pair<std::size_t, std::size_t> position_span(const ValueRange& r)
+{
+    const auto first = static_cast<std::size_t>(std::clamp<std::int64_t>(r.min, 0, PLAYER_POSITION_COUNT));
+    const auto last = static_cast<std::size_t>(std::clamp<std::int64_t>(r.max + 1, 0, PLAYER_POSITION_COUNT));
+    return { first, std::max(first, last) };
+}
+
+// Exact number of rows a probe returns (natural: an upper bound, positions overlap).
+static std::size_t probe_count(const SecondaryIndexes& s, const IndexSource& source, const BoundPredicate& p)
+{
+    std::size_t count = 0;
+    for (const auto& r : p.ranges)
+    {
+        if (source.natural)
+        {
+            const auto [first, last] = position_span(r);
+            for (std::size_t pos = first; pos < last; ++pos)
+                count += s.StaffNaturalAt(static_cast<PlayerAttribute>(pos)).Cardinality();
+            continue;
+        }
+
+        const auto keys = key_range(r);
+        if (!keys.has_value()) continue;
+
+        if (source.range != nullptr)
+        {
+            count += source.range->Between(*keys).size();
+            continue;
+        }
+        const auto values = source.bitmap->Values();
+        for (auto it = std::ranges::lower_bound(values, keys->min); it != values.end() && *it <= keys->max; ++it)
+            count += source.bitmap->Equal(*it).Cardinality();
+    }
+    return count;
+}
+
+static double probe_cost(const IndexSource& source, const BoundPredicate& p, double rows)
+{
+    if (source.range != nullptr) return static_cast<double>(p.ranges.size()) * COST_INDEX_SEARCH + rows * COST_INDEX_ENTRY;
+    return rows * COST_BITMAP_VALUE;
+}
+
+static RoaringBitmap probe_bitmap(const SecondaryIndexes& s, const IndexSource& source, const BoundPredicate& p)
+{
+    std::deque<RoaringBitmap> owned;
+    std::vector<const RoaringBitmap*> parts;
+    for (const auto& r : p.ranges)
+    {
+        if (source.natural)
+        {
+            const auto [first, last] = position_span(r);
+            for (std::size_t pos = first; pos < last; ++pos)
+                parts.push_back(&s.StaffNaturalAt(static_cast<PlayerAttribute>(pos)));
+            continue;
+        }
+
+        const auto keys = key_range(r);
+        if (!keys.has_value()) continue;
+
+        if (source.range != nullptr)
+        {
+            parts.push_back(&owned.emplace_back(source.range->BitmapBetween(*keys)));
+            continue;
+        }
+        const auto values = source.bitmap->Values();
+        for (auto it = std::ranges::lower_bound(values, keys->min); it != values.end() && *it <= keys->max; ++it)
+            parts.push_back(&source.bitmap->Equal(*it));
+    }
+
+    if (parts.size() == 1) return *parts.front();
+    return RoaringBitmap::unite(parts);
+}
+
+static bool uses_player(const BoundColumn& column)
+{
+    return column.kind == ColumnKind::PlayerField || column.kind == ColumnKind::Natural;
+}
+
+// Share of staff rows with a player record.
+static double player_fraction(const Database& db)
+{
+    const std::size_t staffs = db.Staffs().Size();
+    return staffs == 0 ? 0.0 : static_cast<double>(db.Joined().PlayerRows().size()) / static_cast<double>(staffs);
+}
+
+static StaffDate date_of(ColumnKind kind)
+{
+    return kind == ColumnKind::Age ? StaffDate::Birth : StaffDate::ExpiresClub;
+}
+
+template <typename T>
+static const FieldDescriptor* find_field_ignore_case(std::string_view name)
+{
+    for (const auto& f : RecordSchema<T>::fields)
+        if (equals_ignore_case(f.name, name)) return &f;
+
+    return nullptr;
+}
+
+// "1 probe", "2 probes".
+static std::string count_of(std::size_t n, std::string_view noun)
+{
+    return std::to_string(n) + " " + std::string(noun) + (n == 1 ? "" : "s");
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string_view access_path_name(AccessPath access)
+{
+    switch (access)
+    {
+    case AccessPath::TableScan: return "TableScan";
+    case AccessPath::JoinRowScan: return "JoinRowScan";
+    case AccessPath::DateColumnScan: return "DateColumnScan";
+    case AccessPath::IndexProbe: return "IndexProbe";
+    case AccessPath::OrderedIndexScan: return "OrderedIndexScan";
+    }
+    return "?";
+}
+
+QueryEngine::QueryEngine(const Database& db, QueryOptions options)
+    : m_db(db), m_options(options), m_today(day_number(options.today))
+{
+}
+
+BoundColumn QueryEngine::BindColumn(QueryTable table, std::string_view name, std::size_t position) const
+{
+    const FieldDescriptor* field = nullptr;
+    ColumnKind kind = ColumnKind::ClubField;
+    if (table == QueryTable::Club)
+    {
+        field = find_field_ignore_case<Club>(name);
+    }
+    else if (equals_ignore_case(name, "age"))
+    {
+        return { "age", ColumnKind::Age };
+    }
+    else if (equals_ignore_case(name, "contract_days"))
+    {
+        return { "contract_days", ColumnKind::ContractDays };
+    }
+    else if (equals_ignore_case(name, "natural"))
+    {
+        return { "natural", ColumnKind::Natural };
+    }
+    else if ((field = find_field_ignore_case<Staff>(name)) != nullptr)
+    {
+        kind = ColumnKind::StaffField;
+    }
+    else
+    {
+        field = find_field_ignore_case<Player>(name);
+        kind = ColumnKind::PlayerField;
+    }
+
+    if (field == nullptr)
+        throw QueryError(std::string(table_name(table)) + " has no column '" + std::string(name) + "'", position);
+
+    switch (field->type)
+    {
+    case FieldType::Integer:
+        return { std::string(field->name), kind, field };
+    case FieldType::Date:
+        throw QueryError(std::string(field->name) + " is a date; use age or contract_days", position);
+    case FieldType::Text:
+        throw QueryError(std::string(field->name) + " is text and cannot be compared", position);
+    case FieldType::IntegerArray:
+        throw QueryError(std::string(field->name) + " is a list and cannot be compared", position);
+    }
+    throw QueryError("unsupported column " + std::string(name), position);
+}
+
+BoundPredicate QueryEngine::BindPredicate(QueryTable table, const Condition& condition) const
+{
+    BoundPredicate p{ to_string(condition), BindColumn(table, condition.field, condition.position), {} };
+
+    if (p.column.kind == ColumnKind::Natural)
+    {
+        if (condition.op != CompareOp::Equal && condition.op != CompareOp::In)
+            throw QueryError("natural only supports = and IN", condition.position);
+
+        for (const auto& value : condition.values)
+        {
+            const auto* name = std::get_if<std::string>(&value);
+            const FieldDescriptor* f = name != nullptr ? find_field_ignore_case<Player>(*name) : nullptr;
+            const std::size_t index = f != nullptr ? f->offset - PLAYER_ATTRIBUTE_OFFSET : PLAYER_POSITION_COUNT;
+            if (f == nullptr || f->offset < PLAYER_ATTRIBUTE_OFFSET || index >= PLAYER_POSITION_COUNT)
+                throw QueryError("natural takes position names, Goalkeeper to FreeRole", condition.position);
+
+            const auto i = static_cast<std::int64_t>(index);
+            p.ranges.push_back({ i, i });
+        }
+        return p;
+    }
+
+    std::vector<std::int64_t> numbers;
+    for (const auto& value : condition.values)
+    {
+        if (const auto* name = std::get_if<std::string>(&value))
+            throw QueryError("expected a number for " + p.column.name + ", found '" + *name
+                             + "' (names are not resolved; use the numeric id)", condition.position);
+        numbers.push_back(std::clamp(std::get<std::int64_t>(value), VALUE_MIN, VALUE_MAX));
+    }
+
+    std::vector<ValueRange> ranges;
+    const std::int64_t v = numbers.front();
+    switch (condition.op)
+    {
+    case CompareOp::Equal: ranges = { { v, v } }; break;
+    case CompareOp::NotEqual: ranges = { { OPEN_MIN, v - 1 }, { v + 1, OPEN_MAX } }; break;
+    case CompareOp::Less: ranges = { { OPEN_MIN, v - 1 } }; break;
+    case CompareOp::LessEqual: ranges = { { OPEN_MIN, v } }; break;
+    case CompareOp::Greater: ranges = { { v + 1, OPEN_MAX } }; break;
+    case CompareOp::GreaterEqual: ranges = { { v, OPEN_MAX } }; break;
+    case CompareOp::Between: ranges = { { numbers[0], numbers[1] } }; break;
+    case CompareOp::In:
+        std::ranges::sort(numbers);
+        numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+        for (auto n : numbers) ranges.push_back({ n, n });
+        break;
+    }
+
+    for (const auto& r : ranges)
+    {
+        if (r.min > r.max) continue;
+
+        if (p.column.kind == ColumnKind::Age)
+        {
+            // Older means born earlier: ages [min, max] are birth days
+            // (latest_birth_day(max + 1), latest_birth_day(min)]. NO_DAY never matches.
+            if (r.max < -AGE_LIMIT || r.min > AGE_LIMIT) continue;
+            const std::int64_t first = r.max >= AGE_LIMIT ? NO_DAY + 1 : latest_birth_day(static_cast<int>(r.max) + 1, m_options.today) + 1;
+            const std::int64_t last = r.min <= -AGE_LIMIT ? INT32_MAX : latest_birth_day(static_cast<int>(r.min), m_options.today);
+            p.ranges.push_back({ std::max<std::int64_t>(first, NO_DAY + 1), last });
+        }
+        else if (p.column.kind == ColumnKind::ContractDays)
+        {
+            const std::int64_t first = r.min == OPEN_MIN ? NO_DAY + 1 : std::max<std::int64_t>(m_today + r.min, NO_DAY + 1);
+            const std::int64_t last = r.max == OPEN_MAX ? INT32_MAX : std::min<std::int64_t>(m_today + r.max, INT32_MAX);
+            if (first <= last) p.ranges.push_back({ first, last });
+        }
+        else
+        {
+            p.ranges.push_back(r);
+        }
+    }
+    return p;
+}
+
+QueryPlan QueryEngine::Plan(const ParsedQuery& query) const
+{
+    CM_TIME_SCOPE("cm_query_seconds", "type=\"query_plan\"");
+
+    QueryPlan plan;
+    plan.table = query.table;
+    plan.explain = query.explain;
+    plan.limit = query.limit;
+    plan.needsPlayer = query.table == QueryTable::Player;
+
+    for (const auto& condition : query.where)
+    {
+        plan.predicates.push_back(BindPredicate(query.table, condition));
+        plan.needsPlayer = plan.needsPlayer || uses_player(plan.predicates.back().column);
+    }
+
+    if (query.orderBy.has_value())
+    {
+        BoundColumn column = BindColumn(query.table, query.orderBy->field, query.orderBy->position);
+        if (column.kind == ColumnKind::Natural) throw QueryError("cannot order by natural", query.orderBy->position);
+
+        plan.needsPlayer = plan.needsPlayer || uses_player(column);
+        plan.orderBy = std::move(column);
+        plan.descending = query.orderBy->descending;
+    }
+
+    if (plan.table == QueryTable::Club)
+        plan.baseRows = static_cast<double>(m_db.Clubs().Size());
+    else if (plan.needsPlayer)
+        plan.baseRows = static_cast<double>(m_db.Joined().PlayerRows().size());
+    else
+        plan.baseRows = static_cast<double>(m_db.Staffs().Size());
+
+    for (const auto& p : plan.predicates) plan.predicateRows.push_back(EstimateRows(plan, p));
+
+    ChooseAccessPath(plan);
+    return plan;
+}
+
+double QueryEngine::EstimateRows(const QueryPlan& plan, const BoundPredicate& predicate) const
+{
+    if (predicate.ranges.empty()) return 0.0;
+
+    if (const auto source = index_source(m_db.Secondary(), predicate.column))
+    {
+        auto rows = static_cast<double>(probe_count(m_db.Secondary(), *source, predicate));
+
+        // A staff index also counts the staff without a player record.
+        if (plan.needsPlayer && !source->playerRowsOnly) rows *= player_fraction(m_db);
+        return std::min(rows, plan.baseRows);
+    }
+    return SampleFraction(plan, predicate) * plan.baseRows;
+}
+
+double QueryEngine::SampleFraction(const QueryPlan& plan, const BoundPredicate& predicate) const
+{
+    const QueryTable space = plan.needsPlayer ? QueryTable::Player : plan.table;
+    const std::string key = std::string(table_name(space)) + "." + predicate.column.name;
+
+    std::lock_guard lock(m_statisticsMutex);
+    auto it = m_samples.find(key);
+    if (it == m_samples.end())
+    {
+        // Every step-th row of the table, so the sample follows the table's own order.
+        const auto playerRows = m_db.Joined().PlayerRows();
+        const std::size_t rows = space == QueryTable::Player ? playerRows.size()
+                               : space == QueryTable::Club ? m_db.Clubs().Size() : m_db.Staffs().Size();
+        const std::size_t step = std::max<std::size_t>(1, rows / SAMPLE_ROWS);
+
+        ColumnSample sample;
+        for (std::size_t i = 0; i < rows; i += step)
+        {
+            const std::size_t row = space == QueryTable::Player ? playerRows[i].staffRow : i;
+            ++sample.rows;
+            if (const auto value = Key(predicate.column, Resolve(plan.table, row, plan.needsPlayer)))
+                sample.values.push_back(*value);
+        }
+        std::ranges::sort(sample.values);
+        it = m_samples.emplace(key, std::move(sample)).first;
+    }
+
+    const ColumnSample& sample = it->second;
+    if (sample.rows == 0) return 0.0;
+
+    std::size_t hits = 0;
+    for (const auto& r : predicate.ranges)
+        hits += static_cast<std::size_t>(std::ranges::upper_bound(sample.values, r.max) - std::ranges::lower_bound(sample.values, r.min));
+
+    // A value the sample missed may still occur: count it as half a sampled row.
+    return std::max(static_cast<double>(hits), 0.5) / static_cast<double>(sample.rows);
+}
+
+// One access path the planner considered.
+struct AccessCandidate {
+    AccessPath access;
+    std::string label;
+    std::vector<std::size_t> probes;
+    std::vector<std::size_t> dateFilters;
+    std::vector<std::size_t> residual;
+    double accessRows;
+    double cost;
+    std::optional<std::size_t> orderBound = std::nullopt;
+};
+
+void QueryEngine::ChooseAccessPath(QueryPlan& plan) const
+{
+    const auto& secondary = m_db.Secondary();
+    const double n = plan.baseRows;
+    const double staffRows = static_cast<double>(m_db.Staffs().Size());
+    const std::size_t count = plan.predicates.size();
+
+    // Estimates are over player rows when needsPlayer, but the staff indexes
+    // and the day columns hold every staff row; reaching a player column from
+    // a staff row costs a StaffJoin lookup.
+    const double playerShare = plan.needsPlayer ? std::max(player_fraction(m_db), 1e-9) : 1.0;
+    const double lookup = plan.needsPlayer ? COST_JOIN_LOOKUP : 0.0;
+
+    std::vector<double> selectivity(count);
+    std::vector<std::optional<IndexSource>> sources(count);
+    std::vector<double> indexRows(count, 0.0);
+    double matchFraction = 1.0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        selectivity[i] = n > 0 ? std::min(1.0, plan.predicateRows[i] / n) : 0.0;
+        matchFraction *= selectivity[i];
+        sources[i] = index_source(secondary, plan.predicates[i].column);
+        if (sources[i].has_value()) indexRows[i] = static_cast<double>(probe_count(secondary, *sources[i], plan.predicates[i]));
+    }
+    plan.matchRows = n * matchFraction;
+
+    const double matches = std::max(plan.matchRows, 0.5);
+    const double limit = plan.limit.has_value() ? static_cast<double>(*plan.limit) : matches;
+
+    // Without ORDER BY, a LIMIT ends the scan as soon as enough rows matched.
+    const double stopFraction = plan.limit.has_value() && !plan.orderBy.has_value() ? std::min(1.0, limit / matches) : 1.0;
+    const double sortCost = plan.orderBy.has_value()
+        ? plan.matchRows * std::log2(std::max(2.0, std::min(limit, plan.matchRows))) * COST_SORT_COMPARE : 0.0;
+
+    std::vector<std::size_t> all(count);
+    std::iota(all.begin(), all.end(), std::size_t{ 0 });
+    std::ranges::stable_sort(all, {}, [&](std::size_t i) { return selectivity[i]; });
+
+    auto without = [&](const std::vector<std::size_t>& taken) {
+        std::vector<std::size_t> rest;
+        for (auto i : all)
+            if (std::ranges::find(taken, i) == taken.end()) rest.push_back(i);
+        return rest;
+    };
+    auto fraction_of = [&](const std::vector<std::size_t>& list) {
+        double f = 1.0;
+        for (auto i : list) f *= selectivity[i];
+        return f;
+    };
+    // Row-by-row predicates short-circuit: each one only sees the rows the previous ones passed.
+    auto filter_cost = [&](double rows, const std::vector<std::size_t>& residual) {
+        double cost = 0.0;
+        for (auto i : residual)
+        {
+            cost += rows * COST_PREDICATE;
+            rows *= selectivity[i];
+        }
+        return cost;
+    };
+
+    std::vector<AccessCandidate> candidates;
+
+    if (plan.table == QueryTable::Club || !plan.needsPlayer)
+    {
+        const double visited = n * stopFraction;
+        candidates.push_back({ AccessPath::TableScan, "TableScan", {}, {}, all, visited,
+                               visited * COST_ROW + filter_cost(visited, all) + sortCost });
+    }
+    else
+    {
+        // The two join strategies: walk the pre-joined player rows, or every
+        // staff row with a StaffJoin lookup each.
+        const double visited = n * stopFraction;
+        candidates.push_back({ AccessPath::JoinRowScan, "JoinRowScan", {}, {}, all, visited,
+                               visited * COST_ROW + filter_cost(visited, all) + sortCost });
+
+        const double staffVisited = staffRows * stopFraction;
+        candidates.push_back({ AccessPath::TableScan, "TableScan + join lookup", {}, {}, all, staffVisited,
+                               staffVisited * (COST_ROW + lookup) + filter_cost(staffVisited * playerShare, all) + sortCost });
+    }
+
+    if (plan.table != QueryTable::Club)
+    {
+        std::vector<std::size_t> dates;
+        for (auto i : all)
+        {
+            const auto& p = plan.predicates[i];
+            if ((p.column.kind == ColumnKind::Age || p.column.kind == ColumnKind::ContractDays) && p.ranges.size() == 1)
+                dates.push_back(i);
+        }
+        if (!dates.empty())
+        {
+            const auto rest = without(dates);
+            const double dateRows = n * fraction_of(dates) / playerShare;
+            const double visited = dateRows * stopFraction;
+            candidates.push_back({ AccessPath::DateColumnScan, "DateColumnScan (" + count_of(dates.size(), "column") + ")", {}, dates, rest, dateRows,
+                                   staffRows * COST_DAY_COMPARE * static_cast<double>(dates.size())
+                                       + visited * (COST_RANDOM_ROW + lookup) + filter_cost(visited * playerShare, rest) + sortCost });
+        }
+    }
+
+    // Cost of the probes themselves, the rows the intersection keeps (in the
+    // table's rows) and the rows the bitmap holds (staff rows, players or not).
+    struct ProbeEstimate {
+        double cost;
+        double rows;
+        double bitmapRows;
+    };
+    auto estimate_probes = [&](const std::vector<std::size_t>& probes) {
+        ProbeEstimate e{ 0.0, n * fraction_of(probes), 0.0 };
+        double inputs = 0.0;
+        bool playerRowsOnly = false;
+        for (auto i : probes)
+        {
+            e.cost += probe_cost(*sources[i], plan.predicates[i], indexRows[i]);
+            inputs += indexRows[i];
+            playerRowsOnly = playerRowsOnly || sources[i]->playerRowsOnly;
+        }
+        if (probes.size() > 1) e.cost += inputs * COST_BITMAP_VALUE;
+        e.bitmapRows = plan.needsPlayer && !playerRowsOnly ? e.rows / playerShare : e.rows;
+        return e;
+    };
+    auto index_probe_cost = [&](const std::vector<std::size_t>& probes) {
+        const ProbeEstimate e = estimate_probes(probes);
+        const double visited = e.bitmapRows * stopFraction;
+        const double kept = e.bitmapRows > 0 ? e.rows / e.bitmapRows : 0.0;
+        return e.cost + visited * (COST_RANDOM_ROW + lookup) + filter_cost(visited * kept, without(probes)) + sortCost;
+    };
+
+    // Greedy probe choice, most selective first: a probe joins the intersection
+    // while the rows it saves outweigh building and intersecting its bitmap.
+    std::vector<std::size_t> probes;
+    double probeCost = std::numeric_limits<double>::infinity();
+    for (auto i : all)
+    {
+        if (!sources[i].has_value()) continue;
+
+        auto trial = probes;
+        trial.push_back(i);
+        const double cost = index_probe_cost(trial);
+        if (cost < probeCost)
+        {
+            probes = std::move(trial);
+            probeCost = cost;
+        }
+    }
+    if (!probes.empty())
+        candidates.push_back({ AccessPath::IndexProbe, "IndexProbe (" + count_of(probes.size(), "probe") + ")", probes, {}, without(probes),
+                               estimate_probes(probes).bitmapRows, probeCost });
+
+    // ORDER BY on a range-indexed column with a LIMIT: walk the index in order
+    // and stop at LIMIT matches, no sort. A range predicate on the ORDER BY
+    // column itself bounds the walk instead of being checked per row; the other
+    // matches are assumed spread evenly along the index, so the walk covers
+    // limit / matches of it.
+    const auto orderSource = plan.orderBy.has_value() ? index_source(secondary, *plan.orderBy) : std::nullopt;
+    if (plan.limit.has_value() && orderSource.has_value() && orderSource->range != nullptr)
+    {
+        std::optional<std::size_t> bound;
+        for (auto i : all)
+        {
+            const BoundColumn& column = plan.predicates[i].column;
+            if (column.kind == plan.orderBy->kind && column.name == plan.orderBy->name && plan.predicates[i].ranges.size() == 1)
+            {
+                bound = i;
+                break;
+            }
+        }
+
+        const double entries = bound.has_value() ? indexRows[*bound] : static_cast<double>(orderSource->range->Size());
+        const double walked = entries * std::min(1.0, limit / matches);
+        const double kept = plan.needsPlayer && !orderSource->playerRowsOnly ? playerShare : 1.0;
+
+        auto ordered = [&](std::vector<std::size_t> filters, std::string label) {
+            if (bound.has_value()) std::erase(filters, *bound);
+
+            double cost = COST_INDEX_SEARCH;
+            double pass = 1.0;
+            if (!filters.empty())
+            {
+                cost += estimate_probes(filters).cost + walked * COST_MEMBERSHIP;
+                pass = fraction_of(filters);
+                label += " + " + count_of(filters.size(), "probe");
+            }
+            auto taken = filters;
+            if (bound.has_value()) taken.push_back(*bound);
+
+            const double fetched = walked * pass;
+            cost += fetched * (COST_RANDOM_ROW + lookup) + filter_cost(fetched * kept, without(taken));
+            return AccessCandidate{ AccessPath::OrderedIndexScan, std::move(label), filters, {}, without(taken), walked, cost, bound };
+        };
+
+        const std::string label = "OrderedIndexScan " + plan.orderBy->name + (bound.has_value() ? " (bounded)" : "");
+        candidates.push_back(ordered({}, label));
+        if (!probes.empty() && (probes.size() > 1 || probes.front() != bound)) candidates.push_back(ordered(probes, label));
+    }
+
+    std::ranges::stable_sort(candidates, {}, &AccessCandidate::cost);
+    for (const auto& c : candidates) plan.alternatives.emplace_back(c.label, c.cost);
+
+    AccessCandidate& best = candidates.front();
+    plan.access = best.access;
+    plan.probes = std::move(best.probes);
+    plan.dateFilters = std::move(best.dateFilters);
+    plan.residual = std::move(best.residual);
+    plan.orderBound = best.orderBound;
+    plan.accessRows = best.accessRows;
+    plan.cost = best.cost;
+}
+
+QueryEngine::RowRecords QueryEngine::Resolve(QueryTable table, std::size_t row, bool withPlayer) const
+{
+    RowRecords records{ row };
+    if (table == QueryTable::Club)
+    {
+        records.club = &m_db.Clubs().Records()[row];
+        return records;
+    }
+
+    records.staff = &m_db.Staffs().Records()[row];
+    if (withPlayer)
+        if (const auto playerRow = m_db.Joined().PlayerOf(row))
+            records.player = &m_db.Players().Records()[*playerRow];
+    return records;
+}
+
+std::optional<std::int64_t> QueryEngine::Key(const BoundColumn& column, const RowRecords& records) const
+{
+    switch (column.kind)
+    {
+    case ColumnKind::StaffField:
+        return field_value(*records.staff, *column.field);
+    case ColumnKind::PlayerField:
+        if (records.player == nullptr) return std::nullopt;
+        return field_value(*records.player, *column.field);
+    case ColumnKind::ClubField:
+        return field_value(*records.club, *column.field);
+    case ColumnKind::Age:
+    case ColumnKind::ContractDays:
+    {
+        const std::int32_t day = m_db.StaffDates().Column(date_of(column.kind))[records.row];
+        if (day == NO_DAY) return std::nullopt;
+        return day;
+    }
+    case ColumnKind::Natural:
+        break;
+    }
+    return std::nullopt;
+}
+
+bool QueryEngine::Matches(const BoundPredicate& predicate, const RowRecords& records) const
+{
+    if (predicate.column.kind == ColumnKind::Natural)
+    {
+        if (records.player == nullptr) return false;
+
+        for (const auto& r : predicate.ranges)
+        {
+            const auto [first, last] = position_span(r);
+            for (std::size_t pos = first; pos < last; ++pos)
+                if (attribute_value(*records.player, static_cast<PlayerAttribute>(pos)) >= NATURAL_POSITION_RATING) return true;
+        }
+        return false;
+    }
+
+    const auto key = Key(predicate.column, records);
+    if (!key.has_value()) return false;
+
+    return std::ranges::any_of(predicate.ranges, [v = *key](const ValueRange& r) { return v >= r.min && v <= r.max; });
+}
+
+QueryResult QueryEngine::Execute(const QueryPlan& plan) const
+{
+    CM_TIME_SCOPE("cm_query_seconds", "type=\"query_language\"");
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto& secondary = m_db.Secondary();
+    const auto staffs = m_db.Staffs().Records();
+    const auto players = m_db.Players().Records();
+
+    // Rows leave an ordered index walk or an unsorted scan in final order, so LIMIT can stop them early.
+    const bool sorted = plan.orderBy.has_value() && plan.access != AccessPath::OrderedIndexScan;
+    const bool stopEarly = plan.limit.has_value() && !sorted;
+
+    QueryResult result;
+    for (const auto& p : plan.predicates)
+        if (p.column.kind != ColumnKind::Natural && std::ranges::none_of(result.columns, [&](const BoundColumn& c) { return c.name == p.column.name; }))
+            result.columns.push_back(p.column);
+    if (plan.orderBy.has_value() && std::ranges::none_of(result.columns, [&](const BoundColumn& c) { return c.name == plan.orderBy->name; }))
+        result.columns.push_back(*plan.orderBy);
+
+    std::vector<std::uint32_t> matches;
+    std::size_t produced = 0;
+    bool done = stopEarly && *plan.limit == 0;
+
+    // Every row the access path produces; sets `done` once LIMIT rows matched.
+    auto offer = [&](const RowRecords& records) {
+        ++produced;
+        if (plan.needsPlayer && records.player == nullptr) return;
+        for (auto i : plan.residual)
+            if (!Matches(plan.predicates[i], records)) return;
+
+        matches.push_back(static_cast<std::uint32_t>(records.row));
+        done = stopEarly && matches.size() >= *plan.limit;
+    };
+    auto offer_row = [&](std::size_t row) { offer(Resolve(plan.table, row, plan.needsPlayer)); };
+
+    const std::string table(table_name(plan.table));
+    const std::string join = plan.needsPlayer ? " + StaffJoin lookup" : "";
+    PlanNode access{ std::string(access_path_name(plan.access)), plan.accessRows, 0, -1, {} };
+
+    // Index probes, for IndexProbe and as the filter of an OrderedIndexScan.
+    std::deque<RoaringBitmap> probed;
+    std::optional<RoaringBitmap> candidates;
+    PlanNode probeNode{ "BitmapAnd", 0, 0, -1, {} };
+    if (!plan.probes.empty())
+    {
+        std::vector<const RoaringBitmap*> parts;
+        for (auto i : plan.probes)
+        {
+            const auto probeStart = std::chrono::steady_clock::now();
+            const BoundPredicate& p = plan.predicates[i];
+            const IndexSource source = *index_source(secondary, p.column);
+            parts.push_back(&probed.emplace_back(probe_bitmap(secondary, source, p)));
+
+            // Exact index counts: the estimate is the count the probe returns.
+            const double estimate = plan.needsPlayer && !source.playerRowsOnly ? plan.predicateRows[i] / std::max(player_fraction(m_db), 1e-9) : plan.predicateRows[i];
+            probeNode.children.push_back({ std::string(source.range != nullptr ? "RangeProbe " : "BitmapProbe ") + p.text + " [" + std::string(source.name) + "]",
+                                           estimate, parts.back()->Cardinality(), elapsed_ms(probeStart), {} });
+        }
+
+        const auto andStart = std::chrono::steady_clock::now();
+        candidates = parts.size() == 1 ? *parts.front() : RoaringBitmap::intersect(parts);
+        probeNode.milliseconds = elapsed_ms(andStart);
+        probeNode.actualRows = candidates->Cardinality();
+    }
+
+    const auto scanStart = std::chrono::steady_clock::now();
+    switch (plan.access)
+    {
+    case AccessPath::TableScan:
+    {
+        const std::size_t rows = plan.table == QueryTable::Club ? m_db.Clubs().Size() : staffs.size();
+        for (std::size_t row = 0; row < rows && !done; ++row) offer_row(row);
+        access.label = "TableScan " + table + join;
+        access.actualRows = produced;
+        break;
+    }
+    case AccessPath::JoinRowScan:
+        for (const auto& joined : m_db.Joined().PlayerRows())
+        {
+            if (done) break;
+            offer({ joined.staffRow, &staffs[joined.staffRow], &players[joined.playerRow] });
+        }
+        access.label = "JoinRowScan StaffJoin::PlayerRows (pre-joined)";
+        access.actualRows = produced;
+        break;
+    case AccessPath::DateColumnScan:
+    {
+        std::vector<DateRange> ranges;
+        access.label = "DateColumnScan";
+        for (auto i : plan.dateFilters)
+        {
+            const BoundPredicate& p = plan.predicates[i];
+            ranges.push_back({ date_of(p.column.kind), static_cast<std::int32_t>(p.ranges.front().min), static_cast<std::int32_t>(p.ranges.front().max) });
+            access.label += (i == plan.dateFilters.front() ? " " : " AND ") + p.text;
+        }
+        access.label += join;
+
+        const SelectionBitmap selection = m_db.StaffDates().Filter(ranges);
+        access.actualRows = selection.Count();
+        const auto& words = selection.Words();
+        for (std::size_t w = 0; w < words.size() && !done; ++w)
+            for (auto bits = words[w]; bits != 0 && !done; bits &= bits - 1)
+                offer_row(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+        break;
+    }
+    case AccessPath::IndexProbe:
+        candidates->ForEach([&](std::uint32_t row) {
+            if (!done) offer_row(row);
+        });
+        access = std::move(probeNode);
+        access.label = (plan.probes.size() > 1 ? "IndexProbe: AND of " + std::to_string(plan.probes.size()) : "IndexProbe") + join;
+        access.estimatedRows = plan.accessRows;
+        break;
+    case AccessPath::OrderedIndexScan:
+    {
+        const RangeIndex& index = *index_source(secondary, *plan.orderBy)->range;
+        const auto keys = index.Keys();
+        const auto rows = index.Rows();
+
+        // Staff without the date sit at the front of a day index as NO_DAY; they go last either way.
+        const bool dated = plan.orderBy->kind == ColumnKind::Age || plan.orderBy->kind == ColumnKind::ContractDays;
+        std::size_t first = dated ? index.LowerBound(NO_DAY + 1) : 0;
+        std::size_t last = keys.size();
+        std::size_t undated = first;
+        if (plan.orderBound.has_value())
+        {
+            // The bound never matches NO_DAY, so the walk is the slice it selects.
+            const auto range = key_range(plan.predicates[*plan.orderBound].ranges.front());
+            first = range.has_value() ? index.LowerBound(range->min) : 0;
+            last = range.has_value() ? index.UpperBound(range->max) : 0;
+            undated = 0;
+        }
+
+        // Birth days run opposite to ages.
+        const bool ascending = plan.descending == (plan.orderBy->kind == ColumnKind::Age);
+
+        std::size_t walked = 0;
+        auto visit = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end && !done; ++i)
+            {
+                ++walked;
+                if (!candidates.has_value() || candidates->Contains(rows[i])) offer_row(rows[i]);
+            }
+        };
+
+        if (ascending)
+        {
+            visit(first, last);
+        }
+        else
+        {
+            // Backwards one run of equal keys at a time, each run in ascending
+            // row order, so ties come out as the sorting path breaks them.
+            for (std::size_t end = last; end > first && !done;)
+            {
+                const std::size_t begin = std::max(first, index.LowerBound(keys[end - 1]));
+                visit(begin, end);
+                end = begin;
+            }
+        }
+        visit(0, undated);
+
+        access.label = "OrderedIndexScan " + plan.orderBy->name + (plan.descending ? " DESC" : " ASC") + join;
+        if (plan.orderBound.has_value()) access.label += " WHERE " + plan.predicates[*plan.orderBound].text;
+        access.actualRows = walked;
+        if (candidates.has_value())
+        {
+            probeNode.label = "BitmapAnd (row filter)";
+            probeNode.estimatedRows = plan.matchRows;
+            access.children.push_back(std::move(probeNode));
+        }
+        break;
+    }
+    }
+    access.milliseconds = elapsed_ms(scanStart);
+
+    PlanNode root = std::move(access);
+    const double matchEstimate = stopEarly ? std::min(plan.matchRows, static_cast<double>(*plan.limit)) : plan.matchRows;
+    // Rows that may lack a player record are dropped by the filter; the player
+    // row scan and the player-only indexes never produce them.
+    bool playersOnly = plan.access == AccessPath::JoinRowScan
+                    || (plan.access == AccessPath::OrderedIndexScan && index_source(secondary, *plan.orderBy)->playerRowsOnly);
+    for (auto i : plan.probes) playersOnly = playersOnly || index_source(secondary, plan.predicates[i].column)->playerRowsOnly;
+    const bool checksPlayer = plan.needsPlayer && !playersOnly;
+
+    if (!plan.residual.empty() || checksPlayer)
+    {
+        std::string label = "Filter";
+        for (auto i : plan.residual) label += (i == plan.residual.front() ? " " : " AND ") + plan.predicates[i].text;
+        if (checksPlayer) label += plan.residual.empty() ? " has player record" : " AND has player record";
+        root = PlanNode{ label, matchEstimate, matches.size(), -1, { std::move(root) } };
+    }
+
+    if (sorted)
+    {
+        const auto sortStart = std::chrono::steady_clock::now();
+        const std::size_t k = plan.limit.has_value() ? std::min(*plan.limit, matches.size()) : matches.size();
+
+        // Higher score first, ties by ascending row; rows without a value last.
+        TopKHeap heap(k);
+        for (auto row : matches)
+        {
+            double score = -std::numeric_limits<double>::infinity();
+            if (const auto key = Key(*plan.orderBy, Resolve(plan.table, row, plan.needsPlayer)))
+            {
+                const double v = plan.orderBy->kind == ColumnKind::Age ? -static_cast<double>(*key) : static_cast<double>(*key);
+                score = plan.descending ? v : -v;
+            }
+            heap.Push({ row, score });
+        }
+        for (const auto& ranked : std::move(heap).Sorted()) result.rows.push_back(static_cast<std::uint32_t>(ranked.row));
+
+        const std::string order = " by " + plan.orderBy->name + (plan.descending ? " DESC" : " ASC");
+        const std::string label = plan.limit.has_value() ? "TopK " + std::to_string(*plan.limit) + order : "Sort" + order;
+        const double estimate = plan.limit.has_value() ? std::min(plan.matchRows, static_cast<double>(*plan.limit)) : plan.matchRows;
+        root = PlanNode{ label, estimate, result.rows.size(), elapsed_ms(sortStart), { std::move(root) } };
+    }
+    else
+    {
+        result.rows = std::move(matches);
+        if (plan.limit.has_value())
+            root = PlanNode{ "Limit " + std::to_string(*plan.limit), matchEstimate, result.rows.size(), -1, { std::move(root) } };
+    }
+
+    result.plan = std::move(root);
+    result.milliseconds = elapsed_ms(start);
+    return result;
+}
+
+std::optional<std::int64_t> QueryEngine::Value(const BoundColumn& column, QueryTable table, std::size_t row) const
+{
+    switch (column.kind)
+    {
+    case ColumnKind::Age:
+    {
+        const CMDate birth = m_db.Staffs().Records()[row].DateOfBirth;
+        if (birth.Year == 0) return std::nullopt;
+        return age_on(birth, m_options.today);
+    }
+    case ColumnKind::ContractDays:
+    {
+        const std::int32_t day = m_db.StaffDates().Column(StaffDate::ExpiresClub)[row];
+        if (day == NO_DAY) return std::nullopt;
+        return std::int64_t{ day } - m_today;
+    }
+    case ColumnKind::Natural:
+        return std::nullopt;
+    default:
+        return Key(column, Resolve(table, row, uses_player(column)));
+    }
+}
+
+std::string_view QueryEngine::RowName(QueryTable table, std::size_t row) const
+{
+    if (table == QueryTable::Club) return field_text(m_db.Clubs().Records()[row], schema_field<Club>("short_name"));
+    return m_db.StaffNames().GetByRow(row);
+}
+
+static void write_node(std::ostream& os, const PlanNode& node, std::size_t depth)
+{
+    os << std::left << std::setw(72) << std::string(2 * depth, ' ') + node.label << std::right
+       << " est " << std::setw(9) << std::llround(node.estimatedRows)
+       << "  actual " << std::setw(9) << node.actualRows;
+    if (node.milliseconds >= 0) os << "  " << std::fixed << std::setprecision(3) << node.milliseconds << " ms";
+    os << "\n";
+
+    for (const auto& child : node.children) write_node(os, child, depth + 1);
+}
+
+void write_explain(std::ostream& os, const QueryPlan& plan, const QueryResult& result)
+{
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+
+    os << "Plan for " << table_name(plan.table) << " (" << std::llround(plan.baseRows) << (plan.needsPlayer ? " player" : "")
+       << " rows): " << access_path_name(plan.access) << ", estimated cost " << std::llround(plan.cost)
+       << ", " << result.rows.size() << " rows in " << std::fixed << std::setprecision(3) << result.milliseconds << " ms\n";
+    write_node(os, result.plan, 1);
+
+    os << "Access paths considered (estimated cost):\n";
+    for (const auto& [label, cost] : plan.alternatives)
+        os << "  " << std::left << std::setw(48) << label << std::right << std::setw(12) << std::llround(cost) << "\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#include "range_index.h"
+#include "snapshot_io.h"
+
+RangeIndex::RangeIndex(std::vector<std::pair<std::int32_t, std::uint32_t>> entries)
+{
+    std::ranges::sort(entries);
+
+    m_keys.reserve(entries.size());
+    m_rows.reserve(entries.size());
+    for (const auto& [key, row] : entries)
+    {
+        m_keys.push_back(key);
+        m_rows.push_back(row);
+    }
+    BuildEytzinger();
+}
+
+std::size_t RangeIndex::LowerBound(std::int32_t key) const
+{
+    const std::size_t n = m_keys.size();
+    const std::int32_t* tree = m_eytzinger.data();
+
+    // Branch-free descent: k goes to 2k when tree[k] >= key, 2k + 1 otherwise.
+    // The 16 descendants four levels down share one cache line, so fetch it now.
+    std::size_t k = 1;
+    while (k <= n)
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(tree + std::min(16 * k, n));
+#endif
+        k = 2 * k + static_cast<std::size_t>(tree[k] < key);
+    }
+
+    // Undo the right turns taken after the last left turn: that node is the answer.
+    k >>= std::countr_one(k) + 1;
+    return k == 0 ? n : m_rank[k];
+}
+
+std::span<const std::uint32_t> RangeIndex::Between(IntRange range) const
+{
+    if (range.min > range.max) return {};
+
+    const std::size_t begin = LowerBound(range.min);
+    const std::size_t end = UpperBound(range.max);
+    return std::span<const std::uint32_t>(m_rows).subspan(begin, end - begin);
+}
+
+RoaringBitmap RangeIndex::BitmapBetween(IntRange range) const
+{
+    const auto rows = Between(range);
+
+    // Rows come in key order: sort a short slice, scatter a long one into a flat bitmap.
+    if (rows.size() < 1024)
+    {
+        std::vector<std::uint32_t> sorted(rows.begin(), rows.end());
+        std::ranges::sort(sorted);
+        return RoaringBitmap::FromSorted(sorted);
+    }
+
+    SelectionBitmap selection(std::size_t{ *std::ranges::max_element(rows) } + 1);
+    for (auto row : rows) selection.Set(row);
+    return RoaringBitmap::FromSelection(selection);
+}
+
+void RangeIndex::Save(SnapshotWriter& out) const
+{
+    out.Write(m_keys);
+    out.Write(m_rows);
+}
+
+RangeIndex RangeIndex::Load(SnapshotReader& in)
+{
+    RangeIndex index;
+    index.m_keys = in.ReadVector<std::int32_t>();
+    index.m_rows = in.ReadVector<std::uint32_t>();
+    if (index.m_keys.size() != index.m_rows.size() || !std::ranges::is_sorted(index.m_keys))
+        throw std::runtime_error("Snapshot range index is corrupt.");
+
+    // Derived from the keys in one linear pass, so not worth storing.
+    index.BuildEytzinger();
+    return index;
+}
+
+void RangeIndex::BuildEytzinger()
+{
+    m_eytzinger.assign(m_keys.size() + 1, 0);
+    m_rank.assign(m_keys.size() + 1, 0);
+    FillEytzinger(0, 1);
+}
+
+// In-order walk of the implicit tree rooted at k, handing out sorted keys from position i.
+std::size_t RangeIndex::FillEytzinger(std::size_t i, std::size_t k)
+{
+    if (k > m_keys.size()) return i;
+
+    i = FillEytzinger(i, 2 * k);
+    m_eytzinger[k] = m_keys[i];
+    m_rank[k] = static_cast<std::uint32_t>(i);
+    return FillEytzinger(i + 1, 2 * k + 1);
+}
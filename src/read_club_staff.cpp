@@ -11,7 +11,7 @@
 //  3) TStaff layout is correct per the C# model: size 0x6E (110). Player at 0x61, NonPlayer at 0x69.
 //
 // Build:
-//   clang++ -std=c++23 -O2 -Wall -Wextra cm_tool.cpp -o cm_tool
+//   clang++ -std=c++23 -O2 -Wall -Wextra -Iinclude src/read_club_staff.cpp -o cm_tool
 //
 // Run:
 //   ./cm_tool Input/Data --club-find ajax
@@ -33,22 +33,25 @@
 #include <cctype>
 #include <stdexcept>
 
+#include "schema.h"
+
 namespace fs = std::filesystem;
 
 // ======================================================
 // TStaff (from provided C# Pack=1):
-// Total size = 0x6E (110)
+// Offsets come from RecordSchema<Staff> in schema.h, which checks them
+// against staff.h at compile time (size 0x6E, Player 0x61, NonPlayer 0x69).
 // ======================================================
-static constexpr size_t STAFF_REC_SIZE        = 0x6E; // 110 bytes
-static constexpr size_t OFF_STAFF_ID          = 0x00;
-static constexpr size_t OFF_STAFF_FIRSTNAME   = 0x04;
-static constexpr size_t OFF_STAFF_SECONDNAME  = 0x08;
-static constexpr size_t OFF_STAFF_COMMONNAME  = 0x0C;
+static constexpr size_t STAFF_REC_SIZE        = sizeof(Staff);
+static constexpr size_t OFF_STAFF_ID          = schema_field<Staff>("id").offset;
+static constexpr size_t OFF_STAFF_FIRSTNAME   = schema_field<Staff>("FirstName").offset;
+static constexpr size_t OFF_STAFF_SECONDNAME  = schema_field<Staff>("SecondName").offset;
+static constexpr size_t OFF_STAFF_COMMONNAME  = schema_field<Staff>("CommonName").offset;
 
 // Not actually pointers; these are IDs into player/nonplayer blocks.
-static constexpr size_t OFF_STAFF_PLAYER_ID   = 0x61;
-static constexpr size_t OFF_STAFF_PREFS_ID    = 0x65;
-static constexpr size_t OFF_STAFF_NONPLAYER_ID= 0x69;
+static constexpr size_t OFF_STAFF_PLAYER_ID   = schema_field<Staff>("Player").offset;
+static constexpr size_t OFF_STAFF_PREFS_ID    = schema_field<Staff>("StaffPreferences").offset;
+static constexpr size_t OFF_STAFF_NONPLAYER_ID= schema_field<Staff>("NonPlayer").offset;
 
 // ======================================================
 // Helpers
@@ -125,17 +128,7 @@ static void hex_dump(const std::vector<std::uint8_t>& v, size_t off, size_t len,
     std::cout.copyfmt(oldState);
 }
 
-static std::string fixed_cstr_to_string(const char* buf, size_t n) {
-    size_t len = 0;
-    while (len < n && buf[len] != '\0') ++len;
-    return std::string(buf, buf + len);
-}
-
-static int count_non_minus_one(const int32_t* arr, size_t n) {
-    int c = 0;
-    for (size_t i = 0; i < n; ++i) if (arr[i] != -1) ++c;
-    return c;
-}
+// fixed_cstr_to_string / count_non_minus_one come from club.h.
 
 static std::string pro_status_to_string(uint8_t v) {
     switch (v) { case 1: return "pro"; case 2: return "semi"; case 3: return "amtr"; default: return "unk"; }
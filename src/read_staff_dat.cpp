@@ -12,6 +12,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "schema.h"
+
 namespace fs = std::filesystem;
 
 // ---------------------------
@@ -120,7 +122,7 @@ load_names_map(const fs::path& namesFile) {
 // The only universally-safe thing: index.dat tells offset + count for each sub-block. :contentReference[oaicite:4]{index=4}
 //
 // Layout problem: We still need the *record sizes* for TStaff and TPlayer.
-// We'll implement reading as "fixed-size records" once you set STAFF_REC_SIZE / PLAYER_REC_SIZE.
+// Records are read as fixed-size rows of STAFF_REC_SIZE / PLAYER_REC_SIZE bytes.
 // ---------------------------
 struct StaffLite {
     std::int32_t id{-1};
@@ -143,23 +145,20 @@ static void hex_dump_line(const std::vector<std::uint8_t>& v, size_t off, size_t
     std::cout << std::dec << "\n";
 }
 
-// ---- IMPORTANT: adjust these once you confirm C# struct sizes ----
-// If you already have the CM.Save.Model structs, set these to Marshal.SizeOf(TStaff/TPlayer).
-static constexpr size_t STAFF_REC_SIZE  = 110; // common guess; verify!
-static constexpr size_t PLAYER_REC_SIZE =  80; // placeholder; verify!
-
-// Field offsets inside TStaff record (bytes).
-// These are ALSO placeholders. You should update them from your C# struct layout.
-static constexpr size_t OFF_STAFF_ID         = 0;
-static constexpr size_t OFF_STAFF_FIRSTNAME  = 4;
-static constexpr size_t OFF_STAFF_SECONDNAME = 8;
-static constexpr size_t OFF_STAFF_COMMONNAME = 12;
-
-// Pointers (player/nonplayer/prefs) — placeholders.
-// In your C# model: staff.NonPlayer, staff.Player, staff.StaffPreferences
-static constexpr size_t OFF_STAFF_NONPLAYER_PTR = 106;
-static constexpr size_t OFF_STAFF_PLAYER_PTR    = 98;
-static constexpr size_t OFF_STAFF_PREF_PTR      = 64;
+// Record sizes and TStaff field offsets come from schema.h, which checks
+// them against the packed structs (and the C# model) at compile time.
+static constexpr size_t STAFF_REC_SIZE  = sizeof(Staff);
+static constexpr size_t PLAYER_REC_SIZE = sizeof(Player);
+
+static constexpr size_t OFF_STAFF_ID         = schema_field<Staff>("id").offset;
+static constexpr size_t OFF_STAFF_FIRSTNAME  = schema_field<Staff>("FirstName").offset;
+static constexpr size_t OFF_STAFF_SECONDNAME = schema_field<Staff>("SecondName").offset;
+static constexpr size_t OFF_STAFF_COMMONNAME = schema_field<Staff>("CommonName").offset;
+
+// staff.NonPlayer, staff.Player, staff.StaffPreferences in the C# model.
+static constexpr size_t OFF_STAFF_NONPLAYER_PTR = schema_field<Staff>("NonPlayer").offset;
+static constexpr size_t OFF_STAFF_PLAYER_PTR    = schema_field<Staff>("Player").offset;
+static constexpr size_t OFF_STAFF_PREF_PTR      = schema_field<Staff>("StaffPreferences").offset;
 
 static std::vector<StaffLite> load_staff_block(
     const std::vector<std::uint8_t>& staffDat,
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <utility>
+
+#include "reference_index.h"
+
+// Nation and division ids are small in real data; a corrupt one above this is
+// dropped rather than sizing the offset array from it.
+static constexpr std::int64_t MAX_GROUP_ID = 65535;
+
+template <typename Target>
+static CsrIndex<Target> build_csr(const std::vector<std::pair<std::int64_t, Target>>& edges)
+{
+    std::int64_t maxKey = -1;
+    for (const auto& edge : edges)
+        if (edge.first <= MAX_GROUP_ID) maxKey = std::max(maxKey, edge.first);
+
+    return CsrIndex<Target>(static_cast<std::size_t>(maxKey + 1), edges);
+}
+
+ReferenceIndex::ReferenceIndex(std::span<const Club> clubs, std::span<const Staff> staffs)
+{
+    m_clubIds = IdIndex::Build(clubs, [](const Club& club){ return club.id; });
+    m_staffIds = IdIndex::Build(staffs, [](const Staff& staff){ return staff.id; });
+
+    std::vector<std::pair<std::int64_t, ClubMembership>> staffEdges;
+    std::vector<std::pair<std::int64_t, std::uint32_t>> nationEdges;
+    std::vector<std::pair<std::int64_t, std::uint32_t>> divisionEdges;
+    nationEdges.reserve(clubs.size());
+    divisionEdges.reserve(clubs.size());
+
+    for (std::size_t i = 0; i < clubs.size(); ++i)
+    {
+        const Club& club = clubs[i];
+        const auto row = static_cast<std::uint32_t>(i);
+
+        auto add = [&](std::int32_t staffId, ClubRole role) {
+            if (staffId < 0) return;
+
+            auto staffRow = m_staffIds.Find(staffId);
+            if (staffRow.has_value()) staffEdges.emplace_back(static_cast<std::int64_t>(*staffRow), ClubMembership{ row, role });
+        };
+        auto addAll = [&](const auto& ids, ClubRole role) {
+            for (std::int32_t staffId : ids) add(staffId, role);
+        };
+
+        add(club.chairman_staff_id, ClubRole::Chairman);
+        addAll(club.directors, ClubRole::Director);
+        add(club.manager_staff_id, ClubRole::Manager);
+        add(club.assistant_manager_staff_id, ClubRole::AssistantManager);
+        addAll(club.playing_squad, ClubRole::Player);
+        addAll(club.coaches, ClubRole::Coach);
+        addAll(club.scouts, ClubRole::Scout);
+        addAll(club.physios, ClubRole::Physio);
+
+        nationEdges.emplace_back(club.nation_id, row);
+        divisionEdges.emplace_back(club.division_id, row);
+    }
+
+    std::vector<std::pair<std::int64_t, std::uint32_t>> jobEdges;
+    std::vector<std::pair<std::int64_t, std::uint32_t>> staffNationEdges;
+    staffNationEdges.reserve(staffs.size());
+    for (std::size_t i = 0; i < staffs.size(); ++i)
+    {
+        const Staff& staff = staffs[i];
+        const auto row = static_cast<std::uint32_t>(i);
+
+        auto clubRow = m_clubIds.Find(staff.ClubJob);
+        if (clubRow.has_value()) jobEdges.emplace_back(static_cast<std::int64_t>(*clubRow), row);
+
+        if (staff.Nation >= 0) staffNationEdges.emplace_back(staff.Nation, row);
+        if (staff.SecondNation >= 0 && staff.SecondNation != staff.Nation) staffNationEdges.emplace_back(staff.SecondNation, row);
+    }
+
+    m_staffToClub = CsrIndex<ClubMembership>(staffs.size(), staffEdges);
+    m_nationToClub = build_csr(nationEdges);
+    m_divisionToClub = build_csr(divisionEdges);
+    m_clubToStaff = CsrIndex<std::uint32_t>(clubs.size(), jobEdges);
+    m_nationToStaff = build_csr(staffNationEdges);
+}
+
+std::vector<std::uint32_t> ReferenceIndex::StaffOfNationClubs(std::int32_t nationId) const
+{
+    std::vector<std::uint32_t> res;
+    for (auto clubRow : ClubsOfNation(nationId))
+    {
+        auto staffRows = m_clubToStaff.Get(clubRow);
+        res.insert(res.end(), staffRows.begin(), staffRows.end());
+    }
+    return res;
+}
+
+void ReferenceIndex::Save(SnapshotWriter& out) const
+{
+    m_clubIds.Save(out);
+    m_staffIds.Save(out);
+    m_staffToClub.Save(out);
+    m_nationToClub.Save(out);
+    m_divisionToClub.Save(out);
+    m_clubToStaff.Save(out);
+    m_nationToStaff.Save(out);
+}
+
+ReferenceIndex ReferenceIndex::Load(SnapshotReader& in)
+{
+    ReferenceIndex index;
+    index.m_clubIds = IdIndex::Load(in);
+    index.m_staffIds = IdIndex::Load(in);
+    index.m_staffToClub = CsrIndex<ClubMembership>::Load(in);
+    index.m_nationToClub = CsrIndex<std::uint32_t>::Load(in);
+    index.m_divisionToClub = CsrIndex<std::uint32_t>::Load(in);
+    index.m_clubToStaff = CsrIndex<std::uint32_t>::Load(in);
+    index.m_nationToStaff = CsrIndex<std::uint32_t>::Load(in);
+    return index;
+}
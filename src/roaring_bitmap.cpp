@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "roaring_bitmap.h"
+#include "snapshot_io.h"
+
+static bool test_bit(std::span<const std::uint64_t> words, std::uint16_t low)
+{
+    return (words[low / 64] >> (low % 64)) & 1u;
+}
+
+static void set_bit(std::uint64_t* words, std::uint16_t low)
+{
+    words[low / 64] |= std::uint64_t{1} << (low % 64);
+}
+
+// Sorted-array intersection: a linear merge for similar sizes, a binary
+// search of the larger array per value of the smaller one otherwise.
+static void intersect_arrays(std::span<const std::uint16_t> a, std::span<const std::uint16_t> b, std::vector<std::uint16_t>& out)
+{
+    if (a.size() > b.size()) std::swap(a, b);
+
+    if (a.size() * 32 < b.size())
+    {
+        auto it = b.begin();
+        for (auto v : a)
+        {
+            it = std::lower_bound(it, b.end(), v);
+            if (it == b.end()) return;
+            if (*it == v) out.push_back(v);
+        }
+        return;
+    }
+
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+}
+
+RoaringBitmap RoaringBitmap::Range(std::uint32_t begin, std::uint32_t end)
+{
+    RoaringBitmap res;
+    for (std::uint64_t v = begin; v < end; )
+    {
+        const auto key = static_cast<std::uint16_t>(v >> 16);
+        const std::uint64_t last = std::min<std::uint64_t>(end, (std::uint64_t{ key } + 1) << 16);
+        const auto lo = static_cast<std::uint32_t>(v & 0xFFFF);
+        const auto hi = static_cast<std::uint32_t>(last - (std::uint64_t{ key } << 16));    // exclusive, up to 65536
+
+        if (hi - lo <= ARRAY_MAX)
+        {
+            const std::size_t first = res.m_values.size();
+            for (std::uint32_t low = lo; low < hi; ++low) res.m_values.push_back(static_cast<std::uint16_t>(low));
+            res.FinishArray(key, first);
+        }
+        else
+        {
+            const std::size_t first = res.m_words.size();
+            res.m_words.resize(first + BITMAP_WORDS, 0);
+            for (std::uint32_t low = lo; low < hi; ++low) set_bit(res.m_words.data() + first, static_cast<std::uint16_t>(low));
+            res.FinishBitmap(key, first);
+        }
+        v = last;
+    }
+    return res;
+}
+
+RoaringBitmap RoaringBitmap::FromSorted(std::span<const std::uint32_t> values)
+{
+    RoaringBitmap res;
+    for (auto v : values) res.Add(v);
+    return res;
+}
+
+RoaringBitmap RoaringBitmap::FromSelection(const SelectionBitmap& selection)
+{
+    const auto& words = selection.Words();
+
+    RoaringBitmap res;
+    for (std::size_t begin = 0; begin < words.size(); begin += BITMAP_WORDS)
+    {
+        const std::size_t end = std::min(words.size(), begin + BITMAP_WORDS);
+        const std::size_t first = res.m_words.size();
+        res.m_words.resize(first + BITMAP_WORDS, 0);
+        std::copy(words.begin() + static_cast<std::ptrdiff_t>(begin), words.begin() + static_cast<std::ptrdiff_t>(end), res.m_words.begin() + static_cast<std::ptrdiff_t>(first));
+        res.FinishBitmap(static_cast<std::uint16_t>(begin / BITMAP_WORDS), first);
+    }
+    return res;
+}
+
+void RoaringBitmap::Add(std::uint32_t value)
+{
+    const auto key = static_cast<std::uint16_t>(value >> 16);
+    const auto low = static_cast<std::uint16_t>(value & 0xFFFF);
+
+    if (m_containers.empty() || m_containers.back().key < key)
+    {
+        m_containers.push_back({ key, ARRAY, 1, static_cast<std::uint32_t>(m_values.size()) });
+        m_values.push_back(low);
+        ++m_cardinality;
+        return;
+    }
+
+    Container& c = m_containers.back();
+    if (c.key != key) throw std::invalid_argument("RoaringBitmap::Add: value is below the last container.");
+
+    if (c.kind == BITMAP)
+    {
+        std::uint64_t& word = m_words[c.offset + low / 64];
+        const std::uint64_t bit = std::uint64_t{1} << (low % 64);
+        if (word & bit) return;
+
+        word |= bit;
+        ++c.cardinality;
+        ++m_cardinality;
+        return;
+    }
+
+    // The last array container is always at the tail of m_values.
+    auto pos = m_values.end();
+    if (low <= m_values.back())
+    {
+        pos = std::lower_bound(m_values.begin() + c.offset, m_values.end(), low);
+        if (*pos == low) return;
+    }
+
+    if (c.cardinality < ARRAY_MAX)
+    {
+        m_values.insert(pos, low);
+        ++c.cardinality;
+        ++m_cardinality;
+        return;
+    }
+
+    // A full array becomes a bitmap.
+    const std::size_t first = m_words.size();
+    m_words.resize(first + BITMAP_WORDS, 0);
+    for (std::size_t i = c.offset; i < m_values.size(); ++i) set_bit(m_words.data() + first, m_values[i]);
+    set_bit(m_words.data() + first, low);
+
+    m_values.resize(c.offset);
+    c.kind = BITMAP;
+    c.offset = static_cast<std::uint32_t>(first);
+    ++c.cardinality;
+    ++m_cardinality;
+}
+
+bool RoaringBitmap::Contains(std::uint32_t value) const
+{
+    const auto key = static_cast<std::uint16_t>(value >> 16);
+    const auto low = static_cast<std::uint16_t>(value & 0xFFFF);
+
+    auto it = std::ranges::lower_bound(m_containers, key, {}, &Container::key);
+    if (it == m_containers.end() || it->key != key) return false;
+
+    const auto c = View(static_cast<std::size_t>(it - m_containers.begin()));
+    if (c.IsBitmap()) return test_bit(c.words, low);
+
+    return std::ranges::binary_search(c.values, low);
+}
+
+std::vector<std::uint32_t> RoaringBitmap::ToVector() const
+{
+    std::vector<std::uint32_t> res;
+    res.reserve(m_cardinality);
+    ForEach([&](std::uint32_t v){ res.push_back(v); });
+    return res;
+}
+
+SelectionBitmap RoaringBitmap::ToSelection(std::size_t rows) const
+{
+    SelectionBitmap res(rows);
+    auto& words = res.Words();
+
+    for (std::size_t i = 0; i < m_containers.size(); ++i)
+    {
+        const auto c = View(i);
+        const std::size_t base = std::size_t{ c.key } * BITMAP_WORDS;
+        if (base >= words.size()) break;
+
+        if (c.IsBitmap())
+        {
+            const std::size_t n = std::min(BITMAP_WORDS, words.size() - base);
+            std::copy_n(c.words.begin(), n, words.begin() + static_cast<std::ptrdiff_t>(base));
+        }
+        else
+        {
+            for (auto low : c.values)
+            {
+                if (base + low / 64 >= words.size()) break;
+                words[base + low / 64] |= std::uint64_t{1} << (low % 64);
+            }
+        }
+    }
+
+    // Clear anything at or past `rows` in the last word.
+    if (rows % 64 != 0 && !words.empty()) words.back() &= (std::uint64_t{1} << (rows % 64)) - 1;
+    return res;
+}
+
+RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b)
+{
+    RoaringBitmap res;
+    std::size_t i = 0, j = 0;
+    while (i < a.m_containers.size() && j < b.m_containers.size())
+    {
+        const auto ka = a.m_containers[i].key;
+        const auto kb = b.m_containers[j].key;
+        if (ka < kb) ++i;
+        else if (kb < ka) ++j;
+        else res.AppendAnd(a.View(i++), b.View(j++));
+    }
+    return res;
+}
+
+RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b)
+{
+    RoaringBitmap res;
+    std::size_t i = 0, j = 0;
+    while (i < a.m_containers.size() || j < b.m_containers.size())
+    {
+        if (j == b.m_containers.size() || (i < a.m_containers.size() && a.m_containers[i].key < b.m_containers[j].key))
+            res.AppendCopy(a.View(i++));
+        else if (i == a.m_containers.size() || b.m_containers[j].key < a.m_containers[i].key)
+            res.AppendCopy(b.View(j++));
+        else
+            res.AppendOr(a.View(i++), b.View(j++));
+    }
+    return res;
+}
+
+RoaringBitmap operator-(const RoaringBitmap& a, const RoaringBitmap& b)
+{
+    RoaringBitmap res;
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < a.m_containers.size(); ++i)
+    {
+        const auto key = a.m_containers[i].key;
+        while (j < b.m_containers.size() && b.m_containers[j].key < key) ++j;
+
+        if (j < b.m_containers.size() && b.m_containers[j].key == key)
+            res.AppendAndNot(a.View(i), b.View(j));
+        else
+            res.AppendCopy(a.View(i));
+    }
+    return res;
+}
+
+RoaringBitmap RoaringBitmap::intersect(std::span<const RoaringBitmap* const> bitmaps)
+{
+    if (bitmaps.empty()) return {};
+
+    std::vector<const RoaringBitmap*> order(bitmaps.begin(), bitmaps.end());
+    std::ranges::sort(order, {}, &RoaringBitmap::m_cardinality);
+
+    RoaringBitmap res = *order.front();
+    for (std::size_t i = 1; i < order.size() && !res.Empty(); ++i) res &= *order[i];
+    return res;
+}
+
+RoaringBitmap RoaringBitmap::unite(std::span<const RoaringBitmap* const> bitmaps)
+{
+    // (key, bitmap, container) for every container, grouped by key.
+    struct Entry {
+        std::uint16_t key;
+        std::uint32_t bitmap;
+        std::uint32_t container;
+    };
+    std::vector<Entry> entries;
+    for (std::size_t b = 0; b < bitmaps.size(); ++b)
+    {
+        const auto& containers = bitmaps[b]->m_containers;
+        for (std::size_t c = 0; c < containers.size(); ++c)
+            entries.push_back({ containers[c].key, static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(c) });
+    }
+    std::ranges::stable_sort(entries, {}, &Entry::key);
+
+    RoaringBitmap res;
+    for (std::size_t i = 0; i < entries.size(); )
+    {
+        std::size_t end = i + 1;
+        while (end < entries.size() && entries[end].key == entries[i].key) ++end;
+
+        if (end - i == 1)
+        {
+            res.AppendCopy(bitmaps[entries[i].bitmap]->View(entries[i].container));
+        }
+        else
+        {
+            // Several containers share the key: accumulate them into one bitmap.
+            const std::size_t first = res.m_words.size();
+            res.m_words.resize(first + BITMAP_WORDS, 0);
+            std::uint64_t* words = res.m_words.data() + first;
+            for (std::size_t k = i; k < end; ++k)
+            {
+                const auto c = bitmaps[entries[k].bitmap]->View(entries[k].container);
+                if (c.IsBitmap())
+                    for (std::size_t w = 0; w < BITMAP_WORDS; ++w) words[w] |= c.words[w];
+                else
+                    for (auto low : c.values) set_bit(words, low);
+            }
+            res.FinishBitmap(entries[i].key, first);
+        }
+        i = end;
+    }
+    return res;
+}
+
+void RoaringBitmap::Save(SnapshotWriter& out) const
+{
+    out.Write(m_containers);
+    out.Write(m_values);
+    out.Write(m_words);
+}
+
+RoaringBitmap RoaringBitmap::Load(SnapshotReader& in)
+{
+    RoaringBitmap res;
+    res.m_containers = in.ReadVector<Container>();
+    res.m_values = in.ReadVector<std::uint16_t>();
+    res.m_words = in.ReadVector<std::uint64_t>();
+
+    for (const auto& c : res.m_containers)
+    {
+        const std::size_t size = c.kind == ARRAY ? c.cardinality : BITMAP_WORDS;
+        const std::size_t limit = c.kind == ARRAY ? res.m_values.size() : res.m_words.size();
+        if (c.kind > BITMAP || c.offset > limit || size > limit - c.offset)
+            throw std::runtime_error("Snapshot roaring bitmap is corrupt.");
+
+        res.m_cardinality += c.cardinality;
+    }
+    return res;
+}
+
+RoaringBitmap::ContainerView RoaringBitmap::View(std::size_t i) const
+{
+    const Container& c = m_containers[i];
+    if (c.kind == BITMAP) return { c.key, {}, std::span<const std::uint64_t>(m_words).subspan(c.offset, BITMAP_WORDS) };
+
+    return { c.key, std::span<const std::uint16_t>(m_values).subspan(c.offset, c.cardinality), {} };
+}
+
+void RoaringBitmap::FinishArray(std::uint16_t key, std::size_t begin)
+{
+    const std::size_t count = m_values.size() - begin;
+    if (count == 0) return;
+
+    if (count <= ARRAY_MAX)
+    {
+        m_containers.push_back({ key, ARRAY, static_cast<std::uint32_t>(count), static_cast<std::uint32_t>(begin) });
+        m_cardinality += count;
+        return;
+    }
+
+    const std::size_t first = m_words.size();
+    m_words.resize(first + BITMAP_WORDS, 0);
+    for (std::size_t i = begin; i < m_values.size(); ++i) set_bit(m_words.data() + first, m_values[i]);
+    m_values.resize(begin);
+
+    m_containers.push_back({ key, BITMAP, static_cast<std::uint32_t>(count), static_cast<std::uint32_t>(first) });
+    m_cardinality += count;
+}
+
+void RoaringBitmap::FinishBitmap(std::uint16_t key, std::size_t begin)
+{
+    std::size_t count = 0;
+    for (std::size_t i = begin; i < m_words.size(); ++i) count += static_cast<std::size_t>(std::popcount(m_words[i]));
+
+    if (count > ARRAY_MAX)
+    {
+        m_containers.push_back({ key, BITMAP, static_cast<std::uint32_t>(count), static_cast<std::uint32_t>(begin) });
+        m_cardinality += count;
+        return;
+    }
+
+    const std::size_t first = m_values.size();
+    for (std::size_t i = begin; i < m_words.size(); ++i)
+    {
+        for (auto w = m_words[i]; w != 0; w &= w - 1)
+            m_values.push_back(static_cast<std::uint16_t>((i - begin) * 64 + static_cast<std::size_t>(std::countr_zero(w))));
+    }
+    m_words.resize(begin);
+    FinishArray(key, first);
+}
+
+void RoaringBitmap::AppendCopy(const ContainerView& c)
+{
+    if (c.IsBitmap())
+    {
+        const std::size_t first = m_words.size();
+        m_words.insert(m_words.end(), c.words.begin(), c.words.end());
+        FinishBitmap(c.key, first);
+        return;
+    }
+
+    const std::size_t first = m_values.size();
+    m_values.insert(m_values.end(), c.values.begin(), c.values.end());
+    FinishArray(c.key, first);
+}
+
+void RoaringBitmap::AppendAnd(const ContainerView& a, const ContainerView& b)
+{
+    if (a.IsBitmap() && b.IsBitmap())
+    {
+        const std::size_t first = m_words.size();
+        m_words.resize(first + BITMAP_WORDS);
+        for (std::size_t w = 0; w < BITMAP_WORDS; ++w) m_words[first + w] = a.words[w] & b.words[w];
+        FinishBitmap(a.key, first);
+        return;
+    }
+
+    const std::size_t first = m_values.size();
+    if (!a.IsBitmap() && !b.IsBitmap())
+    {
+        intersect_arrays(a.values, b.values, m_values);
+    }
+    else
+    {
+        const auto& array = a.IsBitmap() ? b : a;
+        const auto& bitmap = a.IsBitmap() ? a : b;
+        for (auto low : array.values)
+            if (test_bit(bitmap.words, low)) m_values.push_back(low);
+    }
+    FinishArray(a.key, first);
+}
+
+void RoaringBitmap::AppendOr(const ContainerView& a, const ContainerView& b)
+{
+    if (!a.IsBitmap() && !b.IsBitmap())
+    {
+        const std::size_t first = m_values.size();
+        std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), std::back_inserter(m_values));
+        FinishArray(a.key, first);
+        return;
+    }
+
+    const std::size_t first = m_words.size();
+    m_words.resize(first + BITMAP_WORDS, 0);
+    std::uint64_t* words = m_words.data() + first;
+    for (const auto* c : { &a, &b })
+    {
+        if (c->IsBitmap())
+            for (std::size_t w = 0; w < BITMAP_WORDS; ++w) words[w] |= c->words[w];
+        else
+            for (auto low : c->values) set_bit(words, low);
+    }
+    FinishBitmap(a.key, first);
+}
+
+void RoaringBitmap::AppendAndNot(const ContainerView& a, const ContainerView& b)
+{
+    if (a.IsBitmap())
+    {
+        const std::size_t first = m_words.size();
+        m_words.insert(m_words.end(), a.words.begin(), a.words.end());
+        std::uint64_t* words = m_words.data() + first;
+        if (b.IsBitmap())
+            for (std::size_t w = 0; w < BITMAP_WORDS; ++w) words[w] &= ~b.words[w];
+        else
+            for (auto low : b.values) words[low / 64] &= ~(std::uint64_t{1} << (low % 64));
+        FinishBitmap(a.key, first);
+        return;
+    }
+
+    const std::size_t first = m_values.size();
+    if (b.IsBitmap())
+    {
+        for (auto low : a.values)
+            if (!test_bit(b.words, low)) m_values.push_back(low);
+    }
+    else
+    {
+        std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), std::back_inserter(m_values));
+    }
+    FinishArray(a.key, first);
+}
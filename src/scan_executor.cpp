@@ -0,0 +1,62 @@
+#include "scan_executor.h"
+
+static constexpr std::uint64_t pack_range(std::uint64_t begin, std::uint64_t end)
+{
+    return (begin << 32) | end;
+}
+
+MorselQueue::MorselQueue(std::size_t morselCount, std::size_t workers)
+    : m_ranges(std::max<std::size_t>(1, workers))
+{
+    const std::size_t n = m_ranges.size();
+    for (std::size_t w = 0; w < n; ++w)
+        m_ranges[w].store(pack_range(morselCount * w / n, morselCount * (w + 1) / n), std::memory_order_relaxed);
+}
+
+std::optional<std::size_t> MorselQueue::Next(std::size_t worker)
+{
+    if (auto morsel = Pop(worker)) return morsel;
+
+    return Steal(worker);
+}
+
+std::optional<std::size_t> MorselQueue::Pop(std::size_t worker)
+{
+    auto& range = m_ranges[worker];
+    std::uint64_t cur = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const std::uint64_t begin = cur >> 32;
+        const std::uint64_t end = cur & 0xFFFFFFFFu;
+        if (begin >= end) return std::nullopt;
+
+        if (range.compare_exchange_weak(cur, pack_range(begin + 1, end), std::memory_order_acq_rel))
+            return static_cast<std::size_t>(begin);
+    }
+}
+
+std::optional<std::size_t> MorselQueue::Steal(std::size_t thief)
+{
+    const std::size_t n = m_ranges.size();
+    for (std::size_t i = 1; i < n; ++i)
+    {
+        auto& victim = m_ranges[(thief + i) % n];
+        std::uint64_t cur = victim.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const std::uint64_t begin = cur >> 32;
+            const std::uint64_t end = cur & 0xFFFFFFFFu;
+            if (begin >= end) break;
+
+            // Take the back half; the victim keeps working on its front.
+            const std::uint64_t mid = begin + (end - begin) / 2;
+            if (victim.compare_exchange_weak(cur, pack_range(begin, mid), std::memory_order_acq_rel))
+            {
+                // The thief's own range is empty, so nobody else can be taking from it.
+                m_ranges[thief].store(pack_range(mid + 1, end), std::memory_order_release);
+                return static_cast<std::size_t>(mid);
+            }
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "database.h"
+#include "http_server.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "schema.h"
+#include "text_encoding.h"
+
+namespace fs = std::filesystem;
+
+// Long-running HTTP/JSON front end over one loaded Database:
+//   GET /health
+//   GET /staff/search?q=mueller&limit=20      fuzzy, accent-insensitive
+//   GET /staff/{id}                           staff record with its player / non-player record
+//   GET /clubs/search?q=ajax&limit=20
+//   GET /clubs/{id}
+//   GET /clubs/{id}/squad
+//   GET /metrics[?format=text]                Prometheus exposition, or a text report
+// Queries are UTF-8; names in responses are converted from the tables' Windows-1252.
+
+struct ServerOptions {
+    fs::path dataDir;
+    std::optional<fs::path> snapshot;
+    HttpServerOptions http;
+};
+
+static constexpr std::size_t DEFAULT_LIMIT = 20;
+static constexpr std::size_t MAX_LIMIT = 500;
+static constexpr std::size_t MAX_THREADS = 1024;
+
+// Every field of the record's schema as "name": value pairs of the open object.
+template <typename T>
+static void write_fields(JsonWriter& json, const T& rec)
+{
+    for (const auto& f : RecordSchema<T>::fields)
+    {
+        json.Key(f.name);
+        switch (f.type)
+        {
+        case FieldType::Integer:
+            json.Value(field_value(rec, f));
+            break;
+        case FieldType::Text:
+            json.Cp1252Value(field_text(rec, f));
+            break;
+        case FieldType::Date:
+        {
+            CMDate d;
+            std::memcpy(&d, reinterpret_cast<const std::byte*>(&rec) + f.offset, sizeof(d));
+            json.BeginObject().Key("day").Value(d.Day).Key("year").Value(d.Year).EndObject();
+            break;
+        }
+        case FieldType::IntegerArray:
+            json.BeginArray();
+            for (std::size_t e = 0; e < f.Count(); ++e) json.Value(field_value(rec, f, e));
+            json.EndArray();
+            break;
+        }
+    }
+}
+
+static std::string_view club_name(const Club& club)
+{
+    return field_text(club, schema_field<Club>("short_name"));
+}
+
+static std::optional<std::int32_t> parse_id(std::string_view text)
+{
+    std::int32_t id = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), id);
+    if (ec != std::errc() || ptr != text.data() + text.size() || text.empty()) return std::nullopt;
+
+    return id;
+}
+
+// DEFAULT_LIMIT when absent, clamped to [1, MAX_LIMIT]; std::nullopt when not a number.
+static std::optional<std::size_t> parse_limit(const HttpRequest& req)
+{
+    const auto text = req.Param("limit");
+    if (!text.has_value()) return DEFAULT_LIMIT;
+
+    std::size_t limit = 0;
+    auto [ptr, ec] = std::from_chars(text->data(), text->data() + text->size(), limit);
+    if (ec != std::errc() || ptr != text->data() + text->size() || text->empty()) return std::nullopt;
+
+    return std::clamp<std::size_t>(limit, 1, MAX_LIMIT);
+}
+
+// Short summary used by the search and squad lists.
+static void write_staff_summary(JsonWriter& json, const Database& db, std::size_t staffRow)
+{
+    const Staff& staff = db.Staffs().Records()[staffRow];
+    const auto view = db.StaffViewOfRow(staffRow);
+
+    json.Key("id").Value(staff.id)
+        .Key("name").Cp1252Value(db.StaffNames().GetByRow(staffRow))
+        .Key("nation").Value(staff.Nation)
+        .Key("yearOfBirth").Value(staff.DateOfBirth.Year)
+        .Key("clubId").Value(staff.ClubJob);
+
+    if (const Club* club = db.Clubs().FindById(staff.ClubJob))
+        json.Key("club").Cp1252Value(club_name(*club));
+
+    if (view.player != nullptr)
+        json.Key("currentAbility").Value(view.player->CurrentAbility)
+            .Key("potentialAbility").Value(view.player->PotentialAbility);
+}
+
+static HttpResponse staff_search(const Database& db, const HttpRequest& req)
+{
+    const auto q = req.Param("q");
+    if (!q.has_value() || q->empty()) return HttpResponse::Error(400, "missing query parameter q");
+    const auto limit = parse_limit(req);
+    if (!limit.has_value()) return HttpResponse::Error(400, "limit must be a non-negative integer");
+
+    JsonWriter json;
+    json.BeginObject().Key("query").Value(*q).Key("results").BeginArray();
+    for (const auto& match : *db.SearchStaffNames(utf8_to_cp1252(*q), *limit))
+    {
+        json.BeginObject();
+        write_staff_summary(json, db, match.doc);
+        json.Key("distance").Value(match.distance).EndObject();
+    }
+    json.EndArray().EndObject();
+    return HttpResponse::Json(std::move(json).Take());
+}
+
+static HttpResponse staff_by_id(const Database& db, std::int32_t id)
+{
+    const auto view = db.FindStaffView(id);
+    if (!view.has_value()) return HttpResponse::Error(404, "no staff with id " + std::to_string(id));
+
+    JsonWriter json;
+    json.BeginObject().Key("name").Cp1252Value(db.StaffName(*view->staff));
+    json.Key("staff").BeginObject();
+    write_fields(json, *view->staff);
+    json.EndObject();
+
+    json.Key("player");
+    if (view->player != nullptr)
+    {
+        json.BeginObject();
+        write_fields(json, *view->player);
+        json.EndObject();
+    }
+    else
+    {
+        json.Null();
+    }
+
+    json.Key("nonPlayer");
+    if (view->nonPlayer != nullptr)
+    {
+        json.BeginObject();
+        write_fields(json, *view->nonPlayer);
+        json.EndObject();
+    }
+    else
+    {
+        json.Null();
+    }
+
+    json.EndObject();
+    return HttpResponse::Json(std::move(json).Take());
+}
+
+static HttpResponse club_search(const Database& db, const HttpRequest& req)
+{
+    const auto q = req.Param("q");
+    if (!q.has_value() || q->empty()) return HttpResponse::Error(400, "missing query parameter q");
+    const auto limit = parse_limit(req);
+    if (!limit.has_value()) return HttpResponse::Error(400, "limit must be a non-negative integer");
+
+    const auto clubs = db.Clubs().Records();
+    JsonWriter json;
+    json.BeginObject().Key("query").Value(*q).Key("results").BeginArray();
+    for (const auto& match : *db.SearchClubNames(utf8_to_cp1252(*q), *limit))
+    {
+        const Club& club = clubs[match.doc];
+        json.BeginObject()
+            .Key("id").Value(club.id)
+            .Key("name").Cp1252Value(club_name(club))
+            .Key("longName").Cp1252Value(field_text(club, schema_field<Club>("long_name")))
+            .Key("nation").Value(club.nation_id)
+            .Key("division").Value(club.division_id)
+            .Key("distance").Value(match.distance)
+            .EndObject();
+    }
+    json.EndArray().EndObject();
+    return HttpResponse::Json(std::move(json).Take());
+}
+
+static HttpResponse club_by_id(const Database& db, std::int32_t id)
+{
+    const Club* club = db.Clubs().FindById(id);
+    if (club == nullptr) return HttpResponse::Error(404, "no club with id " + std::to_string(id));
+
+    JsonWriter json;
+    json.BeginObject();
+    write_fields(json, *club);
+    json.EndObject();
+    return HttpResponse::Json(std::move(json).Take());
+}
+
+static HttpResponse club_squad(const Database& db, std::int32_t id)
+{
+    const Club* club = db.Clubs().FindById(id);
+    if (club == nullptr) return HttpResponse::Error(404, "no club with id " + std::to_string(id));
+
+    const auto squad = club->playing_squad;
+    JsonWriter json;
+    json.BeginObject().Key("id").Value(club->id).Key("name").Cp1252Value(club_name(*club)).Key("squad").BeginArray();
+    for (std::int32_t staffId : squad)
+    {
+        if (staffId < 0) continue;
+
+        const auto row = db.Staffs().RowOf(staffId);
+        if (!row.has_value()) continue;
+
+        json.BeginObject();
+        write_staff_summary(json, db, *row);
+        json.EndObject();
+    }
+    json.EndArray().EndObject();
+    return HttpResponse::Json(std::move(json).Take());
+}
+
+enum class Route : std::size_t { Health, Metrics, StaffSearch, Staff, ClubSearch, Club, ClubSquad, Unknown, Count };
+
+// Histogram labels, indexed by Route.
+static constexpr std::array<std::string_view, static_cast<std::size_t>(Route::Count)> ROUTE_LABELS = {
+    "route=\"/health\"", "route=\"/metrics\"", "route=\"/staff/search\"", "route=\"/staff/{id}\"",
+    "route=\"/clubs/search\"", "route=\"/clubs/{id}\"", "route=\"/clubs/{id}/squad\"", "route=\"unknown\""
+};
+
+#if CM_METRICS
+// Resolved once, so timing a request never touches the registry lock.
+static LatencyHistogram& route_histogram(Route route)
+{
+    static const auto histograms = [] {
+        std::array<LatencyHistogram*, ROUTE_LABELS.size()> res{};
+        for (std::size_t i = 0; i < ROUTE_LABELS.size(); ++i)
+            res[i] = &metrics().GetHistogram("cm_http_request_seconds", ROUTE_LABELS[i], "Time to build an HTTP response, by route.");
+        return res;
+    }();
+    return *histograms[static_cast<std::size_t>(route)];
+}
+
+static Counter& status_counter(int status)
+{
+    static const auto counters = [] {
+        std::array<Counter*, 5> res{};
+        for (std::size_t i = 0; i < res.size(); ++i)
+            res[i] = &metrics().GetCounter("cm_http_responses_total", "code=\"" + std::to_string(i + 1) + "xx\"", "HTTP responses by status class.");
+        return res;
+    }();
+    return *counters[static_cast<std::size_t>(std::clamp(status / 100, 1, 5) - 1)];
+}
+#endif
+
+static Route match_route(std::string_view path, std::int32_t& id)
+{
+    if (path == "/health") return Route::Health;
+    if (path == "/metrics") return Route::Metrics;
+    if (path == "/staff/search") return Route::StaffSearch;
+    if (path == "/clubs/search") return Route::ClubSearch;
+
+    if (path.starts_with("/staff/"))
+    {
+        if (auto parsed = parse_id(path.substr(7)))
+        {
+            id = *parsed;
+            return Route::Staff;
+        }
+    }
+    else if (path.starts_with("/clubs/"))
+    {
+        std::string_view rest = path.substr(7);
+        const bool squad = rest.ends_with("/squad");
+        if (squad) rest.remove_suffix(6);
+
+        if (auto parsed = parse_id(rest))
+        {
+            id = *parsed;
+            return squad ? Route::ClubSquad : Route::Club;
+        }
+    }
+    return Route::Unknown;
+}
+
+static HttpResponse metrics_report(const HttpRequest& req)
+{
+    std::ostringstream out;
+    if (req.Param("format") == "text")
+    {
+        metrics().WriteText(out);
+        return HttpResponse{ 200, "text/plain; charset=utf-8", std::move(out).str() };
+    }
+
+    metrics().WritePrometheus(out);
+    return HttpResponse{ 200, "text/plain; version=0.0.4", std::move(out).str() };
+}
+
+static HttpResponse dispatch(const Database& db, const HttpRequest& req, Route route, std::int32_t id, std::string_view path)
+{
+    switch (route)
+    {
+    case Route::Health:
+    {
+        const CacheStats cache = db.SearchCacheStats();
+        JsonWriter json;
+        json.BeginObject().Key("status").Value("ok")
+            .Key("staff").Value(db.Staffs().Size())
+            .Key("clubs").Value(db.Clubs().Size())
+            .Key("searchCache").BeginObject()
+                .Key("hits").Value(cache.hits)
+                .Key("misses").Value(cache.misses)
+                .Key("evictions").Value(cache.evictions)
+                .Key("entries").Value(cache.entries)
+                .Key("bytes").Value(cache.bytes)
+            .EndObject()
+            .EndObject();
+        return HttpResponse::Json(std::move(json).Take());
+    }
+    case Route::Metrics: return metrics_report(req);
+    case Route::StaffSearch: return staff_search(db, req);
+    case Route::Staff: return staff_by_id(db, id);
+    case Route::ClubSearch: return club_search(db, req);
+    case Route::Club: return club_by_id(db, id);
+    case Route::ClubSquad: return club_squad(db, id);
+    default: return HttpResponse::Error(404, "no route for " + std::string(path));
+    }
+}
+
+static HttpResponse route(const Database& db, const HttpRequest& req)
+{
+    if (req.method != "GET" && req.method != "HEAD") return HttpResponse::Error(405, "only GET and HEAD are supported");
+
+    std::string_view path = req.path;
+    if (path.size() > 1 && path.back() == '/') path.remove_suffix(1);
+
+    std::int32_t id = 0;
+    const Route matched = match_route(path, id);
+
+    HttpResponse res;
+    {
+#if CM_METRICS
+        ScopedTimer timer(route_histogram(matched));
+#endif
+        res = dispatch(db, req, matched, id, path);
+    }
+#if CM_METRICS
+    if (MetricsRegistry::Enabled()) status_counter(res.status).Add();
+#endif
+    return res;
+}
+
+static void usage(const char* argv0)
+{
+    std::cerr << "usage: " << argv0 << " <data-dir> [--port N] [--bind ADDR] [--threads N] [--snapshot FILE]\n"
+              << "Loads the database once (from the snapshot while it is valid) and serves\n"
+              << "search and lookup endpoints as JSON over HTTP/1.1 until SIGINT/SIGTERM.\n";
+}
+
+// Whole-string decimal number no larger than `max`.
+static std::optional<std::size_t> parse_number(std::string_view text, std::size_t max)
+{
+    std::size_t n = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), n);
+    if (ec != std::errc() || ptr != text.data() + text.size() || text.empty() || n > max) return std::nullopt;
+
+    return n;
+}
+
+static bool parse_args(int argc, char** argv, ServerOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--port" && i + 1 < argc)
+        {
+            const auto port = parse_number(argv[++i], UINT16_MAX);
+            if (!port.has_value()) return false;
+            options.http.port = static_cast<std::uint16_t>(*port);
+        }
+        else if (arg == "--bind" && i + 1 < argc)
+        {
+            options.http.bindAddress = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            const auto threads = parse_number(argv[++i], MAX_THREADS);
+            if (!threads.has_value()) return false;
+            options.http.threads = *threads;
+        }
+        else if (arg == "--snapshot" && i + 1 < argc)
+        {
+            options.snapshot = fs::path(argv[++i]);
+        }
+        else if (!arg.starts_with("--") && options.dataDir.empty())
+        {
+            options.dataDir = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return !options.dataDir.empty();
+}
+
+int main(int argc, char** argv) {
+
+    ServerOptions options;
+    if (!parse_args(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Blocked before any thread starts, so only sigwait below sees them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::shared_ptr<const Database> db;
+    std::optional<HttpServer> server;
+    try
+    {
+        db = options.snapshot ? Database::Open(options.dataDir, *options.snapshot) : Database::Load(options.dataDir);
+        server.emplace(options.http, [db](const HttpRequest& req){ return route(*db, req); });
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[error] " << e.what() << "\n";
+        return 1;
+    }
+
+    server->Start();
+    std::cout << "Serving " << db->Staffs().Size() << " staff and " << db->Clubs().Size() << " clubs on http://"
+              << options.http.bindAddress << ":" << server->Port() << std::endl;
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    std::cout << "Shutting down" << std::endl;
+    server->Stop();
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+#include "secondary_indexes.h"
+#include "snapshot_io.h"
+
+// key(staff) -> staff row for every staff member.
+template <typename Key>
+static RangeIndex build_range_index(std::span<const Staff> staffs, Key key)
+{
+    std::vector<std::pair<std::int32_t, std::uint32_t>> entries;
+    entries.reserve(staffs.size());
+    for (std::size_t row = 0; row < staffs.size(); ++row)
+        entries.emplace_back(static_cast<std::int32_t>(key(staffs[row])), static_cast<std::uint32_t>(row));
+    return RangeIndex(std::move(entries));
+}
+
+SecondaryIndexes::SecondaryIndexes(std::span<const Staff> staffs, std::span<const Club> clubs, std::span<const Player> players, const StaffJoin& join)
+    : m_staffCount(static_cast<std::uint32_t>(staffs.size())),
+      m_staffNation(BitmapIndex::Build(staffs, [](const Staff& s){ return s.Nation; })),
+      m_staffClassification(BitmapIndex::Build(staffs, [](const Staff& s){ return s.Classification; })),
+      m_staffJobForClub(BitmapIndex::Build(staffs, [](const Staff& s){ return s.JobForClub; })),
+      m_staffPlayingSquad(BitmapIndex::Build(staffs, [](const Staff& s){ return s.PlayingSquad; })),
+      m_clubDivision(BitmapIndex::Build(clubs, [](const Club& c){ return c.division_id; })),
+      m_staffValue(build_range_index(staffs, [](const Staff& s){ return s.Value; })),
+      m_staffWage(build_range_index(staffs, [](const Staff& s){ return s.Wage; })),
+      m_staffBirthDay(build_range_index(staffs, [](const Staff& s){ return day_number(s.DateOfBirth); })),
+      m_staffClubExpiryDay(build_range_index(staffs, [](const Staff& s){ return day_number(s.DateExpiresClub); }))
+{
+    std::vector<std::pair<std::int32_t, std::uint32_t>> currentAbility, potentialAbility, worldReputation;
+
+    // Player rows are in staff row order, so the bitmaps append too.
+    for (const auto& row : join.PlayerRows())
+    {
+        for (std::size_t p = 0; p < PLAYER_POSITION_COUNT; ++p)
+            if (row.attributes[p] >= NATURAL_POSITION_RATING) m_naturalAt[p].Add(row.staffRow);
+
+        currentAbility.emplace_back(row.currentAbility, row.staffRow);
+        potentialAbility.emplace_back(row.potentialAbility, row.staffRow);
+        worldReputation.emplace_back(players[row.playerRow].WorldReputation, row.staffRow);
+    }
+
+    m_playerCurrentAbility = RangeIndex(std::move(currentAbility));
+    m_playerPotentialAbility = RangeIndex(std::move(potentialAbility));
+    m_playerWorldReputation = RangeIndex(std::move(worldReputation));
+}
+
+const RoaringBitmap& SecondaryIndexes::StaffNaturalAt(PlayerAttribute position) const
+{
+    const auto p = static_cast<std::size_t>(position);
+    if (p >= PLAYER_POSITION_COUNT) throw std::out_of_range("Not a position attribute.");
+
+    return m_naturalAt[p];
+}
+
+RoaringBitmap SecondaryIndexes::MatchStaff(const StaffFilter& filter) const
+{
+    // Single-value clauses point straight at the index; the rest are built into `owned`.
+    std::deque<RoaringBitmap> owned;
+    std::vector<const RoaringBitmap*> clauses;
+
+    auto addClause = [&](const BitmapIndex& index, std::span<const std::int32_t> values) {
+        if (values.empty()) return;
+        if (values.size() == 1)
+            clauses.push_back(&index.Equal(values.front()));
+        else
+            clauses.push_back(&owned.emplace_back(index.In(values)));
+    };
+
+    addClause(m_staffNation, filter.nations);
+    addClause(m_staffClassification, filter.classifications);
+    addClause(m_staffJobForClub, filter.jobsForClub);
+    addClause(m_staffPlayingSquad, filter.playingSquads);
+
+    if (!filter.naturalPositions.empty())
+    {
+        std::vector<const RoaringBitmap*> positions;
+        for (auto position : filter.naturalPositions) positions.push_back(&StaffNaturalAt(position));
+        clauses.push_back(&owned.emplace_back(RoaringBitmap::unite(positions)));
+    }
+
+    auto addRange = [&](const RangeIndex& index, const std::optional<IntRange>& range) {
+        if (range.has_value()) clauses.push_back(&owned.emplace_back(index.BitmapBetween(*range)));
+    };
+
+    addRange(m_staffValue, filter.value);
+    addRange(m_staffWage, filter.wage);
+    addRange(m_playerCurrentAbility, filter.currentAbility);
+    addRange(m_playerPotentialAbility, filter.potentialAbility);
+    addRange(m_playerWorldReputation, filter.worldReputation);
+    addRange(m_staffBirthDay, filter.birthDay);
+    addRange(m_staffClubExpiryDay, filter.clubExpiryDay);
+
+    if (clauses.empty()) return RoaringBitmap::Range(0, m_staffCount);
+    return RoaringBitmap::intersect(clauses);
+}
+
+std::size_t SecondaryIndexes::ByteSize() const
+{
+    std::size_t bytes = m_staffNation.ByteSize() + m_staffClassification.ByteSize() + m_staffJobForClub.ByteSize()
+                      + m_staffPlayingSquad.ByteSize() + m_clubDivision.ByteSize();
+    for (const auto& bitmap : m_naturalAt) bytes += bitmap.ByteSize();
+    for (const auto* index : { &m_staffValue, &m_staffWage, &m_playerCurrentAbility, &m_playerPotentialAbility, &m_playerWorldReputation,
+                              &m_staffBirthDay, &m_staffClubExpiryDay })
+        bytes += index->ByteSize();
+    return bytes;
+}
+
+void SecondaryIndexes::Save(SnapshotWriter& out) const
+{
+    out.WriteValue(m_staffCount);
+    m_staffNation.Save(out);
+    m_staffClassification.Save(out);
+    m_staffJobForClub.Save(out);
+    m_staffPlayingSquad.Save(out);
+    m_clubDivision.Save(out);
+    for (const auto& bitmap : m_naturalAt) bitmap.Save(out);
+    m_staffValue.Save(out);
+    m_staffWage.Save(out);
+    m_playerCurrentAbility.Save(out);
+    m_playerPotentialAbility.Save(out);
+    m_playerWorldReputation.Save(out);
+    m_staffBirthDay.Save(out);
+    m_staffClubExpiryDay.Save(out);
+}
+
+SecondaryIndexes SecondaryIndexes::Load(SnapshotReader& in)
+{
+    SecondaryIndexes index;
+    index.m_staffCount = in.ReadValue<std::uint32_t>();
+    index.m_staffNation = BitmapIndex::Load(in);
+    index.m_staffClassification = BitmapIndex::Load(in);
+    index.m_staffJobForClub = BitmapIndex::Load(in);
+    index.m_staffPlayingSquad = BitmapIndex::Load(in);
+    index.m_clubDivision = BitmapIndex::Load(in);
+    for (auto& bitmap : index.m_naturalAt) bitmap = RoaringBitmap::Load(in);
+    index.m_staffValue = RangeIndex::Load(in);
+    index.m_staffWage = RangeIndex::Load(in);
+    index.m_playerCurrentAbility = RangeIndex::Load(in);
+    index.m_playerPotentialAbility = RangeIndex::Load(in);
+    index.m_playerWorldReputation = RangeIndex::Load(in);
+    index.m_staffBirthDay = RangeIndex::Load(in);
+    index.m_staffClubExpiryDay = RangeIndex::Load(in);
+    return index;
+}
@@ -0,0 +1,255 @@
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "database.h"
+#include "metrics.h"
+#include "snapshot_io.h"
+
+namespace fs = std::filesystem;
+
+// Bump whenever the payload layout or any serialized structure changes.
+static constexpr std::uint32_t SNAPSHOT_FORMAT_VERSION = 8;
+static constexpr char SNAPSHOT_MAGIC[8] = { 'C', 'M', 'S', 'N', 'A', 'P', '\0', '\0' };
+static constexpr std::uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t byteOrder;        // read back as something else on a host of the other endianness
+    std::uint64_t payloadBytes;
+    std::uint64_t checksum;         // of the payload
+    std::uint8_t reserved[32];
+};
+static_assert(sizeof(SnapshotHeader) == SNAPSHOT_ALIGNMENT);
+
+// xxhash-style four-lane mix, fast enough to verify a 30 MB payload in a few milliseconds.
+static std::uint64_t snapshot_checksum(std::span<const std::byte> bytes)
+{
+    constexpr std::uint64_t P1 = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+
+    std::uint64_t lanes[4] = { P1 + P2, P2, 0, 0 - P1 };
+    std::size_t i = 0;
+    for (; i + 32 <= bytes.size(); i += 32)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, bytes.data() + i + 8 * k, 8);
+            lanes[k] = std::rotl(lanes[k] + v * P2, 31) * P1;
+        }
+    }
+
+    std::uint64_t h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+    for (; i < bytes.size(); ++i)
+        h = std::rotl(h ^ (static_cast<std::uint64_t>(bytes[i]) * P1), 11) * P2;
+
+    h ^= bytes.size();
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    return h;
+}
+
+std::string Database::SourceFingerprint(const fs::path& dataDir, const DatabaseOptions& options)
+{
+    std::ostringstream out;
+    for (const char* name : { options.indexFile.c_str(), "club.dat", "staff.dat",
+                              "first_names.dat", "second_names.dat", "common_names.dat" })
+    {
+        std::error_code ec;
+        const auto path = dataDir / name;
+        const auto size = fs::file_size(path, ec);
+        if (ec)
+        {
+            out << name << " missing\n";
+            continue;
+        }
+        const auto mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+        out << name << ' ' << size << ' ' << mtime << '\n';
+    }
+    return out.str();
+}
+
+template <typename T>
+static void save_table(SnapshotWriter& out, const Repository<T>& repo)
+{
+    out.Write(repo.Records());
+    repo.Ids().Save(out);
+}
+
+template <typename T>
+static Repository<T> load_table(SnapshotReader& in, const std::shared_ptr<const MappedFile>& file)
+{
+    auto block = in.ReadBytes();
+    return Repository<T>(file, block, IdIndex::Load(in));
+}
+
+void Database::SaveSnapshot(const fs::path& file) const
+{
+    CM_TIME_SCOPE("cm_snapshot_seconds", "op=\"save\"");
+
+    SnapshotWriter out;
+    out.WriteString(m_sources);
+
+    save_table(out, m_indexes);
+    save_table(out, m_clubs);
+    save_table(out, m_staffs);
+    save_table(out, m_nonPlayers);
+    save_table(out, m_players);
+    save_table(out, m_firstNames);
+    save_table(out, m_secondNames);
+    out.WriteValue<std::uint8_t>(m_commonNames.has_value() ? 1 : 0);
+    if (m_commonNames.has_value()) save_table(out, *m_commonNames);
+    out.WriteBytes(m_staffPreferences);
+
+    m_firstNameTable.Save(out);
+    m_secondNameTable.Save(out);
+    m_commonNameTable.Save(out);
+    m_staffNames.Save(out);
+    m_references.Save(out);
+    m_staffJoin.Save(out);
+    m_staffDates.Save(out);
+    m_staffNameIndex.Save(out);
+    m_clubNameIndex.Save(out);
+    m_secondary.Save(out);
+
+    const auto& payload = out.Buffer();
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.formatVersion = SNAPSHOT_FORMAT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.payloadBytes = payload.size();
+    header.checksum = snapshot_checksum(payload);
+
+    // Write to a uniquely named file next to the target and rename, so readers
+    // never map a half-written file and concurrent savers never share one.
+    std::string tmpName = file.string() + ".XXXXXX";
+    const int fd = ::mkstemp(tmpName.data());
+    if (fd < 0) throw std::runtime_error("Failed to create a temporary file next to: " + file.string());
+    ::fchmod(fd, 0644);
+    ::close(fd);
+
+    const fs::path tmp = tmpName;
+    try
+    {
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f) throw std::runtime_error("Failed to create: " + tmp.string());
+            f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            f.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+            if (!f) throw std::runtime_error("Failed to write: " + tmp.string());
+        }
+        fs::rename(tmp, file);
+    }
+    catch (...)
+    {
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        throw;
+    }
+}
+
+std::shared_ptr<const Database> Database::LoadSnapshot(const fs::path& file, const fs::path& dataDir, const DatabaseOptions& options)
+{
+    CM_TIME_SCOPE("cm_snapshot_seconds", "op=\"load\"");
+
+    if (!fs::exists(file)) return nullptr;
+
+    try
+    {
+        auto snapshot = std::make_shared<const MappedFile>(file);
+        if (snapshot->Size() < sizeof(SnapshotHeader)) return nullptr;
+
+        SnapshotHeader header;
+        std::memcpy(&header, snapshot->Bytes().data(), sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+            || header.formatVersion != SNAPSHOT_FORMAT_VERSION
+            || header.byteOrder != SNAPSHOT_BYTE_ORDER
+            || header.payloadBytes != snapshot->Size() - sizeof(SnapshotHeader))
+            return nullptr;
+
+        const auto payload = snapshot->Slice(sizeof(SnapshotHeader), header.payloadBytes);
+        if (snapshot_checksum(payload) != header.checksum) return nullptr;
+
+        SnapshotReader in(payload, sizeof(SnapshotHeader));
+
+        std::string sources = in.ReadString();
+        if (sources != SourceFingerprint(dataDir, options)) return nullptr;
+
+        auto indexes     = load_table<Index>(in, snapshot);
+        auto clubs       = load_table<Club>(in, snapshot);
+        auto staffs      = load_table<Staff>(in, snapshot);
+        auto nonPlayers  = load_table<NonPlayer>(in, snapshot);
+        auto players     = load_table<Player>(in, snapshot);
+        auto firstNames  = load_table<FirstName>(in, snapshot);
+        auto secondNames = load_table<SecondName>(in, snapshot);
+
+        std::optional<Repository<CommonName>> commonNames;
+        if (in.ReadValue<std::uint8_t>() != 0) commonNames = load_table<CommonName>(in, snapshot);
+
+        const auto preferences = in.ReadBytes();
+
+        Tables tables{
+            dataDir,
+            snapshot,
+            std::move(indexes),
+            std::move(clubs),
+            std::move(staffs),
+            std::move(nonPlayers),
+            std::move(players),
+            std::move(firstNames),
+            std::move(secondNames),
+            std::move(commonNames),
+            preferences,
+            NameTable::Load(in),
+            NameTable::Load(in),
+            NameTable::Load(in),
+            StaffNameCache::Load(in),
+            ReferenceIndex::Load(in),
+            StaffJoin::Load(in),
+            StaffDateColumns::Load(in),
+            FuzzyIndex::Load(in),
+            FuzzyIndex::Load(in),
+            SecondaryIndexes::Load(in),
+            std::move(sources),
+            options.searchCacheBytes
+        };
+
+        return std::shared_ptr<const Database>(new Database(std::move(tables)));
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "[warn] Ignoring snapshot " << file.string() << ": " << e.what() << "\n";
+        return nullptr;
+    }
+}
+
+std::shared_ptr<const Database> Database::Open(const fs::path& dataDir, const fs::path& snapshot, const DatabaseOptions& options)
+{
+    if (auto db = LoadSnapshot(snapshot, dataDir, options))
+        return db;
+
+    auto db = Load(dataDir, options);
+
+    // The snapshot only speeds up the next start, so failing to write one
+    // (e.g. a read-only directory) must not fail the open.
+    try
+    {
+        db->SaveSnapshot(snapshot);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "[warn] Could not save snapshot " << snapshot.string() << ": " << e.what() << "\n";
+    }
+    return db;
+}
@@ -0,0 +1,157 @@
+#include <stdexcept>
+
+#include "snapshot_io.h"
+#include "staff_dates.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CM_X86_KERNELS 1
+#endif
+
+struct DayRange {
+    const std::int32_t* column;
+    std::int32_t min;
+    std::int32_t max;
+};
+
+// Rows [first, rows) one at a time; also used for the tail the SIMD kernels leave.
+static void filter_scalar(const std::vector<DayRange>& ranges, std::size_t first, std::size_t rows, std::uint64_t* words)
+{
+    for (std::size_t row = first; row < rows; ++row)
+    {
+        bool keep = true;
+        for (const auto& r : ranges)
+        {
+            const auto v = r.column[row];
+            keep = keep && v >= r.min && v <= r.max;
+        }
+        if (keep) words[row / 64] |= std::uint64_t{1} << (row % 64);
+    }
+}
+
+#ifdef CM_X86_KERNELS
+
+// Bits of the 64 rows starting at `base` that fall outside [min, max].
+__attribute__((target("avx2")))
+static inline std::uint64_t out_of_range_avx2(const DayRange& r, std::size_t base)
+{
+    const __m256i lo = _mm256_set1_epi32(r.min);
+    const __m256i hi = _mm256_set1_epi32(r.max);
+    const auto* p = reinterpret_cast<const __m256i*>(r.column + base);
+
+    std::uint64_t bits = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+        const __m256i v = _mm256_loadu_si256(p + k);
+        const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(lo, v), _mm256_cmpgt_epi32(v, hi));
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(out)))) << (8 * k);
+    }
+    return bits;
+}
+
+__attribute__((target("avx2")))
+static std::size_t filter_avx2(const std::vector<DayRange>& ranges, std::size_t rows, std::uint64_t* words)
+{
+    const std::size_t full = rows / 64;
+    for (std::size_t w = 0; w < full; ++w)
+    {
+        std::uint64_t keep = ~std::uint64_t{0};
+        for (std::size_t i = 0; i < ranges.size() && keep != 0; ++i)
+            keep &= ~out_of_range_avx2(ranges[i], w * 64);
+        words[w] = keep;
+    }
+    return full * 64;
+}
+
+static inline std::uint64_t out_of_range_sse2(const DayRange& r, std::size_t base)
+{
+    const __m128i lo = _mm_set1_epi32(r.min);
+    const __m128i hi = _mm_set1_epi32(r.max);
+    const auto* p = reinterpret_cast<const __m128i*>(r.column + base);
+
+    std::uint64_t bits = 0;
+    for (int k = 0; k < 16; ++k)
+    {
+        const __m128i v = _mm_loadu_si128(p + k);
+        const __m128i out = _mm_or_si128(_mm_cmpgt_epi32(lo, v), _mm_cmpgt_epi32(v, hi));
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(out)))) << (4 * k);
+    }
+    return bits;
+}
+
+static std::size_t filter_sse2(const std::vector<DayRange>& ranges, std::size_t rows, std::uint64_t* words)
+{
+    const std::size_t full = rows / 64;
+    for (std::size_t w = 0; w < full; ++w)
+    {
+        std::uint64_t keep = ~std::uint64_t{0};
+        for (std::size_t i = 0; i < ranges.size() && keep != 0; ++i)
+            keep &= ~out_of_range_sse2(ranges[i], w * 64);
+        words[w] = keep;
+    }
+    return full * 64;
+}
+
+#endif
+
+StaffDateColumns::StaffDateColumns(std::span<const Staff> staffs)
+    : m_rows(staffs.size()),
+      m_stride((staffs.size() + 63) / 64 * 64),
+      m_data(STAFF_DATE_COUNT * m_stride, NO_DAY)
+{
+    auto column = [&](StaffDate date) { return m_data.data() + static_cast<std::size_t>(date) * m_stride; };
+    std::int32_t* birth = column(StaffDate::Birth);
+    std::int32_t* joinedNation = column(StaffDate::JoinedNation);
+    std::int32_t* expiresNation = column(StaffDate::ExpiresNation);
+    std::int32_t* joinedClub = column(StaffDate::JoinedClub);
+    std::int32_t* expiresClub = column(StaffDate::ExpiresClub);
+
+    for (std::size_t row = 0; row < m_rows; ++row)
+    {
+        const Staff& s = staffs[row];
+        birth[row] = day_number(s.DateOfBirth);
+        joinedNation[row] = day_number(s.DateJoinedNation);
+        expiresNation[row] = day_number(s.DateExpiresNation);
+        joinedClub[row] = day_number(s.DateJoinedClub);
+        expiresClub[row] = day_number(s.DateExpiresClub);
+    }
+}
+
+SelectionBitmap StaffDateColumns::Filter(std::span<const DateRange> ranges) const
+{
+    SelectionBitmap selection(m_rows);
+    auto* words = selection.Words().data();
+
+    std::vector<DayRange> columns;
+    columns.reserve(ranges.size());
+    for (const auto& r : ranges)
+        columns.push_back({ Column(r.date).data(), r.min, r.max });
+
+    std::size_t done = 0;
+#ifdef CM_X86_KERNELS
+    if (__builtin_cpu_supports("avx2"))
+        done = filter_avx2(columns, m_rows, words);
+    else
+        done = filter_sse2(columns, m_rows, words);
+#endif
+    filter_scalar(columns, done, m_rows, words);
+
+    return selection;
+}
+
+void StaffDateColumns::Save(SnapshotWriter& out) const
+{
+    out.WriteValue<std::uint64_t>(m_rows);
+    out.Write(m_data);
+}
+
+StaffDateColumns StaffDateColumns::Load(SnapshotReader& in)
+{
+    StaffDateColumns columns;
+    columns.m_rows = static_cast<std::size_t>(in.ReadValue<std::uint64_t>());
+    columns.m_stride = (columns.m_rows + 63) / 64 * 64;
+    columns.m_data = in.ReadVector<std::int32_t>();
+    if (columns.m_data.size() != STAFF_DATE_COUNT * columns.m_stride)
+        throw std::runtime_error("Snapshot staff date columns are corrupt.");
+    return columns;
+}
@@ -0,0 +1,19 @@
+#include "schema.h"
+#include "staff_decoder.h"
+
+void byteswap_staff_fields(std::span<Staff> records)
+{
+    byteswap_fields(records);
+}
+
+void decode_staff_block(std::span<const std::byte> bytes, std::span<Staff> out)
+{
+    decode_records(bytes, out);
+}
+
+std::vector<Staff> decode_staff_block(std::span<const std::byte> bytes)
+{
+    std::vector<Staff> res(bytes.size() / sizeof(Staff));
+    decode_staff_block(bytes, res);
+    return res;
+}
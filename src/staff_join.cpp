@@ -0,0 +1,65 @@
+#include <cstring>
+
+#include "snapshot_io.h"
+#include "staff_join.h"
+
+StaffJoin::StaffJoin(std::span<const Staff> staffs, const Repository<Player>& players, const Repository<NonPlayer>& nonPlayers)
+    : m_playerOf(staffs.size(), NO_ROW),
+      m_nonPlayerOf(staffs.size(), NO_ROW),
+      m_playerRowOf(staffs.size(), NO_ROW)
+{
+    const auto playerRecords = players.Records();
+
+    for (std::size_t i = 0; i < staffs.size(); ++i)
+    {
+        const Staff& staff = staffs[i];
+
+        if (staff.NonPlayer >= 0)
+        {
+            if (auto row = nonPlayers.RowOf(staff.NonPlayer))
+                m_nonPlayerOf[i] = static_cast<std::int32_t>(*row);
+        }
+
+        if (staff.Player < 0)
+            continue;
+
+        auto row = players.RowOf(staff.Player);
+        if (!row.has_value())
+            continue;
+
+        const Player& player = playerRecords[*row];
+        m_playerOf[i] = static_cast<std::int32_t>(*row);
+        m_playerRowOf[i] = static_cast<std::int32_t>(m_playerRows.size());
+
+        PlayerRow& pr = m_playerRows.emplace_back();
+        pr.staffId = staff.id;
+        pr.staffRow = static_cast<std::uint32_t>(i);
+        pr.playerRow = static_cast<std::uint32_t>(*row);
+        pr.nation = staff.Nation;
+        pr.clubJob = staff.ClubJob;
+        pr.value = staff.Value;
+        pr.wage = staff.Wage;
+        pr.birthYear = staff.DateOfBirth.Year;
+        pr.currentAbility = player.CurrentAbility;
+        pr.potentialAbility = player.PotentialAbility;
+        std::memcpy(pr.attributes.data(), reinterpret_cast<const std::byte*>(&player) + PLAYER_ATTRIBUTE_OFFSET, PLAYER_ATTRIBUTE_COUNT);
+    }
+}
+
+void StaffJoin::Save(SnapshotWriter& out) const
+{
+    out.Write(m_playerOf);
+    out.Write(m_nonPlayerOf);
+    out.Write(m_playerRowOf);
+    out.Write(m_playerRows);
+}
+
+StaffJoin StaffJoin::Load(SnapshotReader& in)
+{
+    StaffJoin join;
+    join.m_playerOf = in.ReadVector<std::int32_t>();
+    join.m_nonPlayerOf = in.ReadVector<std::int32_t>();
+    join.m_playerRowOf = in.ReadVector<std::int32_t>();
+    join.m_playerRows = in.ReadVector<PlayerRow>();
+    return join;
+}
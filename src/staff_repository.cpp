@@ -1,74 +1,68 @@
-#include <fstream>
 #include <iomanip>
 #include <iostream> 
 #include <algorithm>
 #include <iterator>
 
+#include "index.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "repository.h"
+#include "staff_decoder.h"
 #include "staff_repository.h"
 
-// index offset and lazy deserialize. 
-// normally, in this implementation one time indexing offsets should be done 
-// and then the deserialization for only the offset 
-// think about thread safety as well
-// additionally add a small LRU cache 
-StaffRepository::StaffRepository(const std::filesystem::path& tableName): m_tablePath(tableName) 
+StaffRepository::StaffRepository(const std::filesystem::path& tableName, std::size_t searchCacheBytes)
+    : m_tablePath(tableName), m_searchCache(searchCacheBytes)
 {
-    std::cout << sizeof(Staff) << std::endl;
-    std::ifstream in(m_tablePath, std::ios::binary);
-    if (!in) throw std::runtime_error("Failed to open: " + m_tablePath.string());
-
-    in.seekg(0, std::ios::end);
-    const std::streamoff size = in.tellg();
-    in.seekg(0, std::ios::beg);
-
-    if (size < 0) throw std::runtime_error("Bad file size.");
-    // if (size % sizeof(Staff) != 0) {
-    //     std::cerr << "[warn] File size (" << size << ") is not divisible by 581. "
-    //               << "Parsing will use floor(size/581) records.\n";
-    // }
-
-    //const size_t count = static_cast<size_t>(size / sizeof(Staff));
-    const size_t count = 132724; //TODO: calculated manually by hand. 
-    m_staffs.resize(count);
-
-    for (size_t i = 0; i < count; ++i) {
-        Staff rec = read_staff_le(in);
-        if (!in) throw std::runtime_error("Read error at record " + std::to_string(i));
-        m_staffs[i] = rec;
-
-        // Staff rec{};
-        // in.read(reinterpret_cast<char*>(&rec), sizeof(rec));
-        // if (!in) throw std::runtime_error("Read error while reading record " + std::to_string(i));
-        // m_staffs[i] = rec;
+    // Mapped rather than read into a buffer, so the raw block is never held
+    // alongside the decoded records.
+    const MappedFile file(m_tablePath);
+
+    // staff.dat holds several blocks back to back; the people block's offset and
+    // record count come from the index.dat next to it. A lone table file is
+    // taken to be nothing but staff records.
+    size_t offset = 0;
+    size_t count = file.Size() / sizeof(Staff);
+    const auto indexPath = m_tablePath.parent_path() / "index.dat";
+    if (std::filesystem::exists(indexPath))
+    {
+        constexpr size_t INDEX_HEADER_OFFSET = 8;
+        const Repository<Index> indexes(indexPath, INDEX_HEADER_OFFSET);
+        const auto entries = indexes.Records();
+        auto people = std::ranges::find_if(entries, [](const Index& idx) {
+            return index_file_name(idx) == "staff.dat" && index_block_type(idx) == static_cast<std::uint32_t>(StaffBlock::People);
+        });
+        if (people == entries.end())
+            throw std::runtime_error("index.dat has no staff.dat people block: " + indexPath.string());
+
+        offset = people->offset;
+        count = people->table_size;
+    }
+    else if (file.Size() % sizeof(Staff) != 0)
+    {
+        std::cerr << "[warn] File size (" << file.Size() << ") is not divisible by " << sizeof(Staff) << ". "
+                  << "Parsing will use floor(size/" << sizeof(Staff) << ") records.\n";
     }
 
-    std::cout << "==[0]===\n";
-    std::cout << m_staffs[0] << std::endl;
-    std::cout << "======\n";
-
-
-    std::cout << "==[1]===\n";
-    std::cout << m_staffs[1] << std::endl;
-    std::cout << "======\n";
+    if (offset > file.Size() || (file.Size() - offset) / sizeof(Staff) < count)
+        throw std::runtime_error("Read error: staff block is shorter than " + std::to_string(count) + " records");
 
-    std::cout << "==[2]===\n";
-    std::cout << m_staffs[2] << std::endl;
-    std::cout << "======\n";
+    m_staffs.resize(count);
+    {
+        CM_TIME_SCOPE("cm_load_phase_seconds", "phase=\"decode\"");
+        decode_staff_block(file.Slice(offset, count * sizeof(Staff)), m_staffs);
+    }
 
-    std::cout << "==[3]===\n";
-    std::cout << m_staffs[3] << std::endl;
-    std::cout << "======\n";
+    CM_TIME_SCOPE("cm_load_phase_seconds", "phase=\"index\"");
+    m_ids = IdIndex::Build(m_staffs, [](const Staff& staff){ return staff.id; });
 }
 
 std::optional<Staff> StaffRepository::GetById(int id) const 
 {
-    auto it = std::ranges::find_if(m_staffs, [&](const auto& staff){ return id == staff.id; });
-    if (it == m_staffs.end())
+    auto row = m_ids.Find(id);
+    if (!row.has_value())
         return std::nullopt;
 
-    std::cout << "Found at index: " << std::distance(m_staffs.begin(), it) << std::endl;
-    
-    return *it;
+    return m_staffs[*row];
 }
 
 std::optional<Staff> StaffRepository::GetByName(const std::string& name) const
@@ -78,14 +72,31 @@ std::optional<Staff> StaffRepository::GetByName(const std::string& name) const
 
 } 
 
-static std::string to_lower(std::string s) {
-    for (auto& ch : s) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-    return s;
+void StaffRepository::BuildNameIndex(const DisplayNameFn& displayName)
+{
+    m_nameIndex = TrigramIndex{};
+    for (size_t i = 0; i < m_staffs.size(); ++i) {
+        m_nameIndex.Add(static_cast<std::uint32_t>(i), displayName(m_staffs[i]));
+    }
+    m_nameIndex.Finalize();
+    m_searchCache.Clear();
 }
 
 std::optional<std::vector<Staff>> StaffRepository::SearchByName(const std::string& name) const
 {
+    std::vector<Staff> res; 
 
-    return std::nullopt;
+    const std::string key = TrigramIndex::fold(name);
+    auto rows = m_searchCache.GetOrCompute(key, [&]{ return m_nameIndex.Search(key); });
+
+    res.reserve(rows->size());
+    for (auto row : *rows) 
+    {
+        res.push_back(m_staffs[row]);
+    }
+
+    if (res.size() == 0) 
+        return std::nullopt;
 
+    return res;
 }
\ No newline at end of file
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "club.h"
+#include "first_name.h"
+#include "index.h"
+#include "non_player.h"
+#include "player.h"
+#include "second_name.h"
+#include "staff.h"
+#include "synthetic_database.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t INDEX_HEADER_BYTES = 8;
+
+// The preference block has no decoded struct yet; the loader only needs its
+// position and extent, so the generator fills it with fixed-size zero records.
+constexpr size_t PREFERENCE_RECORD_BYTES = 24;
+
+// Block types index.dat uses for the stand-alone tables. The loader looks
+// those files up by name only, so the values just need to be distinct.
+constexpr std::uint32_t CLUB_BLOCK = 1;
+constexpr std::uint32_t FIRST_NAME_BLOCK = 2;
+constexpr std::uint32_t SECOND_NAME_BLOCK = 3;
+constexpr std::uint32_t COMMON_NAME_BLOCK = 4;
+
+// mt19937_64 is fully specified by the standard, unlike the distributions,
+// so draws are done by hand to keep output identical across standard libraries.
+class Random {
+
+public:
+    explicit Random(std::uint64_t seed): m_engine(seed) {}
+
+    // Uniform in [lo, hi].
+    std::int64_t Between(std::int64_t lo, std::int64_t hi)
+    {
+        const auto span = static_cast<std::uint64_t>(hi - lo) + 1;
+        return lo + static_cast<std::int64_t>(m_engine() % span);
+    }
+
+    std::size_t Below(std::size_t n) { return static_cast<std::size_t>(m_engine() % n); }
+
+    bool Chance(double p) { return static_cast<double>(m_engine() >> 11) * 0x1.0p-53 < p; }
+
+private:
+    std::mt19937_64 m_engine;
+
+};
+
+size_t scaled(size_t count, double scale)
+{
+    return std::max<size_t>(1, static_cast<size_t>(std::llround(static_cast<double>(count) * scale)));
+}
+
+// Pronounceable Latin-1 names; a few syllables carry accents so the
+// case-folding and diacritic paths of the search code get exercised.
+std::string make_name(Random& rng, size_t minSyllables, size_t maxSyllables)
+{
+    static constexpr std::array<std::string_view, 32> SYLLABLES = {
+        "ma", "ro", "ba", "ti", "lo", "ne", "sa", "ku", "de", "vi", "an", "el",
+        "or", "ri", "ca", "mi", "to", "ga", "le", "nu", "so", "pe", "da", "fi",
+        "m\xFC", "j\xE9", "r\xF6", "\xE7o", "n\xE3", "l\xED", "s\xF8", "br"
+    };
+
+    std::string name;
+    const size_t count = static_cast<size_t>(rng.Between(static_cast<std::int64_t>(minSyllables),
+                                                          static_cast<std::int64_t>(maxSyllables)));
+    for (size_t i = 0; i < count; ++i)
+        name += SYLLABLES[rng.Below(SYLLABLES.size())];
+
+    // Latin-1 capitals sit exactly 0x20 below their lower-case letters.
+    const auto first = static_cast<unsigned char>(name[0]);
+    if ((first >= 'a' && first <= 'z') || first >= 0xE0)
+        name[0] = static_cast<char>(first - 0x20);
+    return name;
+}
+
+template <size_t N, typename Char>
+void copy_fixed(std::array<Char, N>& dst, std::string_view text)
+{
+    dst.fill(Char{});
+    std::memcpy(dst.data(), text.data(), std::min(text.size(), N - 1));
+}
+
+template <typename T>
+size_t write_records(std::ofstream& out, std::span<const T> records)
+{
+    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size_bytes()));
+    return records.size_bytes();
+}
+
+template <typename T>
+size_t write_table(const fs::path& path, std::span<const T> records)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to create: " + path.string());
+
+    const size_t bytes = write_records(out, records);
+    if (!out) throw std::runtime_error("Failed to write: " + path.string());
+    return bytes;
+}
+
+template <typename Names>
+std::vector<Names> make_names(Random& rng, size_t count, size_t nations, size_t minSyllables, size_t maxSyllables)
+{
+    std::vector<Names> names(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        copy_fixed(names[i].Name, make_name(rng, minSyllables, maxSyllables));
+        names[i].id = static_cast<std::int32_t>(i);
+        names[i].Nation = static_cast<std::int32_t>(rng.Below(nations));
+        names[i].Count = static_cast<std::int8_t>(rng.Between(1, 100));
+    }
+    return names;
+}
+
+CMDate make_date(std::int16_t day, std::int16_t year)
+{
+    const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return CMDate{ day, year, leap ? 1 : 0 };
+}
+
+CMDate no_date()
+{
+    return CMDate{ 0, 0, 0 };
+}
+
+Index make_index(std::string_view fileName, std::int32_t id, size_t count, size_t offset, std::uint32_t type)
+{
+    Index idx{};
+    copy_fixed(idx.file_name, fileName);
+    idx.id = id;
+    idx.table_size = static_cast<std::uint32_t>(count);
+    idx.offset = static_cast<std::uint32_t>(offset);
+    idx.version = type;
+    return idx;
+}
+
+Club make_club(Random& rng, size_t row, const SyntheticDatabaseOptions& options)
+{
+    Club club{};
+    const std::string town = make_name(rng, 2, 4);
+
+    club.id = static_cast<std::int32_t>(row);
+    copy_fixed(club.long_name, town + (rng.Chance(0.5) ? " Football Club" : " Athletic"));
+    copy_fixed(club.short_name, town);
+    club.nation_id = static_cast<std::int32_t>(rng.Below(options.nations));
+    club.division_id = static_cast<std::int32_t>(rng.Below(options.divisions));
+    club.last_division_id = club.division_id;
+    club.last_position = static_cast<std::uint8_t>(rng.Between(1, 24));
+    club.reserve_division_id = -1;
+    club.professional_status = static_cast<std::uint8_t>(rng.Between(0, 2));
+    club.bank_balance = static_cast<std::int32_t>(rng.Between(-5'000'000, 50'000'000));
+    club.stadium_id = static_cast<std::int32_t>(row);
+    club.owns_stadium = 1;
+    club.reserve_stadium_id = -1;
+    club.match_day = static_cast<std::uint8_t>(rng.Between(0, 6));
+    club.avg_attendance = static_cast<std::int32_t>(rng.Between(500, 60'000));
+    club.min_attendance = club.avg_attendance / 2;
+    club.max_attendance = club.avg_attendance * 3 / 2;
+    club.training_facilities = static_cast<std::uint8_t>(rng.Between(1, 20));
+    club.reputation = static_cast<std::int16_t>(rng.Between(1, 10'000));
+    club.home_shirt_fg = club.away_shirt_bg = static_cast<std::int32_t>(rng.Below(30));
+    club.home_shirt_bg = club.away_shirt_fg = static_cast<std::int32_t>(rng.Below(30));
+    club.third_shirt_fg = club.third_shirt_bg = -1;
+
+    club.liked_staff.fill(-1);
+    club.disliked_staff.fill(-1);
+    club.rival_clubs.fill(-1);
+    club.chairman_staff_id = -1;
+    club.directors.fill(-1);
+    club.manager_staff_id = -1;
+    club.assistant_manager_staff_id = -1;
+    club.playing_squad.fill(-1);
+    club.coaches.fill(-1);
+    club.scouts.fill(-1);
+    club.physios.fill(-1);
+    club.euro_flag = -1;
+    club.current_squad.fill(-1);
+    club.tactics.fill(-1);
+    club.current_tactics = -1;
+    return club;
+}
+
+template <size_t N>
+bool take_slot(std::array<std::int32_t, N>& slots, std::int32_t staffId)
+{
+    auto it = std::ranges::find(slots, -1);
+    if (it == slots.end()) return false;
+
+    *it = staffId;
+    return true;
+}
+
+// Puts a non-player in the first free back-room slot, most senior first.
+// Single-id slots are assigned by value: they sit unaligned in the packed record.
+bool place_non_player(Club& club, std::int32_t staffId)
+{
+    if (club.manager_staff_id == -1)
+        club.manager_staff_id = staffId;
+    else if (club.assistant_manager_staff_id == -1)
+        club.assistant_manager_staff_id = staffId;
+    else if (!take_slot(club.coaches, staffId) && !take_slot(club.physios, staffId) && !take_slot(club.scouts, staffId))
+    {
+        if (club.chairman_staff_id == -1)
+            club.chairman_staff_id = staffId;
+        else
+            return take_slot(club.directors, staffId);
+    }
+    return true;
+}
+
+std::uint8_t attribute(Random& rng)
+{
+    return static_cast<std::uint8_t>(rng.Between(1, 20));
+}
+
+Staff make_staff(Random& rng, size_t row, const SyntheticDatabaseOptions& options, size_t firstNames, size_t secondNames, size_t commonNames)
+{
+    Staff s{};
+    const auto year = static_cast<std::int16_t>(rng.Between(1950, 1985));
+
+    s.id = static_cast<std::int32_t>(row);
+    s.FirstName = static_cast<std::int32_t>(rng.Below(firstNames));
+    s.SecondName = static_cast<std::int32_t>(rng.Below(secondNames));
+    s.CommonName = rng.Chance(0.02) ? static_cast<std::int32_t>(rng.Below(commonNames)) : -1;
+    s.DateOfBirth = make_date(static_cast<std::int16_t>(rng.Between(0, 364)), year);
+    s.YearOfBirth = static_cast<std::uint16_t>(year);
+    s.Nation = static_cast<std::int32_t>(rng.Below(options.nations));
+    s.SecondNation = rng.Chance(0.1) ? static_cast<std::int32_t>(rng.Below(options.nations)) : -1;
+    s.IntApps = static_cast<std::uint8_t>(rng.Chance(0.2) ? rng.Between(1, 120) : 0);
+    s.IntGoals = static_cast<std::uint8_t>(s.IntApps == 0 ? 0 : rng.Between(0, s.IntApps / 2));
+    s.NationalJob = -1;
+    s.DateJoinedNation = no_date();
+    s.DateExpiresNation = no_date();
+    s.ClubJob = -1;
+    s.DateJoinedClub = no_date();
+    s.DateExpiresClub = no_date();
+    s.Wage = static_cast<std::int32_t>(rng.Between(100, 80'000));
+    s.Value = static_cast<std::int32_t>(rng.Between(0, 40'000'000));
+    s.Adaptability = attribute(rng);
+    s.Ambition = attribute(rng);
+    s.Determination = attribute(rng);
+    s.Loyality = attribute(rng);
+    s.Pressure = attribute(rng);
+    s.Professionalism = attribute(rng);
+    s.Sportsmanship = attribute(rng);
+    s.Temperament = attribute(rng);
+    s.Player = -1;
+    s.StaffPreferences = -1;
+    s.NonPlayer = -1;
+    return s;
+}
+
+Player make_player(Random& rng, size_t row)
+{
+    Player p{};
+    p.id = static_cast<std::int32_t>(row);
+    p.SquadNumber = static_cast<std::uint8_t>(rng.Between(1, 40));
+    p.CurrentAbility = static_cast<std::int16_t>(rng.Between(1, 190));
+    p.PotentialAbility = static_cast<std::int16_t>(std::min<std::int64_t>(200, p.CurrentAbility + rng.Between(0, 60)));
+    p.HomeReputation = static_cast<std::uint16_t>(rng.Between(1, 10'000));
+    p.CurrentReputation = static_cast<std::uint16_t>(rng.Between(1, p.HomeReputation));
+    p.WorldReputation = static_cast<std::uint16_t>(rng.Between(1, p.CurrentReputation));
+
+    // Goalkeeper..WorkRate are contiguous one-byte fields.
+    std::array<std::uint8_t, offsetof(Player, WorkRate) - offsetof(Player, Goalkeeper) + 1> attributes;
+    for (auto& a : attributes) a = attribute(rng);
+    std::memcpy(reinterpret_cast<std::byte*>(&p) + offsetof(Player, Goalkeeper), attributes.data(), attributes.size());
+
+    p.PlayerMorale = static_cast<std::uint8_t>(rng.Between(1, 20));
+    return p;
+}
+
+NonPlayer make_non_player(Random& rng, size_t row)
+{
+    NonPlayer n{};
+    n.id = static_cast<std::int32_t>(row);
+    n.CurrentAbility = static_cast<std::int16_t>(rng.Between(1, 190));
+    n.PotentialAbility = static_cast<std::int16_t>(std::min<std::int64_t>(200, n.CurrentAbility + rng.Between(0, 40)));
+    n.HomeReputation = static_cast<std::int16_t>(rng.Between(1, 10'000));
+    n.CurrentReputation = static_cast<std::int16_t>(rng.Between(1, n.HomeReputation));
+    n.WorldReputation = static_cast<std::int16_t>(rng.Between(1, n.CurrentReputation));
+
+    // Attacking..Youngsters are one byte each, Goalkeeper..WingBack four; both runs are contiguous.
+    std::array<std::uint8_t, offsetof(NonPlayer, Youngsters) - offsetof(NonPlayer, Attacking) + 1> attributes;
+    for (auto& a : attributes) a = attribute(rng);
+    std::memcpy(reinterpret_cast<std::byte*>(&n) + offsetof(NonPlayer, Attacking), attributes.data(), attributes.size());
+
+    std::array<std::int32_t, (offsetof(NonPlayer, WingBack) - offsetof(NonPlayer, Goalkeeper)) / sizeof(std::int32_t) + 1> positions;
+    for (auto& a : positions) a = attribute(rng);
+    std::memcpy(reinterpret_cast<std::byte*>(&n) + offsetof(NonPlayer, Goalkeeper), positions.data(), sizeof(positions));
+
+    n.FormationPreferred = static_cast<std::uint8_t>(rng.Between(0, 10));
+    return n;
+}
+
+} // namespace
+
+SyntheticDatabaseSummary write_synthetic_database(const fs::path& dir, const SyntheticDatabaseOptions& options)
+{
+    // Records are written straight from the packed structs.
+    if constexpr (std::endian::native != std::endian::little)
+        throw std::runtime_error("write_synthetic_database requires a little-endian host");
+
+    fs::create_directories(dir);
+
+    Random rng(options.seed);
+    SyntheticDatabaseSummary summary;
+
+    const size_t clubCount   = scaled(options.clubs, options.scale);
+    const size_t staffCount  = scaled(options.staffs, options.scale);
+    const size_t playerCount = std::min(staffCount, scaled(options.staffs, options.scale * options.playerShare));
+    const size_t nonPlayerCount = std::min(staffCount - playerCount,
+                                           scaled(options.staffs, options.scale * options.nonPlayerShare));
+
+    const auto firstNames  = make_names<FirstName>(rng, scaled(options.firstNames, options.scale), options.nations, 2, 3);
+    const auto secondNames = make_names<SecondName>(rng, scaled(options.secondNames, options.scale), options.nations, 2, 4);
+    const auto commonNames = make_names<SecondName>(rng, scaled(options.commonNames, options.scale), options.nations, 3, 4);
+
+    std::vector<Club> clubs;
+    clubs.reserve(clubCount);
+    for (size_t i = 0; i < clubCount; ++i)
+        clubs.push_back(make_club(rng, i, options));
+
+    // Staff rows [0, players) play, the next nonPlayerCount rows are back-room
+    // staff and the remainder have neither record, as in the real file.
+    std::vector<Staff> staffs;
+    std::vector<Player> players;
+    std::vector<NonPlayer> nonPlayers;
+    staffs.reserve(staffCount);
+    players.reserve(playerCount);
+    nonPlayers.reserve(nonPlayerCount);
+
+    for (size_t i = 0; i < staffCount; ++i)
+    {
+        Staff s = make_staff(rng, i, options, firstNames.size(), secondNames.size(), commonNames.size());
+        const bool isPlayer = i < playerCount;
+        const bool isNonPlayer = !isPlayer && i < playerCount + nonPlayerCount;
+
+        if (isPlayer)
+        {
+            s.Player = static_cast<std::int32_t>(players.size());
+            players.push_back(make_player(rng, players.size()));
+        }
+        else if (isNonPlayer)
+        {
+            s.NonPlayer = static_cast<std::int32_t>(nonPlayers.size());
+            nonPlayers.push_back(make_non_player(rng, nonPlayers.size()));
+        }
+
+        if ((isPlayer || isNonPlayer) && rng.Chance(options.employedShare))
+        {
+            Club& club = clubs[rng.Below(clubs.size())];
+            const bool placed = isPlayer ? take_slot(club.playing_squad, s.id) : place_non_player(club, s.id);
+            if (placed)
+            {
+                s.ClubJob = club.id;
+                s.JobForClub = static_cast<std::uint8_t>(isPlayer ? 1 : 2);
+                s.DateJoinedClub = make_date(static_cast<std::int16_t>(rng.Between(0, 364)),
+                                             static_cast<std::int16_t>(rng.Between(1995, 2001)));
+                s.DateExpiresClub = make_date(s.DateJoinedClub.Day,
+                                              static_cast<std::int16_t>(s.DateJoinedClub.Year + rng.Between(1, 5)));
+                if (isPlayer) take_slot(club.current_squad, s.id);
+            }
+        }
+
+        staffs.push_back(s);
+    }
+
+    std::vector<std::byte> preferences(staffCount / 4 * PREFERENCE_RECORD_BYTES);
+
+    const size_t nonPlayerOffset  = staffs.size() * sizeof(Staff);
+    const size_t playerOffset     = nonPlayerOffset + nonPlayers.size() * sizeof(NonPlayer);
+    const size_t preferenceOffset = playerOffset + players.size() * sizeof(Player);
+
+    summary.bytes += write_table<Club>(dir / "club.dat", clubs);
+    summary.bytes += write_table<FirstName>(dir / "first_names.dat", firstNames);
+    summary.bytes += write_table<SecondName>(dir / "second_names.dat", secondNames);
+    summary.bytes += write_table<SecondName>(dir / "common_names.dat", commonNames);
+
+    {
+        const fs::path path = dir / "staff.dat";
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Failed to create: " + path.string());
+
+        summary.bytes += write_records<Staff>(out, staffs);
+        summary.bytes += write_records<NonPlayer>(out, nonPlayers);
+        summary.bytes += write_records<Player>(out, players);
+        summary.bytes += write_records<std::byte>(out, preferences);
+        if (!out) throw std::runtime_error("Failed to write: " + path.string());
+    }
+
+    const std::vector<Index> entries = {
+        make_index("club.dat", 0, clubs.size(), 0, CLUB_BLOCK),
+        make_index("first_names.dat", 1, firstNames.size(), 0, FIRST_NAME_BLOCK),
+        make_index("second_names.dat", 2, secondNames.size(), 0, SECOND_NAME_BLOCK),
+        make_index("common_names.dat", 3, commonNames.size(), 0, COMMON_NAME_BLOCK),
+        make_index("staff.dat", 4, staffs.size(), 0, static_cast<std::uint32_t>(StaffBlock::People)),
+        make_index("staff.dat", 5, nonPlayers.size(), nonPlayerOffset, static_cast<std::uint32_t>(StaffBlock::NonPlayers)),
+        make_index("staff.dat", 6, players.size(), playerOffset, static_cast<std::uint32_t>(StaffBlock::Players)),
+        make_index("staff.dat", 7, preferences.size() / PREFERENCE_RECORD_BYTES, preferenceOffset,
+                   static_cast<std::uint32_t>(StaffBlock::Preferences)),
+    };
+
+    {
+        const fs::path path = dir / "index.dat";
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Failed to create: " + path.string());
+
+        const std::array<char, INDEX_HEADER_BYTES> header{};
+        out.write(header.data(), header.size());
+        summary.bytes += header.size() + write_records<Index>(out, entries);
+        if (!out) throw std::runtime_error("Failed to write: " + path.string());
+    }
+
+    summary.clubs = clubs.size();
+    summary.staffs = staffs.size();
+    summary.players = players.size();
+    summary.nonPlayers = nonPlayers.size();
+    return summary;
+}
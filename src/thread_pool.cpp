@@ -0,0 +1,42 @@
+#include <algorithm>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    m_workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        m_workers.emplace_back([this]{ WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for (auto& worker : m_workers) worker.join();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;)
+    {
+        std::move_only_function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || !m_tasks.empty(); });
+
+            // Drain the queue before exiting so every returned future gets a value.
+            if (m_tasks.empty()) return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
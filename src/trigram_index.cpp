@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "metrics.h"
+#include "trigram_index.h"
+
+unsigned char TrigramIndex::fold_case(unsigned char ch)
+{
+    if (ch >= 'A' && ch <= 'Z') return static_cast<unsigned char>(ch + ('a' - 'A'));
+
+    // Latin-1 / Windows-1252 upper-case letters (the name tables' encoding), except the multiplication sign.
+    if (ch >= 0xC0 && ch <= 0xDE && ch != 0xD7) return static_cast<unsigned char>(ch + 0x20);
+
+    return ch;
+}
+
+std::string TrigramIndex::fold(std::string_view text)
+{
+    std::string res(text);
+    for (auto& ch : res) ch = static_cast<char>(fold_case(static_cast<unsigned char>(ch)));
+    return res;
+}
+
+std::uint32_t TrigramIndex::key_of(const char* p)
+{
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(p[0])) << 16)
+         | (static_cast<std::uint32_t>(static_cast<unsigned char>(p[1])) << 8)
+         |  static_cast<std::uint32_t>(static_cast<unsigned char>(p[2]));
+}
+
+void TrigramIndex::Add(std::uint32_t doc, std::string_view text)
+{
+    const auto len = text.find('\0');
+    if (len != std::string_view::npos) text = text.substr(0, len);
+    if (text.empty()) return;
+
+    if (m_arena.size() + text.size() > UINT32_MAX) throw std::runtime_error("TrigramIndex arena overflow.");
+
+    Text entry{ doc, static_cast<std::uint32_t>(m_arena.size()), static_cast<std::uint32_t>(text.size()) };
+    for (unsigned char ch : text) m_arena.push_back(static_cast<char>(fold_case(ch)));
+
+    m_texts.push_back(entry);
+}
+
+void TrigramIndex::Finalize()
+{
+    std::ranges::stable_sort(m_texts, {}, &Text::doc);
+
+    m_docs.clear();
+    for (const auto& text : m_texts)
+        if (m_docs.empty() || m_docs.back() != text.doc) m_docs.push_back(text.doc);
+    m_docCount = m_docs.size();
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs; // (trigram, doc)
+    for (const auto& text : m_texts)
+    {
+        const char* p = m_arena.data() + text.offset;
+        for (std::uint32_t i = 0; i + 3 <= text.length; ++i)
+            pairs.emplace_back(key_of(p + i), text.doc);
+    }
+
+    std::ranges::sort(pairs);
+    const auto dup = std::ranges::unique(pairs);
+    pairs.erase(dup.begin(), dup.end());
+
+    m_keys.clear();
+    m_offsets.clear();
+    m_postings.clear();
+    m_postings.reserve(pairs.size());
+    for (const auto& [key, doc] : pairs)
+    {
+        if (m_keys.empty() || m_keys.back() != key)
+        {
+            m_keys.push_back(key);
+            m_offsets.push_back(static_cast<std::uint32_t>(m_postings.size()));
+        }
+        m_postings.push_back(doc);
+    }
+    m_offsets.push_back(static_cast<std::uint32_t>(m_postings.size()));
+}
+
+bool TrigramIndex::TextsContain(std::uint32_t doc, std::string_view folded) const
+{
+    auto it = std::ranges::lower_bound(m_texts, doc, {}, &Text::doc);
+    for (; it != m_texts.end() && it->doc == doc; ++it)
+    {
+        std::string_view text(m_arena.data() + it->offset, it->length);
+        if (text.find(folded) != std::string_view::npos) return true;
+    }
+    return false;
+}
+
+std::vector<std::uint32_t> TrigramIndex::Search(std::string_view needle) const
+{
+    CM_TIME_SCOPE("cm_query_seconds", "type=\"trigram_search\"");
+
+    const std::string folded = fold(needle);
+
+    if (folded.empty()) return m_docs;
+
+    // Too short to have a trigram: verify every document, still without rebuilding any string.
+    if (folded.size() < 3)
+    {
+        std::vector<std::uint32_t> res;
+        for (auto doc : m_docs)
+            if (TextsContain(doc, folded)) res.push_back(doc);
+        return res;
+    }
+
+    std::vector<std::pair<const std::uint32_t*, const std::uint32_t*>> lists;
+    for (std::size_t i = 0; i + 3 <= folded.size(); ++i)
+    {
+        const auto key = key_of(folded.data() + i);
+        auto it = std::ranges::lower_bound(m_keys, key);
+        if (it == m_keys.end() || *it != key) return {};
+
+        const auto k = static_cast<std::size_t>(it - m_keys.begin());
+        lists.emplace_back(m_postings.data() + m_offsets[k], m_postings.data() + m_offsets[k + 1]);
+    }
+
+    // Intersect from the shortest list so the working set only shrinks.
+    std::ranges::sort(lists, {}, [](const auto& l){ return l.second - l.first; });
+    const auto dup = std::ranges::unique(lists);
+    lists.erase(dup.begin(), dup.end());
+
+    std::vector<std::uint32_t> candidates(lists.front().first, lists.front().second);
+    std::vector<std::uint32_t> scratch;
+    for (std::size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+    {
+        scratch.clear();
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              lists[i].first, lists[i].second, std::back_inserter(scratch));
+        candidates.swap(scratch);
+    }
+
+    // Trigrams match regardless of their order, so confirm the actual substring.
+    std::erase_if(candidates, [&](std::uint32_t doc){ return !TextsContain(doc, folded); });
+    return candidates;
+}